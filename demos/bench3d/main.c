@@ -0,0 +1,154 @@
+#include "framebuffer.h"
+#include "mat4.h"
+#include "miniboy_engine.h"
+#include "render3d.h"
+#include <stdio.h>
+
+// Scene: BENCH_TORI Gouraud tori (256 triangles each) orbited by as many
+// flat-shaded cubes (12 triangles each)
+#define BENCH_TORI 6
+#define TORUS_MAJOR 16
+#define TORUS_MINOR 8
+#define TORUS_VERTS (TORUS_MAJOR * TORUS_MINOR)
+#define TORUS_TRIS (TORUS_VERTS * 2)
+#define MAX_TRIS (BENCH_TORI * (TORUS_TRIS + 12))
+
+// Stats over USB every this many frames
+#define BENCH_REPORT_FRAMES 60
+
+static vec3_t torus_verts[TORUS_VERTS];
+static vec3_t torus_normals[TORUS_VERTS];
+static uint16_t torus_indices[TORUS_TRIS * 3];
+static mesh_t torus;
+
+static const vec3_t cube_verts[8] = {
+    {-FX16_HALF, -FX16_HALF, -FX16_HALF}, {FX16_HALF, -FX16_HALF, -FX16_HALF},
+    {FX16_HALF, FX16_HALF, -FX16_HALF},   {-FX16_HALF, FX16_HALF, -FX16_HALF},
+    {-FX16_HALF, -FX16_HALF, FX16_HALF},  {FX16_HALF, -FX16_HALF, FX16_HALF},
+    {FX16_HALF, FX16_HALF, FX16_HALF},    {-FX16_HALF, FX16_HALF, FX16_HALF}};
+// Clockwise on screen seen from outside (render3d's front faces)
+static const uint16_t cube_indices[12 * 3] = {
+    0, 2, 3, 0, 1, 2, // -z
+    4, 6, 5, 4, 7, 6, // +z
+    0, 7, 4, 0, 3, 7, // -x
+    1, 6, 2, 1, 5, 6, // +x
+    0, 5, 1, 0, 4, 5, // -y
+    3, 6, 7, 3, 2, 6  // +y
+};
+static const uint16_t cube_colors[12] = {0xF800, 0xF800, 0x07E0, 0x07E0,
+                                         0x001F, 0x001F, 0xFFE0, 0xFFE0,
+                                         0xF81F, 0xF81F, 0x07FF, 0x07FF};
+static const mesh_t cube = {.vertices = cube_verts,
+                            .indices = cube_indices,
+                            .colors = cube_colors,
+                            .vertex_count = 8,
+                            .tri_count = 12};
+
+static r3d_t r3d;
+static fx_angle_t spin;
+static uint32_t frames;
+static r3d_stats_t totals;
+
+// Ring of radius 1 around y, tube radius 0.4
+static void build_torus(void) {
+  const fx16_t R = FX16_ONE, r = FX16_CONST(0.4);
+  for (int i = 0; i < TORUS_MAJOR; i++) {
+    fx_angle_t u = (fx_angle_t)(i * 65536 / TORUS_MAJOR);
+    for (int j = 0; j < TORUS_MINOR; j++) {
+      fx_angle_t v = (fx_angle_t)(j * 65536 / TORUS_MINOR);
+      fx16_t ring = R + fx16_mul(r, fx_cos(v));
+      int k = i * TORUS_MINOR + j;
+      torus_verts[k] = vec3(fx16_mul(ring, fx_cos(u)), fx16_mul(r, fx_sin(v)),
+                            fx16_mul(ring, fx_sin(u)));
+      torus_normals[k] = vec3(fx16_mul(fx_cos(v), fx_cos(u)), fx_sin(v),
+                              fx16_mul(fx_cos(v), fx_sin(u)));
+
+      int i1 = (i + 1) % TORUS_MAJOR, j1 = (j + 1) % TORUS_MINOR;
+      uint16_t a = k, b = i1 * TORUS_MINOR + j;
+      uint16_t c = i1 * TORUS_MINOR + j1, d = i * TORUS_MINOR + j1;
+      uint16_t *t = &torus_indices[k * 6];
+      t[0] = a, t[1] = b, t[2] = c;
+      t[3] = a, t[4] = c, t[5] = d;
+    }
+  }
+  torus = (mesh_t){.vertices = torus_verts,
+                   .normals = torus_normals,
+                   .indices = torus_indices,
+                   .vertex_count = TORUS_VERTS,
+                   .tri_count = TORUS_TRIS,
+                   .color = 0xFD20};
+}
+
+void bench_init(void) {
+  build_torus();
+  if (!r3d_init(&r3d, MAX_TRIS, TORUS_VERTS))
+    printf("BENCH3D: r3d_init failed\n");
+  r3d.view = mat4_translation(0, 0, FX16_CONST(7));
+  r3d_set_fov(&r3d, FX_ANGLE_DEG(70), 320);
+}
+
+void bench_update(uint32_t dt_us) { spin += 300; }
+
+void bench_draw(surface_t *surf) {
+  framebuffer_clear(0x0000);
+  r3d_begin(&r3d, surf);
+
+  for (int i = 0; i < BENCH_TORI; i++) {
+    // Tori on a 3-wide grid, each tilted and spinning at its own phase
+    fx16_t x = fx16_from_int((i % 3) * 3 - 3);
+    fx16_t y = fx16_from_int((i / 3) * 3) - FX16_CONST(1.5);
+    fx_angle_t phase = (fx_angle_t)(spin + i * 8000);
+    mat4_t rx = mat4_rotation_x(phase), ry = mat4_rotation_y(phase * 2);
+    mat4_t rot = mat4_mul(&rx, &ry);
+    mat4_t pos = mat4_translation(x, y, 0);
+    mat4_t model = mat4_mul(&pos, &rot);
+    r3d_draw_mesh(&r3d, &torus, &model, R3D_SHADE_GOURAUD);
+
+    // Cube orbiting its torus
+    mat4_t orbit = mat4_rotation_y((fx_angle_t)(-phase * 3));
+    mat4_t out = mat4_translation(FX16_CONST(1.6), 0, 0);
+    mat4_t spin_cube = mat4_rotation_z(phase * 4);
+    mat4_t m = mat4_mul(&orbit, &out);
+    m = mat4_mul(&m, &spin_cube);
+    model = mat4_mul(&pos, &m);
+    r3d_draw_mesh(&r3d, &cube, &model, R3D_SHADE_FLAT);
+  }
+
+  r3d_end(&r3d);
+
+  totals.tris_in += r3d.stats.tris_in;
+  totals.tris_drawn += r3d.stats.tris_drawn;
+  totals.vertex_us += r3d.stats.vertex_us;
+  totals.raster_us += r3d.stats.raster_us;
+  if (++frames == BENCH_REPORT_FRAMES) {
+    printf("BENCH3D: %lu tris/frame submitted, %lu drawn, vertex %lu us, "
+           "raster %lu us\n",
+           (unsigned long)(totals.tris_in / frames),
+           (unsigned long)(totals.tris_drawn / frames),
+           (unsigned long)(totals.vertex_us / frames),
+           (unsigned long)(totals.raster_us / frames));
+    frames = 0;
+    totals = (r3d_stats_t){0};
+  }
+}
+
+const miniapp_desc_t bench3d_app = {.name = "3D Benchmark",
+                                    .init = bench_init,
+                                    .update = bench_update,
+                                    .draw = bench_draw};
+
+int main() {
+  engine_config_t cfg = {
+      .width = 320,
+      .height = 240,
+      .pixel_format = PIXEL_FORMAT_RGB565,
+      .performance_profile = PROFILE_HIGH,
+      .buffer_count = 2,
+      .app_bytes = r3d_get_arena_size(MAX_TRIS, TORUS_VERTS)};
+
+  if (engine_init(&cfg)) {
+    engine_run(&bench3d_app);
+  }
+
+  return 0;
+}
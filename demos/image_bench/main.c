@@ -0,0 +1,114 @@
+#include "arena.h"
+#include "cimage.h"
+#include "framebuffer.h"
+#include "hardware/regs/addressmap.h"
+#include "miniboy_engine.h"
+#include "xip_stream.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Decode speed of a compressed full-screen image against raw copies of the
+// same byte count: memcpy from flash through the XIP cache, and the XIP
+// streaming DMA (cache bypass). The test scene is drawn once on the device
+// and compressed with cimage_encode, so it decodes from RAM; an image
+// packed by tools/cimage_pack.py would decode from flash instead.
+#define BENCH_WIDTH 320
+#define BENCH_HEIGHT 240
+#define BENCH_FORMAT PIXEL_FORMAT_RGB444
+#define BENCH_IMAGE_BYTES (48 * 1024)
+
+// Stats over USB every this many frames
+#define BENCH_REPORT_FRAMES 60
+
+static uint8_t *image_buf;
+static const cimage_t *image;
+static uint32_t image_bytes;
+static uint32_t frames;
+static uint32_t memcpy_us, stream_us, decode_us;
+
+// Sky gradient, sun, checkered ground and a block of noise (the worst case)
+static void draw_scene(surface_t *surf) {
+  for (int y = 0; y < 170; y++) {
+    uint16_t r = 5 + y / 16, g = 10 + y / 8, b = 25 - y / 16;
+    draw_rect(surf, 0, y, BENCH_WIDTH, 1, (r << 11) | (g << 5) | b);
+  }
+  draw_circle(surf, 240, 60, 30, 0xFEE7);
+  for (int y = 170; y < BENCH_HEIGHT; y += 16)
+    for (int x = 0; x < BENCH_WIDTH; x += 16)
+      draw_rect(surf, x, y, 16, 16,
+                ((x + y) / 16) & 1 ? 0x3C66 : 0x4D07);
+  for (int y = 100; y < 160; y++)
+    for (int x = 20; x < 120; x++)
+      draw_pixel(surf, x, y, (uint16_t)rand());
+}
+
+void bench_init(void) {
+  image_buf = (uint8_t *)arena_alloc(ARENA_TAG_APP, BENCH_IMAGE_BYTES, 4);
+  if (!image_buf)
+    printf("IMGBENCH: no arena for the image\n");
+}
+
+void bench_update(uint32_t dt_us) {}
+
+void bench_draw(surface_t *surf) {
+  if (!image_buf)
+    return;
+  if (!image) {
+    draw_scene(surf);
+    image_bytes = cimage_encode(surf, 0, 0, BENCH_WIDTH, BENCH_HEIGHT,
+                                image_buf, BENCH_IMAGE_BYTES);
+    image = image_bytes ? cimage_map(image_buf) : NULL;
+    if (!image) {
+      printf("IMGBENCH: scene does not fit in %d bytes\n", BENCH_IMAGE_BYTES);
+      image_buf = NULL;
+    }
+    return;
+  }
+
+  // Raw baselines (flash contents; the decode overwrites them)
+  uint32_t t0 = time_us_32();
+  memcpy(surf->pixels, (const void *)XIP_BASE, surf->size);
+  uint32_t t1 = time_us_32();
+  xip_stream_wait_job(
+      xip_stream_copy(surf->pixels, (const void *)XIP_BASE, surf->size & ~3u,
+                      NULL, NULL));
+  uint32_t t2 = time_us_32();
+  cimage_draw(surf, 0, 0, image);
+  uint32_t t3 = time_us_32();
+
+  memcpy_us += t1 - t0;
+  stream_us += t2 - t1;
+  decode_us += t3 - t2;
+  if (++frames == BENCH_REPORT_FRAMES) {
+    printf("IMGBENCH: %lu -> %lu bytes (%lu%%), memcpy %lu us, "
+           "xip stream %lu us, decode %lu us\n",
+           (unsigned long)surf->size, (unsigned long)image_bytes,
+           (unsigned long)(image_bytes * 100 / surf->size),
+           (unsigned long)(memcpy_us / frames),
+           (unsigned long)(stream_us / frames),
+           (unsigned long)(decode_us / frames));
+    frames = 0;
+    memcpy_us = stream_us = decode_us = 0;
+  }
+}
+
+const miniapp_desc_t image_bench_app = {.name = "Image Benchmark",
+                                        .init = bench_init,
+                                        .update = bench_update,
+                                        .draw = bench_draw};
+
+int main() {
+  engine_config_t cfg = {.width = BENCH_WIDTH,
+                         .height = BENCH_HEIGHT,
+                         .pixel_format = BENCH_FORMAT,
+                         .performance_profile = PROFILE_HIGH,
+                         .buffer_count = 1,
+                         .app_bytes = arena_reserve_size(BENCH_IMAGE_BYTES, 4)};
+
+  if (engine_init(&cfg)) {
+    engine_run(&image_bench_app);
+  }
+
+  return 0;
+}
@@ -1,17 +1,33 @@
+#include "fixed.h"
 #include "framebuffer.h"
 #include "miniboy_engine.h"
+#include "particles.h"
+#include "spatial_hash.h"
+#include "subpixel.h"
 #include <stdio.h>
 #include <stdlib.h>
-#include <math.h>
 
 #define NUM_BALLS 30
 #define NUM_LINES 20
 #define NUM_RECTS 20
 
+// Interlaced present: half the rows on the wire per frame (compare FPS)
+#define STRESS_INTERLACED 0
+// 16-bit surface, 12-bit wire (PIO packs RGB565 to RGB444 while shifting)
+#define STRESS_WIRE_RGB444 0
+// Particle fountain on top of the scene: live particle capacity (0 = off)
+#define STRESS_PARTICLES 0
+// Ball-ball collisions through the spatial hash broadphase
+#define STRESS_COLLISIONS 0
+// Pipelined mode: balls and rects update on Core 1 while Core 0 draws the
+// previous frame (compare FPS against the serial loop)
+#define STRESS_PIPELINED 0
+
+// Positions and velocities are 16.16 fixed point (pixels, pixels/frame)
 typedef struct {
-    float x, y;
-    float vx, vy;
-    int radius;
+    fx16_t x, y;
+    fx16_t vx, vy;
+    fx16_t radius;
     uint16_t color;
 } Ball;
 
@@ -22,14 +38,48 @@ typedef struct {
 } Line;
 
 typedef struct {
-    float x, y;
-    float vx, vy;
-    int w, h;
+    fx16_t x, y;
+    fx16_t vx, vy;
+    fx16_t w, h;
     uint16_t color;
 } RectObj;
 
-static Ball balls[NUM_BALLS];
-static RectObj rects[NUM_RECTS];
+// Everything the update advances (one copy per pipeline stage)
+typedef struct {
+    Ball balls[NUM_BALLS];
+    RectObj rects[NUM_RECTS];
+} StressState;
+
+static StressState scene; // Serial mode's state, pipelined mode's initial one
+
+#if STRESS_COLLISIONS
+static spatial_hash_t ball_hash;
+
+// Overlapping circles that are closing in swap velocities (equal masses)
+static void collide_balls(uint16_t a, uint16_t b, void *arg) {
+    Ball *balls = (Ball *)arg;
+    Ball *p = &balls[a], *q = &balls[b];
+    int32_t dx = (q->x - p->x) >> 12, dy = (q->y - p->y) >> 12; // 4 frac bits
+    int32_t r = (p->radius + q->radius) >> 12;
+    if (dx * dx + dy * dy >= r * r)
+        return;
+    int32_t closing = ((q->vx - p->vx) >> 12) * dx + ((q->vy - p->vy) >> 12) * dy;
+    if (closing >= 0)
+        return;
+    fx16_t t = p->vx; p->vx = q->vx; q->vx = t;
+    t = p->vy; p->vy = q->vy; q->vy = t;
+}
+#endif
+
+#if STRESS_PARTICLES
+static particle_system_t particles;
+static const particle_emitter_t fountain = {
+    .x = FX16_CONST(160), .y = FX16_CONST(235), .jitter = FX16_CONST(4),
+    .angle = FX_ANGLE_DEG(270), .spread = FX_ANGLE_DEG(40),
+    .speed_min = FX16_CONST(3), .speed_max = FX16_CONST(6),
+    .life_min = 60, .life_max = 120, .color = 0xFFE0
+};
+#endif
 
 // Simple random generator for range
 int rand_range(int min, int max) {
@@ -40,34 +90,52 @@ uint16_t rand_color() {
     return rand() % 0xFFFF;
 }
 
+// Random speed in (-max, max) pixels/frame with a 1/256 pixel step
+fx16_t rand_speed(int max) {
+    fx16_t v = (rand() % (2 * max * 256 - 1) - (max * 256 - 1)) * 256;
+    return v ? v : FX16_ONE / 4;
+}
+
 void game_init(void) {
+    Ball *balls = scene.balls;
+    RectObj *rects = scene.rects;
     srand(12345); // Fixed seed for reproducibility
 
     // Init Balls
     for (int i = 0; i < NUM_BALLS; i++) {
-        balls[i].x = rand_range(20, 300);
-        balls[i].y = rand_range(20, 220);
-        balls[i].vx = (rand() % 10 - 5);
-        if (balls[i].vx == 0) balls[i].vx = 1;
-        balls[i].vy = (rand() % 10 - 5);
-        if (balls[i].vy == 0) balls[i].vy = 1;
-        balls[i].radius = rand_range(5, 15);
+        balls[i].x = fx16_from_int(rand_range(20, 300));
+        balls[i].y = fx16_from_int(rand_range(20, 220));
+        balls[i].vx = rand_speed(5);
+        balls[i].vy = rand_speed(5);
+        balls[i].radius = fx16_from_int(rand_range(5, 15));
         balls[i].color = rand_color();
     }
 
     // Init Rects
     for (int i = 0; i < NUM_RECTS; i++) {
-        rects[i].x = rand_range(10, 280);
-        rects[i].y = rand_range(10, 200);
-        rects[i].w = rand_range(10, 50);
-        rects[i].h = rand_range(10, 50);
-        rects[i].vx = (rand() % 6 - 3);
-        rects[i].vy = (rand() % 6 - 3);
+        rects[i].x = fx16_from_int(rand_range(10, 280));
+        rects[i].y = fx16_from_int(rand_range(10, 200));
+        rects[i].w = fx16_from_int(rand_range(10, 50));
+        rects[i].h = fx16_from_int(rand_range(10, 50));
+        rects[i].vx = rand_speed(3);
+        rects[i].vy = rand_speed(3);
         rects[i].color = rand_color();
     }
+
+#if STRESS_COLLISIONS
+    spatial_hash_init(&ball_hash, 320, 240, SPATIAL_HASH_CELL_SHIFT, NUM_BALLS);
+#endif
+#if STRESS_PARTICLES
+    if (particles_init(&particles, STRESS_PARTICLES))
+        particles.gravity_y = FX16_CONST(0.1);
+#endif
 }
 
-void game_update(uint32_t dt_us) {
+static void update_scene(StressState *s) {
+    const fx16_t W = fx16_from_int(320), H = fx16_from_int(240);
+    Ball *balls = s->balls;
+    RectObj *rects = s->rects;
+
     // Update Balls
     for (int i = 0; i < NUM_BALLS; i++) {
         balls[i].x += balls[i].vx;
@@ -77,73 +145,114 @@ void game_update(uint32_t dt_us) {
         if (balls[i].x - balls[i].radius < 0) {
             balls[i].x = balls[i].radius;
             balls[i].vx = -balls[i].vx;
-        } else if (balls[i].x + balls[i].radius >= 320) {
-            balls[i].x = 320 - balls[i].radius - 1;
+        } else if (balls[i].x + balls[i].radius >= W) {
+            balls[i].x = W - balls[i].radius - FX16_ONE;
             balls[i].vx = -balls[i].vx;
         }
 
         if (balls[i].y - balls[i].radius < 0) {
             balls[i].y = balls[i].radius;
             balls[i].vy = -balls[i].vy;
-        } else if (balls[i].y + balls[i].radius >= 240) {
-            balls[i].y = 240 - balls[i].radius - 1;
+        } else if (balls[i].y + balls[i].radius >= H) {
+            balls[i].y = H - balls[i].radius - FX16_ONE;
             balls[i].vy = -balls[i].vy;
         }
     }
 
+#if STRESS_COLLISIONS
+    // Broadphase: only balls sharing a cell are tested against each other
+    spatial_hash_clear(&ball_hash);
+    for (int i = 0; i < NUM_BALLS; i++)
+        spatial_hash_insert(&ball_hash, i, aabb_from_circle_fx(balls[i].x, balls[i].y, balls[i].radius));
+    spatial_hash_build(&ball_hash);
+    spatial_hash_for_each_pair(&ball_hash, collide_balls, balls);
+#endif
+
     // Update Rects
     for (int i = 0; i < NUM_RECTS; i++) {
         rects[i].x += rects[i].vx;
         rects[i].y += rects[i].vy;
 
-        if (rects[i].x < 0 || rects[i].x + rects[i].w >= 320) rects[i].vx = -rects[i].vx;
-        if (rects[i].y < 0 || rects[i].y + rects[i].h >= 240) rects[i].vy = -rects[i].vy;
+        if (rects[i].x < 0 || rects[i].x + rects[i].w >= W) rects[i].vx = -rects[i].vx;
+        if (rects[i].y < 0 || rects[i].y + rects[i].h >= H) rects[i].vy = -rects[i].vy;
     }
+
 }
 
-// Bresenham Line Algorithm
-void draw_line_local(surface_t *surf, int x0, int y0, int x1, int y1, uint16_t color) {
-    int dx = abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
-    int dy = -abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
-    int err = dx + dy, e2;
-
-    while (1) {
-        draw_pixel(surf, x0, y0, color);
-        if (x0 == x1 && y0 == y1) break;
-        e2 = 2 * err;
-        if (e2 >= dy) { err += dy; x0 += sx; }
-        if (e2 <= dx) { err += dx; y0 += sy; }
+static void update_particles(void) {
+#if STRESS_PARTICLES
+    // Steady state: capacity / average life spawned per frame
+    if (particles.capacity) {
+        particles_update(&particles);
+        particles_emit(&particles, &fountain, STRESS_PARTICLES / 90);
     }
+#endif
 }
 
-void game_draw(surface_t *surf) {
+static void draw_scene(surface_t *surf, const StressState *s) {
+    const Ball *balls = s->balls;
+    const RectObj *rects = s->rects;
+
     // Clear screen (Dark Blue background)
     framebuffer_clear(0x000F);
 
     // Draw dynamic background lines connecting corners to balls
     for (int i = 0; i < NUM_LINES; i++) {
         if (i < NUM_BALLS) {
-             draw_line_local(surf, 0, 0, (int)balls[i].x, (int)balls[i].y, 0x07E0); // Top-Left Green
-             draw_line_local(surf, 319, 239, (int)balls[i].x, (int)balls[i].y, 0xF800); // Bottom-Right Red
+             draw_line_fx(surf, FX16_HALF, FX16_HALF, balls[i].x, balls[i].y, 0x07E0); // Top-Left Green
+             draw_line_fx(surf, FX16_CONST(319.5), FX16_CONST(239.5), balls[i].x, balls[i].y, 0xF800); // Bottom-Right Red
         }
     }
 
     // Draw Rects
     for (int i = 0; i < NUM_RECTS; i++) {
-        draw_rect(surf, (int)rects[i].x, (int)rects[i].y, rects[i].w, rects[i].h, rects[i].color);
+        draw_rect_fx(surf, rects[i].x, rects[i].y, rects[i].w, rects[i].h, rects[i].color);
     }
 
     // Draw Balls (Circles)
     for (int i = 0; i < NUM_BALLS; i++) {
-        draw_circle(surf, (int)balls[i].x, (int)balls[i].y, balls[i].radius, balls[i].color);
+        draw_circle_fx(surf, balls[i].x, balls[i].y, balls[i].radius, balls[i].color);
     }
+
+#if STRESS_PARTICLES
+    particles_draw(&particles, surf);
+#endif
+}
+
+void game_update(uint32_t dt_us) {
+    update_scene(&scene);
+    update_particles();
+}
+
+void game_draw(surface_t *surf) { draw_scene(surf, &scene); }
+
+#if STRESS_PIPELINED
+static void game_init_state(void *state) { *(StressState *)state = scene; }
+
+static void game_update_state(void *state, uint32_t dt_us) {
+    update_scene((StressState *)state);
+}
+
+static void game_draw_state(surface_t *surf, const void *state) {
+    // The particle system has a single copy, so it stays on Core 0
+    update_particles();
+    draw_scene(surf, (const StressState *)state);
 }
+#endif
 
 const miniapp_desc_t stress_test_app = {
     .name = "Stress Test",
     .init = game_init,
+#if STRESS_PIPELINED
+    .state_size = sizeof(StressState),
+    .init_state = game_init_state,
+    .update_state = game_update_state,
+    .draw_state = game_draw_state,
+#else
     .update = game_update,
-    .draw = game_draw
+    .draw = game_draw,
+#endif
+    .interlaced = STRESS_INTERLACED
 };
 
 int main() {
@@ -152,7 +261,11 @@ int main() {
         .height = 240,
         .pixel_format = PIXEL_FORMAT_RGB565,
         .performance_profile = PROFILE_HIGH,
-        .buffer_count = 1
+        .buffer_count = 1,
+        .wire_rgb444 = STRESS_WIRE_RGB444,
+        .app_bytes = (STRESS_PARTICLES ? particles_get_arena_size(STRESS_PARTICLES) : 0) +
+                     (STRESS_COLLISIONS ? spatial_hash_get_arena_size(320, 240, SPATIAL_HASH_CELL_SHIFT, NUM_BALLS) : 0) +
+                     (STRESS_PIPELINED ? engine_get_state_arena_size(sizeof(StressState)) : 0)
     };
 
     if (engine_init(&cfg)) {
@@ -0,0 +1,54 @@
+#include "miniboy_engine.h"
+#include "video.h"
+#include <stdio.h>
+
+// Loops a 120-frame, 30 fps test clip (moving box, flickering noise patch,
+// a still frame and a scene cut) encoded at build time by
+// tools/video_pack.py, and prints what actually went over the wire. The
+// player drives the panel itself, so engine_run is never called.
+extern const uint8_t clip[];
+
+// Stats over USB every this many frames
+#define PLAYER_REPORT_FRAMES 120
+
+int main() {
+  engine_config_t cfg = {.width = 320,
+                         .height = 240,
+                         .pixel_format = PIXEL_FORMAT_RGB565,
+                         .performance_profile = PROFILE_HIGH,
+                         .buffer_count = 1,
+                         .app_bytes = video_player_get_arena_size()};
+
+  if (!engine_init(&cfg))
+    return 0;
+
+  video_player_t player;
+  if (!video_player_init(&player, clip, 0, 0, true)) {
+    printf("VIDEO: clip does not fit this panel\n");
+    return 0;
+  }
+
+  uint32_t t0 = time_us_32();
+  while (video_player_update(&player)) {
+    int32_t wait = (int32_t)(player.due_us - time_us_32());
+    if (player.ticket)
+      video_player_wait(&player);
+    else if (wait > 0)
+      sleep_us(wait);
+
+    video_stats_t *s = &player.stats;
+    if (s->frames == PLAYER_REPORT_FRAMES) {
+      uint32_t elapsed = time_us_32() - t0;
+      printf("VIDEO: %lu frames in %lu ms, %lu late, %lu windows and "
+             "%lu bytes/frame, Core 1 %lu us/frame\n",
+             (unsigned long)s->frames, (unsigned long)(elapsed / 1000),
+             (unsigned long)s->late, (unsigned long)(s->windows / s->frames),
+             (unsigned long)(s->pixel_bytes / s->frames),
+             (unsigned long)(s->busy_us / s->frames));
+      *s = (video_stats_t){0};
+      t0 = time_us_32();
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,221 @@
+#include "spatial_hash.h"
+#include "arena.h"
+#include <string.h>
+
+// Objects covering at most this many cells go in the grid
+#define SPATIAL_HASH_MAX_CELLS 4
+
+static uint32_t cell_count(uint16_t width, uint16_t height,
+                           uint8_t cell_shift) {
+  uint32_t size = 1u << cell_shift;
+  return ((width + size - 1) >> cell_shift) *
+         ((height + size - 1) >> cell_shift);
+}
+
+uint32_t spatial_hash_get_arena_size(uint16_t width, uint16_t height,
+                                     uint8_t cell_shift, uint16_t capacity) {
+  return arena_reserve_size(capacity * sizeof(aabb_t), 4) +
+         2 * arena_reserve_size(capacity * 2, 4) + // ids, large
+         arena_reserve_size(capacity * 2 * SPATIAL_HASH_MAX_CELLS, 4) +
+         arena_reserve_size((cell_count(width, height, cell_shift) + 2) * 2,
+                            4);
+}
+
+bool spatial_hash_init(spatial_hash_t *sh, uint16_t width, uint16_t height,
+                       uint8_t cell_shift, uint16_t capacity) {
+  memset(sh, 0, sizeof(*sh));
+  uint32_t cells = cell_count(width, height, cell_shift);
+
+  sh->boxes =
+      (aabb_t *)arena_alloc(ARENA_TAG_APP, capacity * sizeof(aabb_t), 4);
+  sh->ids = (uint16_t *)arena_alloc(ARENA_TAG_APP, capacity * 2, 4);
+  sh->large = (uint16_t *)arena_alloc(ARENA_TAG_APP, capacity * 2, 4);
+  sh->entries = (uint16_t *)arena_alloc(
+      ARENA_TAG_APP, capacity * 2 * SPATIAL_HASH_MAX_CELLS, 4);
+  sh->cell_start = (uint16_t *)arena_alloc(ARENA_TAG_APP, (cells + 2) * 2, 4);
+  if (!sh->boxes || !sh->ids || !sh->large || !sh->entries || !sh->cell_start)
+    return false;
+
+  uint32_t size = 1u << cell_shift;
+  sh->cell_shift = cell_shift;
+  sh->cols = (width + size - 1) >> cell_shift;
+  sh->rows = (height + size - 1) >> cell_shift;
+  sh->capacity = capacity;
+  spatial_hash_clear(sh);
+  return true;
+}
+
+// --- Cells ---
+typedef struct {
+  int c0, r0, c1, r1; // Inclusive
+} cell_range_t;
+
+static inline int cell_col(const spatial_hash_t *sh, int x) {
+  int c = x >> sh->cell_shift;
+  return c < 0 ? 0 : (c >= sh->cols ? sh->cols - 1 : c);
+}
+
+static inline int cell_row(const spatial_hash_t *sh, int y) {
+  int r = y >> sh->cell_shift;
+  return r < 0 ? 0 : (r >= sh->rows ? sh->rows - 1 : r);
+}
+
+static inline cell_range_t cells_of(const spatial_hash_t *sh, aabb_t b) {
+  return (cell_range_t){cell_col(sh, b.x0), cell_row(sh, b.y0),
+                        cell_col(sh, b.x1 - 1), cell_row(sh, b.y1 - 1)};
+}
+
+static inline bool is_large(cell_range_t r) {
+  return (r.c1 - r.c0 + 1) * (r.r1 - r.r0 + 1) > SPATIAL_HASH_MAX_CELLS;
+}
+
+// The one cell that reports an overlap of a and b: the one holding the
+// top-left corner of their intersection
+static inline bool owns_overlap(const spatial_hash_t *sh, aabb_t a, aabb_t b,
+                                int col, int row) {
+  int x = a.x0 > b.x0 ? a.x0 : b.x0;
+  int y = a.y0 > b.y0 ? a.y0 : b.y0;
+  return cell_col(sh, x) == col && cell_row(sh, y) == row;
+}
+
+// --- Rebuild ---
+void spatial_hash_clear(spatial_hash_t *sh) {
+  sh->count = 0;
+  sh->large_count = 0;
+  memset(sh->cell_start, 0, (sh->cols * sh->rows + 2) * 2);
+}
+
+bool spatial_hash_insert(spatial_hash_t *sh, uint16_t id, aabb_t box) {
+  if (sh->count == sh->capacity)
+    return false;
+  if (box.x1 <= box.x0 || box.y1 <= box.y0)
+    return true; // Empty: can never overlap
+  sh->boxes[sh->count] = box;
+  sh->ids[sh->count] = id;
+  sh->count++;
+  return true;
+}
+
+void spatial_hash_build(spatial_hash_t *sh) {
+  uint32_t cells = sh->cols * sh->rows;
+  uint16_t *start = sh->cell_start;
+  memset(start, 0, (cells + 2) * 2);
+  sh->large_count = 0;
+
+  // Count into start[c + 2] so that after the prefix sum start[c + 1] is
+  // the write cursor of cell c, and after the scatter start[c] its start
+  for (uint32_t i = 0; i < sh->count; i++) {
+    cell_range_t r = cells_of(sh, sh->boxes[i]);
+    if (is_large(r)) {
+      sh->large[sh->large_count++] = (uint16_t)i;
+      continue;
+    }
+    for (int row = r.r0; row <= r.r1; row++)
+      for (int col = r.c0; col <= r.c1; col++)
+        start[row * sh->cols + col + 2]++;
+  }
+  for (uint32_t c = 2; c < cells + 2; c++)
+    start[c] += start[c - 1];
+
+  for (uint32_t i = 0; i < sh->count; i++) {
+    cell_range_t r = cells_of(sh, sh->boxes[i]);
+    if (is_large(r))
+      continue;
+    for (int row = r.r0; row <= r.r1; row++)
+      for (int col = r.c0; col <= r.c1; col++)
+        sh->entries[start[row * sh->cols + col + 1]++] = (uint16_t)i;
+  }
+}
+
+// --- Queries ---
+typedef struct {
+  int cx, cy, r_sq;
+} circle_t;
+
+// Closest pixel of the box to the centre lies inside the circle (the box is
+// half-open, so its last pixel is x1 - 1, y1 - 1)
+static inline bool circle_hits(const circle_t *c, aabb_t b) {
+  int px = c->cx < b.x0 ? b.x0 : (c->cx >= b.x1 ? b.x1 - 1 : c->cx);
+  int py = c->cy < b.y0 ? b.y0 : (c->cy >= b.y1 ? b.y1 - 1 : c->cy);
+  int dx = c->cx - px, dy = c->cy - py;
+  return dx * dx + dy * dy < c->r_sq;
+}
+
+static uint32_t query(const spatial_hash_t *sh, aabb_t box,
+                      const circle_t *circle, uint16_t *out, uint32_t max) {
+  uint32_t n = 0;
+  if (box.x1 <= box.x0 || box.y1 <= box.y0)
+    return 0;
+
+  cell_range_t r = cells_of(sh, box);
+  for (int row = r.r0; row <= r.r1; row++) {
+    for (int col = r.c0; col <= r.c1; col++) {
+      uint32_t c = row * sh->cols + col;
+      for (uint32_t k = sh->cell_start[c]; k < sh->cell_start[c + 1]; k++) {
+        uint32_t i = sh->entries[k];
+        aabb_t b = sh->boxes[i];
+        if (n < max && aabb_overlap(box, b) &&
+            owns_overlap(sh, box, b, col, row) &&
+            (!circle || circle_hits(circle, b)))
+          out[n++] = sh->ids[i];
+      }
+    }
+  }
+  for (uint32_t k = 0; k < sh->large_count && n < max; k++) {
+    aabb_t b = sh->boxes[sh->large[k]];
+    if (aabb_overlap(box, b) && (!circle || circle_hits(circle, b)))
+      out[n++] = sh->ids[sh->large[k]];
+  }
+  return n;
+}
+
+uint32_t spatial_hash_query_aabb(const spatial_hash_t *sh, aabb_t box,
+                                 uint16_t *out, uint32_t max) {
+  return query(sh, box, NULL, out, max);
+}
+
+uint32_t spatial_hash_query_circle(const spatial_hash_t *sh, int cx, int cy,
+                                   int radius, uint16_t *out, uint32_t max) {
+  circle_t circle = {cx, cy, radius * radius};
+  aabb_t bounds = {(int16_t)(cx - radius), (int16_t)(cy - radius),
+                   (int16_t)(cx + radius + 1), (int16_t)(cy + radius + 1)};
+  return query(sh, bounds, &circle, out, max);
+}
+
+uint32_t spatial_hash_for_each_pair(const spatial_hash_t *sh,
+                                    spatial_pair_fn fn, void *arg) {
+  uint32_t pairs = 0;
+
+  // Grid objects against each other, cell by cell
+  for (int row = 0; row < sh->rows; row++) {
+    for (int col = 0; col < sh->cols; col++) {
+      uint32_t c = row * sh->cols + col;
+      uint32_t end = sh->cell_start[c + 1];
+      for (uint32_t a = sh->cell_start[c]; a < end; a++) {
+        aabb_t box_a = sh->boxes[sh->entries[a]];
+        for (uint32_t b = a + 1; b < end; b++) {
+          aabb_t box_b = sh->boxes[sh->entries[b]];
+          if (aabb_overlap(box_a, box_b) &&
+              owns_overlap(sh, box_a, box_b, col, row)) {
+            fn(sh->ids[sh->entries[a]], sh->ids[sh->entries[b]], arg);
+            pairs++;
+          }
+        }
+      }
+    }
+  }
+
+  // Large objects against everything (large pairs once, lower index first)
+  for (uint32_t k = 0; k < sh->large_count; k++) {
+    uint32_t l = sh->large[k];
+    for (uint32_t i = 0; i < sh->count; i++) {
+      if (i == l || (i < l && is_large(cells_of(sh, sh->boxes[i]))))
+        continue;
+      if (aabb_overlap(sh->boxes[l], sh->boxes[i])) {
+        fn(sh->ids[l], sh->ids[i], arg);
+        pairs++;
+      }
+    }
+  }
+  return pairs;
+}
@@ -0,0 +1,84 @@
+#ifndef SPATIAL_HASH_H
+#define SPATIAL_HASH_H
+
+#include "fixed.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Spatial Hash Broadphase
+ * A uniform grid of power-of-two cells over the playfield. Each frame the
+ * app clears it, inserts every object's box under its own id, and builds:
+ * a counting sort of (cell, object) entries into arrays reserved at init,
+ * so a rebuild allocates nothing. Queries and pair enumeration then only
+ * look at the cells a box touches, so the cost follows local density
+ * rather than the total object count.
+ *
+ * Objects spanning more than 2x2 cells go on a short "large" list that
+ * every query checks directly. Boxes outside the playfield fall into the
+ * edge cells. Each hit and pair is reported once: only in the cell that
+ * holds the top-left corner of the overlap.
+ */
+
+// Default cell: 32x32 pixels (10x8 cells on a 320x240 playfield)
+#define SPATIAL_HASH_CELL_SHIFT 5
+
+// Half-open box [x0, x1) x [y0, y1) in pixels
+typedef struct {
+  int16_t x0, y0, x1, y1;
+} aabb_t;
+
+typedef struct {
+  uint8_t cell_shift;
+  uint16_t cols;
+  uint16_t rows;
+  uint16_t capacity;
+  uint16_t count;       // Objects inserted since the last clear
+  aabb_t *boxes;        // By object index (insert order)
+  uint16_t *ids;        // Caller id by object index
+  uint16_t *cell_start; // After build: cell c holds entries[c_start[c]..[c+1])
+  uint16_t *entries;    // Object indices grouped by cell
+  uint16_t *large;      // Objects over 2x2 cells
+  uint16_t large_count;
+} spatial_hash_t;
+
+typedef void (*spatial_pair_fn)(uint16_t id_a, uint16_t id_b, void *arg);
+
+// Arena bytes (ARENA_TAG_APP) spatial_hash_init() takes
+uint32_t spatial_hash_get_arena_size(uint16_t width, uint16_t height,
+                                     uint8_t cell_shift, uint16_t capacity);
+
+bool spatial_hash_init(spatial_hash_t *sh, uint16_t width, uint16_t height,
+                       uint8_t cell_shift, uint16_t capacity);
+
+// Per-frame rebuild: clear, insert every object, build
+void spatial_hash_clear(spatial_hash_t *sh);
+bool spatial_hash_insert(spatial_hash_t *sh, uint16_t id, aabb_t box);
+void spatial_hash_build(spatial_hash_t *sh);
+
+// Ids of the objects whose boxes overlap `box` (or the circle); writes at
+// most `max` and returns how many were written
+uint32_t spatial_hash_query_aabb(const spatial_hash_t *sh, aabb_t box,
+                                 uint16_t *out, uint32_t max);
+uint32_t spatial_hash_query_circle(const spatial_hash_t *sh, int cx, int cy,
+                                   int radius, uint16_t *out, uint32_t max);
+
+// Call `fn` once for every pair of overlapping boxes; returns the count
+uint32_t spatial_hash_for_each_pair(const spatial_hash_t *sh,
+                                    spatial_pair_fn fn, void *arg);
+
+static inline bool aabb_overlap(aabb_t a, aabb_t b) {
+  return a.x0 < b.x1 && b.x0 < a.x1 && a.y0 < b.y1 && b.y0 < a.y1;
+}
+
+// Pixel box covering a 16.16 rectangle or circle
+static inline aabb_t aabb_from_rect_fx(fx16_t x, fx16_t y, fx16_t w,
+                                       fx16_t h) {
+  return (aabb_t){(int16_t)fx16_floor(x), (int16_t)fx16_floor(y),
+                  (int16_t)fx16_ceil(x + w), (int16_t)fx16_ceil(y + h)};
+}
+static inline aabb_t aabb_from_circle_fx(fx16_t cx, fx16_t cy, fx16_t r) {
+  return aabb_from_rect_fx(cx - r, cy - r, 2 * r, 2 * r);
+}
+
+#endif
@@ -1,11 +1,17 @@
 #include "miniboy_engine.h"
+#include "arena.h"
+#include "compositor.h"
 #include "display_driver.h"
+#include "dma_mem.h"
 #include "framebuffer.h"
+#include "occlusion.h"
 #include "pico/stdlib.h"
 #include "profiler.h"
+#include "render_service.h"
 #include "system_config.h"
 #include "transport_pio.h"
 #include <stdio.h>
+#include <string.h>
 
 static display_transport_t *transport = NULL;
 static engine_config_t engine_config;
@@ -25,7 +31,37 @@ bool engine_init(const engine_config_t *config) {
   system_init(sys_cfg);
   stdio_init_all();
 
-  // 2. Transport Configuration (PIO SPI)
+  // 2. Engine Arena: one reservation for every long-lived buffer, so an
+  // oversized configuration fails here instead of as corruption later.
+  uint32_t display_bytes =
+      transport_pio_get_arena_size() + dma_mem_get_arena_size();
+  uint32_t fb_bytes =
+      framebuffer_get_arena_size(config->width, config->height,
+                                 config->pixel_format, config->buffer_count);
+  if (config->overdraw_cull && config->buffer_count > 0)
+    fb_bytes += occlusion_get_arena_size(config->width, config->height,
+                                         OCCLUSION_CAPACITY);
+  if (config->buffer_count > 0)
+    fb_bytes += compositor_get_arena_size(
+        config->width, config->height, config->pixel_format,
+        config->hud_layer ? PROFILER_HUD_ROWS : 0, config->background_layer);
+  uint32_t scratch_bytes =
+      config->scratch_bytes ? arena_reserve_size(config->scratch_bytes, 8) : 0;
+  uint32_t arena_bytes =
+      display_bytes + fb_bytes + scratch_bytes + config->app_bytes;
+
+  if (!arena_init(arena_bytes)) {
+    printf("CORE: Arena needs %lu bytes (display %lu, framebuffer %lu, "
+           "scratch %lu, app %lu)\n",
+           (unsigned long)arena_bytes, (unsigned long)display_bytes,
+           (unsigned long)fb_bytes, (unsigned long)scratch_bytes,
+           (unsigned long)config->app_bytes);
+    return false;
+  }
+  if (!arena_frame_init(config->scratch_bytes))
+    return false;
+
+  // 3. Transport Configuration (PIO SPI)
   // TODO: Move pin mapping to board_config.h
   transport_pio_config_t t_cfg = {.pio = pio0,
                                   .sm = 0,
@@ -39,7 +75,7 @@ bool engine_init(const engine_config_t *config) {
 
   transport->init(transport, sys_cfg->spi_hz_init, sys_cfg->spi_hz_fast);
 
-  // 3. Display Configuration
+  // 4. Display Configuration
   display_pixel_format_t fmt = config->pixel_format;
 
   display_config_t disp_cfg = {.transport = transport,
@@ -50,7 +86,7 @@ bool engine_init(const engine_config_t *config) {
                                .format = fmt};
   display_init(&disp_cfg);
 
-  // 4. Graphics Engine
+  // 5. Graphics Engine
   system_set_actual_spi_hz(sys_cfg->spi_hz_fast);
   uint8_t bufs = config->buffer_count;
 
@@ -58,21 +94,153 @@ bool engine_init(const engine_config_t *config) {
     printf("CORE: Framebuffer allocation failed!\n");
     return false;
   }
+  if (config->wire_rgb444 && !display_set_rgb444_packing(true))
+    printf("CORE: RGB444 packing unavailable, sending 16-bit\n");
+  if (config->overdraw_cull && bufs > 0 &&
+      !occlusion_init(config->width, config->height, OCCLUSION_CAPACITY))
+    return false;
+  if (bufs > 0 &&
+      !compositor_init(config->width, config->height, fmt,
+                       config->hud_layer ? PROFILER_HUD_ROWS : 0,
+                       config->background_layer))
+    return false;
+  framebuffer_set_present_mode(config->present_mode);
+  framebuffer_set_queue_mode(config->present_queue);
+  if (config->column_major && bufs > 0 &&
+      !framebuffer_set_layout(SURFACE_LAYOUT_COLUMN_MAJOR)) {
+    printf("CORE: Column-major layout unavailable!\n");
+    return false;
+  }
 
   profiler_init();
   return true;
 }
 
+uint32_t engine_get_state_arena_size(uint32_t state_size) {
+  return 2 * arena_reserve_size(state_size, 8);
+}
+
+// --- Pipelined Mode ---
+typedef struct {
+  const miniapp_desc_t *app;
+  void *state;      // Written by this update
+  const void *prev; // Last completed state (Core 0 may be drawing it)
+  uint32_t dt_us;
+} update_job_t;
+
+static update_job_t update_job;
+
+// Core 1: carry the completed state forward, then advance it
+static void update_state_task(void *arg) {
+  update_job_t *job = (update_job_t *)arg;
+  memcpy(job->state, job->prev, job->app->state_size);
+  job->app->update_state(job->state, job->dt_us);
+}
+
+static uint32_t submit_update(const miniapp_desc_t *app, void *state,
+                              const void *prev, uint32_t dt_us) {
+  update_job = (update_job_t){app, state, prev, dt_us};
+  render_job_t job = {.type = RENDER_CMD_CALLBACK,
+                      .callback = update_state_task,
+                      .callback_arg = &update_job};
+  uint32_t ticket = render_service_submit(&job);
+  render_service_set_long_job(ticket); // Draw-time splits stay on Core 0
+  return ticket;
+}
+
+// Fallback with a single state copy: update then draw, both on Core 0
+static void engine_run_state_serial(const miniapp_desc_t *app, void *state) {
+  uint32_t last_update = time_us_32();
+
+  while (true) {
+    uint32_t t0 = time_us_32();
+    arena_frame_reset();
+
+    app->update_state(state, t0 - last_update);
+    last_update = t0;
+    if (app->draw_state)
+      app->draw_state(framebuffer_get_surface(), state);
+
+    profiler_draw();
+    framebuffer_swap_async();
+    if (engine_config.buffer_count == 1)
+      framebuffer_wait_last_swap();
+
+    profiler_update(time_us_32() - t0);
+  }
+}
+
+// Frame N + 1 updates on Core 1 while Core 0 draws frame N. Core 1 presents
+// (RGB332, row-hash, layers, ...) queue behind the update on the same core.
+static void engine_run_pipelined(const miniapp_desc_t *app) {
+  void *states[2];
+  for (int i = 0; i < 2; i++)
+    states[i] = arena_alloc(ARENA_TAG_APP, app->state_size, 8);
+  if (!states[0])
+    panic("CORE: Pipelined state needs %lu arena bytes (app_bytes)\n",
+          (unsigned long)engine_get_state_arena_size(app->state_size));
+
+  memset(states[0], 0, app->state_size);
+  if (app->init_state)
+    app->init_state(states[0]);
+
+  if (!states[1]) {
+    printf("CORE: Pipelined state needs %lu arena bytes (app_bytes), "
+           "updating serially\n",
+           (unsigned long)engine_get_state_arena_size(app->state_size));
+    engine_run_state_serial(app, states[0]);
+  }
+
+  int front = 0; // State being drawn
+  uint32_t last_update = time_us_32();
+  uint32_t ticket = submit_update(app, states[1], states[0], 0);
+
+  while (true) {
+    uint32_t t0 = time_us_32();
+    arena_frame_reset();
+
+    // 1. Draw the last completed state
+    if (app->draw_state)
+      app->draw_state(framebuffer_get_surface(), states[front]);
+
+    // 2. System Overlays + Present
+    profiler_draw();
+    framebuffer_swap_async();
+    if (engine_config.buffer_count == 1)
+      framebuffer_wait_last_swap();
+
+    // 3. Handoff: the state Core 1 just finished is drawn next, and the
+    // one just drawn is free for the following update
+    render_service_wait_job(ticket);
+    front ^= 1;
+    uint32_t now = time_us_32();
+    ticket = submit_update(app, states[front ^ 1], states[front],
+                           now - last_update);
+    last_update = now;
+
+    profiler_update(time_us_32() - t0);
+  }
+}
+
 void engine_run(const miniapp_desc_t *app) {
   printf("CORE: Starting Application: %s\n", app->name ? app->name : "Unknown");
 
   if (app->init)
     app->init();
 
+  if (app->interlaced)
+    framebuffer_set_present_mode(PRESENT_MODE_INTERLACED);
+
+  if (app->update_state && app->state_size) {
+    engine_run_pipelined(app);
+    return;
+  }
+
   uint32_t last_time = time_us_32();
 
   while (true) {
     uint32_t t0 = time_us_32();
+    arena_frame_reset();
 
     // 1. Update Phase
     if (app->update) {
@@ -2,6 +2,7 @@
 #define MINIBOY_ENGINE_H
 
 #include "display_driver.h"
+#include "framebuffer.h"
 #include "surface.h"
 
 // Lifecycle callbacks for a MiniBoy Application
@@ -11,6 +12,18 @@ typedef struct {
   void (*draw)(surface_t *screen);
   const char *name;
   uint32_t target_fps;
+  bool interlaced; // Present odd/even rows on alternate frames
+
+  // Pipelined mode (optional, replaces update/draw): update_state runs on
+  // Core 1 one frame ahead while Core 0 draws the last completed state. The
+  // engine double-buffers state_size bytes (reserve
+  // engine_get_state_arena_size() in engine_config_t.app_bytes) and copies
+  // the completed state forward before each update, so neither side locks.
+  // update_state must not draw, present or use the frame scratch arena.
+  uint32_t state_size;
+  void (*init_state)(void *state);
+  void (*update_state)(void *state, uint32_t dt_us);
+  void (*draw_state)(surface_t *screen, const void *state);
 } miniapp_desc_t;
 
 // Performance Profiles
@@ -30,11 +43,23 @@ typedef struct {
   display_pixel_format_t pixel_format; // Use PIXEL_FORMAT_* from display_driver.h
   engine_profile_t performance_profile; // Use PROFILE_* enum
   uint8_t buffer_count;
+  uint32_t scratch_bytes; // Per-frame scratch (arena_frame_alloc), 0 = none
+  uint32_t app_bytes; // Arena for app-owned engine objects (*_get_arena_size)
+  present_mode_t present_mode; // PRESENT_MODE_FULL, _ROW_HASH or _SCROLL
+  present_queue_mode_t present_queue; // Triple-buffer FIFO or MAILBOX
+  bool overdraw_cull; // Record opaque primitives, write visible spans only
+  bool hud_layer; // Profiler HUD as a retained compositor strip
+  bool background_layer; // Cached background behind key-coloured game pixels
+  bool column_major; // Column-major surfaces, landscape only (full present)
+  bool wire_rgb444; // RGB565/RGB332 surfaces sent as 12-bit RGB444 (PIO)
 } engine_config_t;
 
 // Initialize the engine (System, Display, Graphics)
 bool engine_init(const engine_config_t *config);
 
+// Arena bytes for a pipelined app's two state copies
+uint32_t engine_get_state_arena_size(uint32_t state_size);
+
 // Run the application (This function does not return)
 void engine_run(const miniapp_desc_t *app);
 
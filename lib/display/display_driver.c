@@ -1,11 +1,40 @@
 #include "display_driver.h"
 #include "hardware/gpio.h"
+#include "system_config.h"
 
 static display_config_t current_config;
 
+// Last CASET/PASET sent; the panel keeps them across RAMWR commands
+static uint16_t win_x0 = 0xFFFF, win_x1, win_y0 = 0xFFFF, win_y1;
+
+// Memory Access Control in use (MV set = landscape)
+static uint8_t madctl = 0x68;
+// Column-major scan: landscape picture with MV cleared, so the panel's fast
+// axis runs down screen columns and CASET/PASET swap roles
+static bool column_major = false;
+
+// 16-bit pixel data narrowed to RGB444 by the transport (COLMOD 0x53)
+static bool pack444 = false;
+
+// Pixel repeated by send_fill16 (read by DMA until the fill completes)
+static uint16_t fill_pixel;
+
+static uint8_t colmod_for(display_pixel_format_t format) {
+  // RGB332 is expanded to RGB565 before it reaches the wire
+  return (format == PIXEL_FORMAT_RGB332) ? PIXEL_FORMAT_RGB565 : format;
+}
+
+static uint8_t panel_colmod(void) {
+  return pack444 ? PIXEL_FORMAT_RGB444 : colmod_for(current_config.format);
+}
+
 void display_init(const display_config_t *config) {
   current_config = *config;
+  win_x0 = win_y0 = 0xFFFF;
+  pack444 = false;
   display_transport_t *t = config->transport;
+  if (t->set_rgb444_packing)
+    t->set_rgb444_packing(t, false);
 
   // Reset display
   gpio_init(config->pin_rst);
@@ -25,14 +54,14 @@ void display_init(const display_config_t *config) {
   sleep_ms(150);
 
   t->send_cmd(t, 0x3A); // Pixel Format
-  if (config->format == PIXEL_FORMAT_RGB332) {
-    t->send_data8(t, 0x55); // RGB565 for hardware expansion/LUT
-  } else {
-    t->send_data8(t, (uint8_t)config->format);
-  }
+  t->send_data8(t, colmod_for(config->format));
 
-  t->send_cmd(t, 0x36);   // Memory Access Control
-  t->send_data8(t, 0x68); // Landscape, BGR
+  // Memory Access Control: portrait (MX, BGR) when taller than wide,
+  // otherwise landscape (MV, MX, BGR)
+  madctl = (config->height > config->width) ? 0x48 : 0x68;
+  column_major = false;
+  t->send_cmd(t, 0x36);
+  t->send_data8(t, madctl);
 
   t->send_cmd(t, 0x29); // Display ON
   sleep_ms(50);
@@ -45,21 +74,118 @@ void display_init(const display_config_t *config) {
   // Note: Frequency tracking moved to transport or main
 }
 
+void display_set_wire_format(display_pixel_format_t format) {
+  display_transport_t *t = current_config.transport;
+  if (format == PIXEL_FORMAT_RGB444 && pack444) {
+    t->set_rgb444_packing(t, false); // Data arrives packed already
+    pack444 = false;
+  }
+  current_config.format = format;
+  t->set_speed(t, false);
+  t->send_cmd(t, 0x3A);
+  t->send_data8(t, panel_colmod());
+}
+
+bool display_set_rgb444_packing(bool enable) {
+  display_transport_t *t = current_config.transport;
+  if (enable && (colmod_for(current_config.format) != PIXEL_FORMAT_RGB565 ||
+                 t->set_rgb444_packing == NULL ||
+                 !t->set_rgb444_packing(t, true)))
+    return false;
+  if (!enable && pack444)
+    t->set_rgb444_packing(t, false);
+
+  pack444 = enable;
+  t->set_speed(t, false);
+  t->send_cmd(t, 0x3A);
+  t->send_data8(t, panel_colmod());
+  return true;
+}
+
+bool display_get_rgb444_packing(void) { return pack444; }
+
+void display_set_scroll_area(uint16_t top_fixed, uint16_t scroll_lines,
+                             uint16_t bottom_fixed) {
+  display_transport_t *t = current_config.transport;
+  t->set_speed(t, false);
+  t->send_cmd(t, 0x33); // Vertical Scrolling Definition
+  t->send_data8(t, top_fixed >> 8);
+  t->send_data8(t, top_fixed & 0xFF);
+  t->send_data8(t, scroll_lines >> 8);
+  t->send_data8(t, scroll_lines & 0xFF);
+  t->send_data8(t, bottom_fixed >> 8);
+  t->send_data8(t, bottom_fixed & 0xFF);
+}
+
+void display_set_scroll_start(uint16_t line) {
+  display_transport_t *t = current_config.transport;
+  t->set_speed(t, false);
+  t->send_cmd(t, 0x37); // Vertical Scrolling Start Address
+  t->send_data8(t, line >> 8);
+  t->send_data8(t, line & 0xFF);
+}
+
+bool display_scroll_is_vertical(void) {
+  return (madctl & 0x20) == 0 && !column_major;
+}
+
+bool display_set_column_major(bool enable) {
+  if (current_config.height > current_config.width)
+    return !enable; // Portrait: rows already run along the fast axis
+
+  // MX|MV|BGR -> MY|BGR: dropping the exchange moves the mirror to the
+  // other address counter, keeping the same picture orientation
+  display_transport_t *t = current_config.transport;
+  t->set_speed(t, false);
+  t->send_cmd(t, 0x36);
+  t->send_data8(t, enable ? 0x88 : madctl);
+  column_major = enable;
+  win_x0 = win_y0 = 0xFFFF; // Address ranges changed meaning
+  return true;
+}
+
+display_pixel_format_t display_get_wire_format(void) {
+  return colmod_for(current_config.format);
+}
+
+// CASET/PASET: the start/end pair as one burst where the transport can
+static void send_range(display_transport_t *t, uint8_t cmd, uint16_t start,
+                       uint16_t end) {
+  uint8_t p[4] = {start >> 8, start & 0xFF, end >> 8, end & 0xFF};
+  t->send_cmd(t, cmd);
+  if (t->send_data) {
+    t->send_data(t, p, 4);
+    return;
+  }
+  for (int i = 0; i < 4; i++)
+    t->send_data8(t, p[i]);
+}
+
 void display_set_window(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1) {
   display_transport_t *t = current_config.transport;
   t->set_speed(t, false);
 
-  t->send_cmd(t, 0x2A);
-  t->send_data8(t, x0 >> 8);
-  t->send_data8(t, x0 & 0xFF);
-  t->send_data8(t, x1 >> 8);
-  t->send_data8(t, x1 & 0xFF);
+  if (column_major) {
+    // Screen y is the column address, screen x the page address
+    uint16_t t0 = x0, t1 = x1;
+    x0 = y0;
+    x1 = y1;
+    y0 = t0;
+    y1 = t1;
+  }
 
-  t->send_cmd(t, 0x2B);
-  t->send_data8(t, y0 >> 8);
-  t->send_data8(t, y0 & 0xFF);
-  t->send_data8(t, y1 >> 8);
-  t->send_data8(t, y1 & 0xFF);
+  // Skip column/page address commands the panel already holds
+  if (x0 != win_x0 || x1 != win_x1) {
+    send_range(t, 0x2A, x0, x1);
+    win_x0 = x0;
+    win_x1 = x1;
+  }
+
+  if (y0 != win_y0 || y1 != win_y1) {
+    send_range(t, 0x2B, y0, y1);
+    win_y0 = y0;
+    win_y1 = y1;
+  }
 
   t->send_cmd(t, 0x2C);
 }
@@ -69,23 +195,54 @@ void display_start_bulk(void) {
   t->set_speed(t, true); // Fast mode
 }
 
+// Transport waits sleep; count them as idle for the profiler
+static void transport_wait(display_transport_t *t) {
+  uint32_t start = system_idle_begin();
+  t->wait(t);
+  system_idle_end(start);
+}
+
 void display_end_bulk(void) {
   display_transport_t *t = current_config.transport;
-  t->wait(t);
+  transport_wait(t);
   t->set_speed(t, false);
 }
 
+void display_wait_ready(void) {
+  display_transport_t *t = current_config.transport;
+  uint32_t start = system_idle_begin();
+  if (t->wait_ready)
+    t->wait_ready(t);
+  else
+    while (t->is_busy(t))
+      tight_loop_contents();
+  system_idle_end(start);
+}
+
 void display_send_buffer(const uint8_t *data, uint32_t len) {
   display_transport_t *t = current_config.transport;
-  t->send_buffer(t, data, len);
+  if (colmod_for(current_config.format) == PIXEL_FORMAT_RGB565)
+    t->send_buffer16(t, (const uint16_t *)data, len / 2); // Native pixels
+  else
+    t->send_buffer(t, data, len);
 }
 
 void display_push_pixels(uint16_t color, uint32_t count) {
   display_transport_t *t = current_config.transport;
   // Assume caller has called display_start_bulk (set_speed true)
 
+  if (current_config.format != PIXEL_FORMAT_RGB444 && t->send_fill16) {
+    // 16-bit wire: one DMA from a 2-byte ring, completed by display_end_bulk
+    if (t->is_busy(t))
+      transport_wait(t); // Pixel may still be in use by the previous fill
+    fill_pixel = color;
+    t->send_fill16(t, &fill_pixel, count);
+    return;
+  }
+
   // Create a small chunk buffer for filling
-  uint8_t chunk[64];
+  uint16_t chunk16[32];
+  uint8_t *chunk = (uint8_t *)chunk16;
   uint32_t chunk_capacity_pixels;
   uint32_t chunk_size_bytes;
 
@@ -109,13 +266,9 @@ void display_push_pixels(uint16_t color, uint32_t count) {
     chunk_capacity_pixels = 42;
     chunk_size_bytes = 63;
   } else {
-    // RGB565 / Expaded RGB332: 2 bytes per pixel
-    uint8_t hi = color >> 8;
-    uint8_t lo = color & 0xFF;
-    for (int i = 0; i < 32; i++) {
-      chunk[i * 2] = hi;
-      chunk[i * 2 + 1] = lo;
-    }
+    // RGB565 / Expaded RGB332 (transports without send_fill16)
+    for (int i = 0; i < 32; i++)
+      chunk16[i] = color;
     chunk_capacity_pixels = 32;
     chunk_size_bytes = 64;
   }
@@ -132,8 +285,8 @@ void display_push_pixels(uint16_t color, uint32_t count) {
       push_bytes = push_pixels * 2;
     }
 
-    t->send_buffer(t, chunk, push_bytes);
-    t->wait(t); // CRITICAL: Wait for DMA to finish before reusing buffer/DMA!
+    display_send_buffer(chunk, push_bytes);
+    transport_wait(t); // CRITICAL: Wait for DMA to finish before reusing buffer/DMA!
     count -= push_pixels;
   }
 }
@@ -146,3 +299,9 @@ bool display_is_busy(void) {
   if(t && t->is_busy) return t->is_busy(t);
   return false;
 }
+
+void display_set_complete_callback(void (*callback)(void *), void *arg) {
+  display_transport_t *t = current_config.transport;
+  if (t && t->set_complete_callback)
+    t->set_complete_callback(t, callback, arg);
+}
@@ -26,12 +26,47 @@ void display_init(const display_config_t *config);
 void display_set_window(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1);
 void display_start_bulk(void);
 void display_end_bulk(void);
+// Pixel data in the surface layout: on an RGB565 wire, native-endian
+// uint16_t pixels (halfword aligned, len even); RGB444 packed bytes
 void display_send_buffer(const uint8_t *data, uint32_t len);
 void display_push_pixels(uint16_t color, uint32_t count);
+// Sleep until the last display_send_buffer has been read out of memory: the
+// buffer may be reused and the next send queued while the wire drains
+void display_wait_ready(void);
+
+// Hardware scrolling (ILI9341 0x33 / 0x37) along the panel's gate axis:
+// screen y in portrait, screen x in landscape. The three areas must add up
+// to DISPLAY_GATE_LINES; `line` is the GRAM line shown at the top of the
+// scrolling area.
+#define DISPLAY_GATE_LINES 320
+void display_set_scroll_area(uint16_t top_fixed, uint16_t scroll_lines,
+                             uint16_t bottom_fixed);
+void display_set_scroll_start(uint16_t line);
+bool display_scroll_is_vertical(void);
+
+// Column-major scan (landscape only): pixel data fills screen columns top
+// to bottom, left to right. Windows stay in screen coordinates.
+bool display_set_column_major(bool enable);
+
+// Change the panel's interface pixel format (COLMOD) after init
+void display_set_wire_format(display_pixel_format_t format);
+// Format display_send_buffer data is in (RGB565 or RGB444 packed bytes)
+display_pixel_format_t display_get_wire_format(void);
+
+// RGB565 data (surfaces, RGB332 expansion, fills) leaves as 12-bit RGB444:
+// the transport drops the low bits while shifting, so buffers stay 16-bit
+// and the wire carries 25% fewer bits. false if the wire is already RGB444
+// or the transport cannot pack.
+bool display_set_rgb444_packing(bool enable);
+bool display_get_rgb444_packing(void);
 
 // Get dimensions
 uint16_t display_get_width(void);
 uint16_t display_get_height(void);
 bool display_is_busy(void);
 
+// Bulk-transfer completion interrupt (runs on the core that initialised the
+// transport)
+void display_set_complete_callback(void (*callback)(void *), void *arg);
+
 #endif
@@ -21,15 +21,42 @@ typedef struct display_transport {
   // Low level byte-by-byte transfer (blocking)
   void (*send_cmd)(struct display_transport *self, uint8_t cmd);
   void (*send_data8)(struct display_transport *self, uint8_t data);
+  // Command parameters back to back under one CS (blocking, no DMA, so no
+  // completion IRQ). NULL: the driver sends them with send_data8.
+  void (*send_data)(struct display_transport *self, const uint8_t *data,
+                    uint32_t len);
 
   // High performance bulk transfer (can be async)
   void (*send_buffer)(struct display_transport *self, const uint8_t *data,
                       uint32_t len);
 
-  // Synchronization
+  // Native-endian 16-bit pixels (RGB565 wire), each sent high byte first.
+  // data must be halfword aligned; count is in pixels.
+  void (*send_buffer16)(struct display_transport *self, const uint16_t *data,
+                        uint32_t count);
+
+  // Repeat one 16-bit pixel count times in one DMA (read ring, no read
+  // increment). The pixel must stay valid until the transfer completes.
+  void (*send_fill16)(struct display_transport *self, const uint16_t *pixel,
+                      uint32_t count);
+
+  // Narrow send_buffer16/send_fill16 pixels to 12-bit RGB444 as they are
+  // shifted out. false if the transport cannot (NULL: never supported).
+  bool (*set_rgb444_packing)(struct display_transport *self, bool enable);
+
+  // Synchronization. wait: transfer fully on the wire. wait_ready: DMA has
+  // finished reading memory, so the buffer may be reused and the next send
+  // may start while the tail drains. Both sleep (WFE) where they can.
   void (*wait)(struct display_transport *self);
+  void (*wait_ready)(struct display_transport *self);
   bool (*is_busy)(struct display_transport *self);
 
+  // Completion IRQ: called (in interrupt context) when a send_buffer* or
+  // send_fill16 DMA has finished reading memory. NULL removes the callback;
+  // the interrupt itself stays on to wake sleeping waits.
+  void (*set_complete_callback)(struct display_transport *self,
+                                void (*callback)(void *), void *arg);
+
   // Opaque pointer for internal state
   void *priv;
 } display_transport_t;
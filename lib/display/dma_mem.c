@@ -1,8 +1,26 @@
 #include "dma_mem.h"
+#include "arena.h"
 #include "hardware/dma.h"
+#include "hardware/irq.h"
 
 static int dma_mem_channel = -1;
+static int dma_crc_channel = -1;
 static volatile uint32_t fill_value __attribute__((aligned(4))) = 0;
+static volatile uint32_t crc_sink __attribute__((aligned(4))) = 0;
+
+// Rectangle copies: the control channel writes one 4-word block per row into
+// the data channel's alias-1 registers (CTRL, READ_ADDR, WRITE_ADDR,
+// TRANS_COUNT_TRIG); each finished row chains back to the control channel.
+static int dma_copy_channel = -1;
+static int dma_copy_ctrl_channel = -1;
+static uint32_t (*copy_blocks)[4] = NULL;
+static volatile bool copy_busy = false;
+static void (*copy_callback)(void *) = NULL;
+static void *copy_callback_arg = NULL;
+static uintptr_t copy_src_lo, copy_src_hi; // In-flight extents [lo, hi)
+static uintptr_t copy_dst_lo, copy_dst_hi;
+
+static void dma_mem_copy_irq(void);
 
 void dma_mem_init(void) {
     if (dma_mem_channel != -1) return;
@@ -15,6 +33,21 @@ void dma_mem_init(void) {
     channel_config_set_write_increment(&cfg, true);  // Increment destination
     
     dma_channel_set_config(dma_mem_channel, &cfg, false);
+
+    // Sniffer channel: reads the range, discards writes into crc_sink
+    dma_crc_channel = dma_claim_unused_channel(true);
+
+    // Copy channel pair (control blocks need the arena)
+    dma_copy_channel = dma_claim_unused_channel(true);
+    dma_copy_ctrl_channel = dma_claim_unused_channel(true);
+    if (arena_is_initialized())
+        copy_blocks = arena_alloc(ARENA_TAG_DISPLAY,
+                                  (DMA_MEM_COPY_MAX_ROWS + 1) * 16, 16);
+
+    irq_add_shared_handler(DMA_IRQ_1, dma_mem_copy_irq,
+                           PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(DMA_IRQ_1, true);
+    dma_channel_set_irq1_enabled(dma_copy_channel, true);
 }
 
 void dma_mem_fill32(uint32_t *dest, uint32_t value, uint32_t count) {
@@ -36,3 +69,126 @@ void dma_mem_wait(void) {
     if (dma_mem_channel == -1) return;
     dma_channel_wait_for_finish_blocking(dma_mem_channel);
 }
+
+uint32_t dma_mem_crc32(const void *src, uint32_t len) {
+    bool words = (((uintptr_t)src | len) & 3) == 0;
+
+    dma_channel_config cfg = dma_channel_get_default_config(dma_crc_channel);
+    channel_config_set_transfer_data_size(&cfg, words ? DMA_SIZE_32 : DMA_SIZE_8);
+    channel_config_set_read_increment(&cfg, true);
+    channel_config_set_write_increment(&cfg, false);
+    channel_config_set_sniff_enable(&cfg, true);
+
+    dma_sniffer_enable(dma_crc_channel, DMA_SNIFF_CTRL_CALC_VALUE_CRC32, true);
+    dma_sniffer_set_data_accumulator(0xFFFFFFFF);
+    dma_channel_configure(dma_crc_channel, &cfg, &crc_sink, src,
+                          words ? len / 4 : len, true);
+    dma_channel_wait_for_finish_blocking(dma_crc_channel);
+
+    return dma_sniffer_get_data_accumulator();
+}
+
+// --- Rectangle Copies ---
+uint32_t dma_mem_get_arena_size(void) {
+    return arena_reserve_size((DMA_MEM_COPY_MAX_ROWS + 1) * 16, 16);
+}
+
+static void dma_mem_copy_irq(void) {
+    if (!dma_channel_get_irq1_status(dma_copy_channel))
+        return;
+    dma_channel_acknowledge_irq1(dma_copy_channel);
+
+    void (*callback)(void *) = copy_callback;
+    copy_callback = NULL;
+    copy_busy = false;
+    if (callback)
+        callback(copy_callback_arg);
+}
+
+static uint32_t copy_ctrl_value(enum dma_channel_transfer_size size,
+                                bool last) {
+    dma_channel_config c = dma_channel_get_default_config(dma_copy_channel);
+    channel_config_set_transfer_data_size(&c, size);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, true);
+    // Rows chain back to the control channel silently; the last row stops
+    // (chaining to itself) and raises the completion IRQ
+    channel_config_set_chain_to(&c, last ? dma_copy_channel
+                                         : dma_copy_ctrl_channel);
+    channel_config_set_irq_quiet(&c, !last);
+    return channel_config_get_ctrl_value(&c);
+}
+
+bool dma_mem_copy_rect(void *dst, uint32_t dst_stride, const void *src,
+                       uint32_t src_stride, uint32_t row_bytes, uint16_t rows,
+                       void (*callback)(void *), void *arg) {
+    if (copy_blocks == NULL || rows == 0 || row_bytes == 0 ||
+        rows > DMA_MEM_COPY_MAX_ROWS)
+        return false;
+
+    uintptr_t s = (uintptr_t)src;
+    uintptr_t d = (uintptr_t)dst;
+    uintptr_t src_end = s + (rows - 1) * src_stride + row_bytes;
+    uintptr_t dst_end = d + (rows - 1) * dst_stride + row_bytes;
+    bool overlap = d < src_end && s < dst_end;
+
+    // Overlap: a row moving right on its own row would overwrite unread
+    // source bytes; rows moving down must be copied bottom-up
+    if (overlap && d > s && d < s + row_bytes)
+        return false;
+    bool reverse = overlap && d > s;
+
+    uint32_t align = s | d | src_stride | dst_stride | row_bytes;
+    enum dma_channel_transfer_size size = DMA_SIZE_8;
+    if ((align & 3) == 0)
+        size = DMA_SIZE_32;
+    else if ((align & 1) == 0)
+        size = DMA_SIZE_16;
+    uint32_t count = row_bytes >> size;
+
+    dma_mem_copy_wait();
+
+    uint32_t ctrl = copy_ctrl_value(size, false);
+    for (uint16_t i = 0; i < rows; i++) {
+        uint16_t row = reverse ? (rows - 1 - i) : i;
+        copy_blocks[i][0] = (i == rows - 1) ? copy_ctrl_value(size, true) : ctrl;
+        copy_blocks[i][1] = s + row * src_stride;
+        copy_blocks[i][2] = d + row * dst_stride;
+        copy_blocks[i][3] = count;
+    }
+
+    copy_src_lo = s;
+    copy_src_hi = src_end;
+    copy_dst_lo = d;
+    copy_dst_hi = dst_end;
+    copy_callback = callback;
+    copy_callback_arg = arg;
+    copy_busy = true;
+
+    // 4 words per trigger into a 16-byte write ring over alias 1
+    dma_channel_config cc = dma_channel_get_default_config(dma_copy_ctrl_channel);
+    channel_config_set_transfer_data_size(&cc, DMA_SIZE_32);
+    channel_config_set_read_increment(&cc, true);
+    channel_config_set_write_increment(&cc, true);
+    channel_config_set_ring(&cc, true, 4);
+    dma_channel_configure(dma_copy_ctrl_channel, &cc,
+                          &dma_hw->ch[dma_copy_channel].al1_ctrl, copy_blocks,
+                          4, true);
+    return true;
+}
+
+bool dma_mem_copy_is_busy(void) { return copy_busy; }
+
+void dma_mem_copy_wait(void) {
+    while (copy_busy)
+        tight_loop_contents();
+}
+
+bool dma_mem_copy_in_flight(const void *ptr, uint32_t len) {
+    if (!copy_busy)
+        return false;
+    uintptr_t lo = (uintptr_t)ptr;
+    uintptr_t hi = lo + len;
+    return (lo < copy_src_hi && copy_src_lo < hi) ||
+           (lo < copy_dst_hi && copy_dst_lo < hi);
+}
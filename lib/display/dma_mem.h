@@ -15,4 +15,34 @@ bool dma_mem_is_busy(void);
 // Wait for memory DMA to complete
 void dma_mem_wait(void);
 
+// CRC32 of a memory range via the DMA sniffer (blocking, no CPU reads).
+// Word-aligned ranges use 32-bit transfers.
+uint32_t dma_mem_crc32(const void *src, uint32_t len);
+
+// --- Rectangle Copies ---
+// One control block per row is chained into a dedicated channel pair, so a
+// copy runs without the CPU. One copy is in flight at a time: until it
+// completes, the source rows must not be written and the destination rows
+// must not be read or written (check with dma_mem_copy_in_flight). The
+// callback runs in the DMA_IRQ_1 handler on the core that called init.
+
+#define DMA_MEM_COPY_MAX_ROWS 256
+
+// Arena bytes dma_mem_init() takes for the control blocks
+uint32_t dma_mem_get_arena_size(void);
+
+// Copy `rows` rows of `row_bytes` between strided regions. Waits for the
+// previous copy first. Overlapping regions are copied in a safe row order;
+// returns false for a same-row overlap that moves data to the right, for
+// more than DMA_MEM_COPY_MAX_ROWS rows, or without control-block storage.
+bool dma_mem_copy_rect(void *dst, uint32_t dst_stride, const void *src,
+                       uint32_t src_stride, uint32_t row_bytes, uint16_t rows,
+                       void (*callback)(void *), void *arg);
+
+bool dma_mem_copy_is_busy(void);
+void dma_mem_copy_wait(void);
+
+// True if [ptr, ptr + len) touches a region of the copy in flight
+bool dma_mem_copy_in_flight(const void *ptr, uint32_t len);
+
 #endif
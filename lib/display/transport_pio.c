@@ -1,14 +1,58 @@
 #include "transport_pio.h"
+#include "arena.h"
 #include "hardware/clocks.h"
 #include "hardware/gpio.h"
+#include "hardware/irq.h"
+#include "hardware/structs/scb.h"
+#include "hardware/sync.h"
 #include "spi.pio.h"
-#include <stdlib.h>
+
+// What the SM is shifting: command bytes, 16-bit pixels, 16-bit pixels
+// narrowed to RGB444 by the spi_rgb444_tx program, or the 4-bit pad that
+// completes an odd packed run
+typedef enum {
+  PIO_MODE_BYTES = 0,
+  PIO_MODE_PIXELS,
+  PIO_MODE_PIXELS_444,
+  PIO_MODE_PAD_444
+} pio_mode_t;
 
 typedef struct {
   transport_pio_config_t cfg;
+  dma_channel_config dma_cfg;   // Byte streaming (read increment, no ring)
+  dma_channel_config dma_cfg16; // Halfword streaming for native pixels
+  pio_mode_t mode;
+  bool pack444;   // send_buffer16/send_fill16 go out as RGB444
+  bool odd444;    // Packed pixels since the last pad end mid-byte
+  int offset444;  // spi_rgb444_tx load offset, -1 until first needed
   bool is_fast;
+  void (*on_complete)(void *);
+  void *on_complete_arg;
 } transport_pio_priv_t;
 
+// DMA_IRQ_0 is shared; only the last transport initialised is serviced
+static display_transport_t *irq_transport = NULL;
+
+// Completion IRQ, always enabled on the pixel channel so waits can sleep.
+// It wakes the core it runs on directly and the other core through SEV.
+static void transport_pio_dma_irq(void) {
+  transport_pio_priv_t *priv = (transport_pio_priv_t *)irq_transport->priv;
+  if (!dma_channel_get_irq0_status(priv->cfg.dma_chan))
+    return;
+  dma_channel_acknowledge_irq0(priv->cfg.dma_chan);
+  if (priv->on_complete)
+    priv->on_complete(priv->on_complete_arg);
+  __sev();
+}
+
+// Sleep until the channel has finished reading memory
+static void dma_sleep_until_done(uint chan) {
+  while (dma_channel_is_busy(chan))
+    __wfe();
+}
+
+// The FIFO tail is at most 8 words plus the OSR (a few microseconds of
+// wire time) and TXSTALL raises no interrupt, so this one still spins
 static void pio_wait_idle(PIO pio, uint sm) {
   while (!pio_sm_is_tx_fifo_empty(pio, sm))
     ;
@@ -18,6 +62,58 @@ static void pio_wait_idle(PIO pio, uint sm) {
     ;
 }
 
+// Bytes and pixels share spi_tx at an 8- or 16-bit autopull threshold: a
+// halfword written to the TX FIFO is replicated into both lanes, so the top
+// 16 bits shifted out (MSB first) are the pixel, high byte first. RGB444
+// packing runs spi_rgb444_tx instead. Switched only once the SM is idle; the
+// restart marks the OSR empty so no stale bits go out in the new mode.
+static void pio_set_mode(transport_pio_priv_t *priv, pio_mode_t mode) {
+  if (priv->mode == mode)
+    return;
+  PIO pio = priv->cfg.pio;
+  uint sm = priv->cfg.sm;
+  float div = priv->is_fast ? priv->cfg.div_fast : priv->cfg.div_init;
+
+  dma_sleep_until_done(priv->cfg.dma_chan);
+  pio_wait_idle(pio, sm);
+  pio_sm_set_enabled(pio, sm, false);
+
+  pio_sm_config c;
+  uint entry;
+  if (mode == PIO_MODE_PIXELS_444) {
+    c = spi_rgb444_tx_config(priv->offset444, priv->cfg.pin_sck,
+                             priv->cfg.pin_mosi, div);
+    entry = priv->offset444 + spi_rgb444_tx_offset_entry_point;
+  } else {
+    uint bits = mode == PIO_MODE_BYTES ? 8 : mode == PIO_MODE_PAD_444 ? 4 : 16;
+    c = spi_tx_config(priv->cfg.pio_offset, priv->cfg.pin_sck,
+                      priv->cfg.pin_mosi, bits, div);
+    entry = priv->cfg.pio_offset + spi_tx_offset_entry_point;
+  }
+  pio_sm_set_config(pio, sm, &c);
+  pio_sm_restart(pio, sm);
+  pio_sm_exec(pio, sm, pio_encode_jmp(entry));
+  pio_sm_set_enabled(pio, sm, true);
+  priv->mode = mode;
+}
+
+static pio_mode_t pixel_mode(const transport_pio_priv_t *priv) {
+  return priv->pack444 ? PIO_MODE_PIXELS_444 : PIO_MODE_PIXELS;
+}
+
+// Packed pixels are 12 wire bits, so an odd count ends half way into a byte
+// and the panel never latches the last pixel. Consecutive sends continue
+// the same pixel stream, so the pad goes out only where the stream ends:
+// before the next command byte or when the transfer is waited on. spi_tx
+// at a 4-bit autopull shifts out the top nibble of one FIFO word and stalls.
+static void pio_pad_444(transport_pio_priv_t *priv) {
+  if (!priv->odd444)
+    return;
+  priv->odd444 = false;
+  pio_set_mode(priv, PIO_MODE_PAD_444);
+  priv->cfg.pio->txf[priv->cfg.sm] = 0;
+}
+
 static void transport_pio_init(display_transport_t *self,
                                uint32_t speed_init_hz, uint32_t speed_fast_hz) {
   transport_pio_priv_t *priv = (transport_pio_priv_t *)self->priv;
@@ -55,6 +151,22 @@ static void transport_pio_init(display_transport_t *self,
   channel_config_set_write_increment(&c, false);
   channel_config_set_high_priority(&c, true);
   dma_channel_set_config(priv->cfg.dma_chan, &c, false);
+  priv->dma_cfg = c;
+
+  // Pixels move a halfword per transfer: half the bus transactions of the
+  // byte stream, with the wire order restored by the 16-bit autopull
+  channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
+  priv->dma_cfg16 = c;
+  priv->mode = PIO_MODE_BYTES;
+
+  // Completion IRQ on this core. SEVONPEND lets a pending completion end a
+  // WFE even while this core has interrupts masked.
+  irq_transport = self;
+  irq_add_shared_handler(DMA_IRQ_0, transport_pio_dma_irq,
+                         PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+  irq_set_enabled(DMA_IRQ_0, true);
+  dma_channel_set_irq0_enabled(priv->cfg.dma_chan, true);
+  scb_hw->scr |= M0PLUS_SCR_SEVONPEND_BITS;
 }
 
 static void transport_pio_set_speed(display_transport_t *self, bool fast) {
@@ -66,6 +178,8 @@ static void transport_pio_set_speed(display_transport_t *self, bool fast) {
 
 static void transport_pio_send_cmd(display_transport_t *self, uint8_t cmd) {
   transport_pio_priv_t *priv = (transport_pio_priv_t *)self->priv;
+  pio_pad_444(priv);
+  pio_set_mode(priv, PIO_MODE_BYTES);
   gpio_put(priv->cfg.pin_dc, 0);
   gpio_put(priv->cfg.pin_cs, 0);
   *((io_rw_8 *)&priv->cfg.pio->txf[priv->cfg.sm] + 3) = cmd;
@@ -75,6 +189,8 @@ static void transport_pio_send_cmd(display_transport_t *self, uint8_t cmd) {
 
 static void transport_pio_send_data8(display_transport_t *self, uint8_t data) {
   transport_pio_priv_t *priv = (transport_pio_priv_t *)self->priv;
+  pio_pad_444(priv);
+  pio_set_mode(priv, PIO_MODE_BYTES);
   gpio_put(priv->cfg.pin_dc, 1);
   gpio_put(priv->cfg.pin_cs, 0);
   *((io_rw_8 *)&priv->cfg.pio->txf[priv->cfg.sm] + 3) = data;
@@ -82,12 +198,33 @@ static void transport_pio_send_data8(display_transport_t *self, uint8_t data) {
   gpio_put(priv->cfg.pin_cs, 1);
 }
 
+// Slow-clock parameters without the per-byte drain and CS toggle of
+// send_data8: the FIFO keeps the wire busy, only the last byte is waited on
+static void transport_pio_send_data(display_transport_t *self,
+                                    const uint8_t *data, uint32_t len) {
+  transport_pio_priv_t *priv = (transport_pio_priv_t *)self->priv;
+  pio_pad_444(priv);
+  pio_set_mode(priv, PIO_MODE_BYTES);
+  gpio_put(priv->cfg.pin_dc, 1);
+  gpio_put(priv->cfg.pin_cs, 0);
+  for (uint32_t i = 0; i < len; i++) {
+    while (pio_sm_is_tx_fifo_full(priv->cfg.pio, priv->cfg.sm))
+      ;
+    *((io_rw_8 *)&priv->cfg.pio->txf[priv->cfg.sm] + 3) = data[i];
+  }
+  pio_wait_idle(priv->cfg.pio, priv->cfg.sm);
+  gpio_put(priv->cfg.pin_cs, 1);
+}
+
 static void transport_pio_send_buffer(display_transport_t *self,
                                       const uint8_t *data, uint32_t len) {
   transport_pio_priv_t *priv = (transport_pio_priv_t *)self->priv;
+  pio_pad_444(priv);
+  pio_set_mode(priv, PIO_MODE_BYTES);
   gpio_put(priv->cfg.pin_dc, 1);
   gpio_put(priv->cfg.pin_cs, 0);
 
+  dma_channel_set_config(priv->cfg.dma_chan, &priv->dma_cfg, false);
   dma_channel_set_read_addr(priv->cfg.dma_chan, data, false);
   dma_channel_set_write_addr(priv->cfg.dma_chan,
                              (uint8_t *)&priv->cfg.pio->txf[priv->cfg.sm] + 3,
@@ -95,9 +232,49 @@ static void transport_pio_send_buffer(display_transport_t *self,
   dma_channel_set_trans_count(priv->cfg.dma_chan, len, true);
 }
 
+static void transport_pio_send_buffer16(display_transport_t *self,
+                                        const uint16_t *data, uint32_t count) {
+  transport_pio_priv_t *priv = (transport_pio_priv_t *)self->priv;
+  pio_set_mode(priv, pixel_mode(priv));
+  priv->odd444 ^= priv->pack444 && (count & 1);
+  gpio_put(priv->cfg.pin_dc, 1);
+  gpio_put(priv->cfg.pin_cs, 0);
+
+  dma_channel_set_config(priv->cfg.dma_chan, &priv->dma_cfg16, false);
+  dma_channel_set_read_addr(priv->cfg.dma_chan, data, false);
+  dma_channel_set_write_addr(priv->cfg.dma_chan,
+                             &priv->cfg.pio->txf[priv->cfg.sm], false);
+  dma_channel_set_trans_count(priv->cfg.dma_chan, count, true);
+}
+
+static void transport_pio_send_fill16(display_transport_t *self,
+                                      const uint16_t *pixel, uint32_t count) {
+  transport_pio_priv_t *priv = (transport_pio_priv_t *)self->priv;
+  pio_set_mode(priv, pixel_mode(priv));
+  priv->odd444 ^= priv->pack444 && (count & 1);
+  gpio_put(priv->cfg.pin_dc, 1);
+  gpio_put(priv->cfg.pin_cs, 0);
+
+  // A 2-byte read ring re-reads the pixel, so one transfer covers any length
+  dma_channel_config c = priv->dma_cfg16;
+  channel_config_set_ring(&c, false, 1);
+  dma_channel_set_config(priv->cfg.dma_chan, &c, false);
+
+  dma_channel_set_read_addr(priv->cfg.dma_chan, pixel, false);
+  dma_channel_set_write_addr(priv->cfg.dma_chan,
+                             &priv->cfg.pio->txf[priv->cfg.sm], false);
+  dma_channel_set_trans_count(priv->cfg.dma_chan, count, true);
+}
+
+static void transport_pio_wait_ready(display_transport_t *self) {
+  transport_pio_priv_t *priv = (transport_pio_priv_t *)self->priv;
+  dma_sleep_until_done(priv->cfg.dma_chan);
+}
+
 static void transport_pio_wait(display_transport_t *self) {
   transport_pio_priv_t *priv = (transport_pio_priv_t *)self->priv;
-  dma_channel_wait_for_finish_blocking(priv->cfg.dma_chan);
+  dma_sleep_until_done(priv->cfg.dma_chan);
+  pio_pad_444(priv);
   pio_wait_idle(priv->cfg.pio, priv->cfg.sm);
   gpio_put(priv->cfg.pin_cs, 1);
 }
@@ -108,21 +285,66 @@ static bool transport_pio_is_busy(display_transport_t *self) {
          !pio_sm_is_tx_fifo_empty(priv->cfg.pio, priv->cfg.sm);
 }
 
+static bool transport_pio_set_rgb444_packing(display_transport_t *self,
+                                             bool enable) {
+  transport_pio_priv_t *priv = (transport_pio_priv_t *)self->priv;
+  if (enable && priv->offset444 < 0) {
+    // Loaded on first use: 24 instructions next to spi_tx
+    if (!pio_can_add_program(priv->cfg.pio, &spi_rgb444_tx_program))
+      return false;
+    priv->offset444 = pio_add_program(priv->cfg.pio, &spi_rgb444_tx_program);
+  }
+  pio_pad_444(priv); // The run in flight was sent in the old mode
+  priv->pack444 = enable;
+  return true;
+}
+
+uint32_t transport_pio_get_arena_size(void) {
+  return arena_reserve_size(sizeof(display_transport_t), 4) +
+         arena_reserve_size(sizeof(transport_pio_priv_t), 4);
+}
+
+static void transport_pio_set_complete_callback(display_transport_t *self,
+                                                void (*callback)(void *),
+                                                void *arg) {
+  transport_pio_priv_t *priv = (transport_pio_priv_t *)self->priv;
+  uint32_t irq_state = save_and_disable_interrupts();
+  priv->on_complete = callback;
+  priv->on_complete_arg = arg;
+  restore_interrupts(irq_state);
+}
+
 display_transport_t *
 transport_pio_create(const transport_pio_config_t *config) {
-  display_transport_t *t = malloc(sizeof(display_transport_t));
-  transport_pio_priv_t *priv = malloc(sizeof(transport_pio_priv_t));
+  display_transport_t *t =
+      arena_alloc(ARENA_TAG_DISPLAY, sizeof(display_transport_t), 4);
+  transport_pio_priv_t *priv =
+      arena_alloc(ARENA_TAG_DISPLAY, sizeof(transport_pio_priv_t), 4);
+  if (!t || !priv)
+    return NULL;
 
   priv->cfg = *config;
+  priv->mode = PIO_MODE_BYTES;
+  priv->pack444 = false;
+  priv->odd444 = false;
+  priv->offset444 = -1;
   priv->is_fast = false;
+  priv->on_complete = NULL;
+  priv->on_complete_arg = NULL;
 
   t->init = transport_pio_init;
   t->set_speed = transport_pio_set_speed;
   t->send_cmd = transport_pio_send_cmd;
   t->send_data8 = transport_pio_send_data8;
+  t->send_data = transport_pio_send_data;
   t->send_buffer = transport_pio_send_buffer;
+  t->send_buffer16 = transport_pio_send_buffer16;
+  t->send_fill16 = transport_pio_send_fill16;
+  t->set_rgb444_packing = transport_pio_set_rgb444_packing;
   t->wait = transport_pio_wait;
+  t->wait_ready = transport_pio_wait_ready;
   t->is_busy = transport_pio_is_busy;
+  t->set_complete_callback = transport_pio_set_complete_callback;
   t->priv = priv;
 
   return t;
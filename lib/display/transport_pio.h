@@ -18,6 +18,10 @@ typedef struct {
   float div_fast;
 } transport_pio_config_t;
 
+// Allocates from the engine arena (see arena.h); NULL if it does not fit
 display_transport_t *transport_pio_create(const transport_pio_config_t *config);
 
+// Arena bytes consumed by one transport_pio_create()
+uint32_t transport_pio_get_arena_size(void);
+
 #endif
@@ -0,0 +1,185 @@
+#include "xip_stream.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/regs/addressmap.h"
+#include "hardware/structs/xip_ctrl.h"
+#include "system_config.h"
+
+// STREAM_CTR is a 22-bit word count
+#define XIP_STREAM_MAX_WORDS 0x3FFFFFu
+
+typedef struct {
+  uint8_t *dst;
+  const uint8_t *src;
+  uint32_t dst_stride;
+  uint32_t src_stride;
+  uint32_t row_words;
+  uint16_t rows;
+  void (*done)(void *);
+  void *arg;
+} stream_job_t;
+
+static int stream_channel = -1;
+static stream_job_t jobs[XIP_STREAM_QUEUE_LEN];
+
+// Tickets start at 1 (0 reports a rejected copy). Jobs [completed,
+// submitted) are queued; the one numbered `completed` is streaming.
+static uint32_t submitted = 1;
+static volatile uint32_t completed = 1;
+static uint16_t current_row;
+
+static void start_row(const stream_job_t *job, uint16_t row) {
+  // Drop anything an earlier stream left in the FIFO
+  while (!(xip_ctrl_hw->stat & XIP_STAT_FIFO_EMPTY_BITS))
+    (void)xip_ctrl_hw->stream_fifo;
+
+  xip_ctrl_hw->stream_addr = (uintptr_t)(job->src + row * job->src_stride);
+  xip_ctrl_hw->stream_ctr = job->row_words;
+  dma_channel_set_write_addr(stream_channel, job->dst + row * job->dst_stride,
+                             false);
+  dma_channel_set_trans_count(stream_channel, job->row_words, true);
+}
+
+static void xip_stream_irq(void) {
+  if (!dma_channel_get_irq1_status(stream_channel))
+    return;
+  dma_channel_acknowledge_irq1(stream_channel);
+
+  const stream_job_t *job = &jobs[completed % XIP_STREAM_QUEUE_LEN];
+  if (++current_row < job->rows) {
+    start_row(job, current_row);
+    return;
+  }
+
+  void (*done)(void *) = job->done;
+  void *arg = job->arg;
+  completed++;
+  current_row = 0;
+  if (completed != submitted)
+    start_row(&jobs[completed % XIP_STREAM_QUEUE_LEN], 0);
+  __sev(); // Wake a waiter on the other core
+  if (done)
+    done(arg);
+}
+
+void xip_stream_init(void) {
+  if (stream_channel != -1)
+    return;
+  stream_channel = dma_claim_unused_channel(true);
+
+  dma_channel_config cfg = dma_channel_get_default_config(stream_channel);
+  channel_config_set_transfer_data_size(&cfg, DMA_SIZE_32);
+  channel_config_set_read_increment(&cfg, false); // The FIFO
+  channel_config_set_write_increment(&cfg, true);
+  channel_config_set_dreq(&cfg, DREQ_XIP_STREAM);
+  dma_channel_configure(stream_channel, &cfg, NULL,
+                        (const void *)XIP_AUX_BASE, 0, false);
+
+  irq_add_shared_handler(DMA_IRQ_1, xip_stream_irq,
+                         PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+  irq_set_enabled(DMA_IRQ_1, true);
+  dma_channel_set_irq1_enabled(stream_channel, true);
+}
+
+uint32_t xip_stream_copy_rect(void *dst, uint32_t dst_stride,
+                              const void *src, uint32_t src_stride,
+                              uint32_t row_bytes, uint16_t rows,
+                              void (*done)(void *), void *arg) {
+  // The source must be flash: any of the four 16 MB XIP aliases
+  bool flash = ((uintptr_t)src - XIP_BASE) < 4 * 0x01000000u;
+  if (!flash || rows == 0 || row_bytes == 0 ||
+      (((uintptr_t)dst | (uintptr_t)src | dst_stride | src_stride |
+        row_bytes) & 3))
+    return 0;
+  xip_stream_init();
+
+  stream_job_t job = {(uint8_t *)dst, (const uint8_t *)src, dst_stride,
+                      src_stride, row_bytes / 4, rows, done, arg};
+  // Back-to-back rows on both sides: one stream, one IRQ
+  if (rows > 1 && row_bytes == dst_stride && row_bytes == src_stride &&
+      job.row_words * rows <= XIP_STREAM_MAX_WORDS) {
+    job.row_words *= rows;
+    job.rows = 1;
+  }
+
+  if (submitted - completed >= XIP_STREAM_QUEUE_LEN)
+    xip_stream_wait_job(submitted - XIP_STREAM_QUEUE_LEN);
+
+  uint32_t irq = save_and_disable_interrupts();
+  uint32_t ticket = submitted++;
+  jobs[ticket % XIP_STREAM_QUEUE_LEN] = job;
+  if (ticket == completed) { // Queue was idle
+    current_row = 0;
+    start_row(&jobs[ticket % XIP_STREAM_QUEUE_LEN], 0);
+  }
+  restore_interrupts(irq);
+  return ticket;
+}
+
+bool xip_stream_job_done(uint32_t ticket) {
+  return (int32_t)(completed - ticket) > 0;
+}
+
+void xip_stream_wait_job(uint32_t ticket) {
+  if (xip_stream_job_done(ticket))
+    return;
+  uint32_t start = system_idle_begin();
+  while (!xip_stream_job_done(ticket))
+    __wfe(); // Each completion IRQ wakes us
+  system_idle_end(start);
+}
+
+bool xip_stream_is_busy(void) { return completed != submitted; }
+
+void xip_stream_wait(void) { xip_stream_wait_job(submitted - 1); }
+
+// --- Double-Buffered Reader ---
+static void reader_fill(xip_stream_reader_t *r, int i) {
+  uint32_t n = r->remaining < r->chunk ? r->remaining : r->chunk;
+  r->len[i] = n;
+  if (n == 0)
+    return;
+  // A short last chunk is read up to the next word
+  r->ticket[i] = xip_stream_copy(r->buf[i], r->src, (n + 3) & ~3u, NULL,
+                                 NULL);
+  r->src += n;
+  r->remaining -= n;
+}
+
+void xip_stream_reader_open(xip_stream_reader_t *r, const void *src,
+                            uint32_t len, void *buf0, void *buf1,
+                            uint32_t chunk) {
+  r->src = (const uint8_t *)src;
+  r->remaining = len;
+  r->chunk = chunk;
+  r->buf[0] = (uint8_t *)buf0;
+  r->buf[1] = (uint8_t *)buf1;
+  r->held = -1;
+  reader_fill(r, 0);
+  reader_fill(r, 1);
+}
+
+const void *xip_stream_reader_next(xip_stream_reader_t *r, uint32_t *len) {
+  // The caller is done with the last chunk: refill it behind the next one
+  if (r->held >= 0)
+    reader_fill(r, r->held);
+
+  int i = r->held < 0 ? 0 : r->held ^ 1;
+  if (r->len[i] == 0) {
+    *len = 0;
+    return NULL;
+  }
+  xip_stream_wait_job(r->ticket[i]);
+  r->held = (int8_t)i;
+  *len = r->len[i];
+  return r->buf[i];
+}
+
+void xip_stream_reader_close(xip_stream_reader_t *r) {
+  for (int i = 0; i < 2; i++) {
+    if (r->len[i])
+      xip_stream_wait_job(r->ticket[i]);
+    r->len[i] = 0;
+  }
+  r->remaining = 0;
+}
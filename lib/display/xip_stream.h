@@ -0,0 +1,74 @@
+#ifndef XIP_STREAM_H
+#define XIP_STREAM_H
+
+#include "pico/stdlib.h"
+
+/**
+ * XIP Streaming Loader
+ * Flash-to-RAM copies through the XIP controller's streaming FIFO, drained
+ * by a DMA channel on DREQ_XIP_STREAM. Stream reads bypass the 16 KB XIP
+ * cache, so a large asset burst does not evict the code running from
+ * flash, and the copy runs in the background while both cores render.
+ *
+ * Copies are queued (XIP_STREAM_QUEUE_LEN deep) and identified by tickets,
+ * like render service jobs. Each completes in the DMA_IRQ_1 handler of the
+ * core that called xip_stream_init(); submit from that core. Sources must
+ * be flash (XIP) addresses; addresses, strides and row lengths must be
+ * word multiples. One stream runs at a time: cached flash reads still work
+ * alongside it.
+ */
+
+#define XIP_STREAM_QUEUE_LEN 4
+
+void xip_stream_init(void);
+
+// Queue a copy of `rows` rows of `row_bytes` between strided regions
+// (contiguous ones run as a single stream; others take one IRQ per row).
+// Blocks only while the queue is full. `done` runs from the IRQ.
+// Returns the ticket, or 0 for a source outside flash or arguments that
+// are not word aligned.
+uint32_t xip_stream_copy_rect(void *dst, uint32_t dst_stride,
+                              const void *src, uint32_t src_stride,
+                              uint32_t row_bytes, uint16_t rows,
+                              void (*done)(void *), void *arg);
+
+static inline uint32_t xip_stream_copy(void *dst, const void *src,
+                                       uint32_t len, void (*done)(void *),
+                                       void *arg) {
+  return xip_stream_copy_rect(dst, len, src, len, len, 1, done, arg);
+}
+
+// Completion by ticket (sleeps in WFE)
+bool xip_stream_job_done(uint32_t ticket);
+void xip_stream_wait_job(uint32_t ticket);
+
+bool xip_stream_is_busy(void);
+void xip_stream_wait(void);
+
+// --- Double-Buffered Reader ---
+// Streams `len` bytes in `chunk`-byte pieces into two caller buffers: the
+// caller processes one while the next fills. Chunks and the source must be
+// word aligned; each buffer holds `chunk` bytes.
+typedef struct {
+  const uint8_t *src;
+  uint32_t remaining; // Bytes not yet requested
+  uint32_t chunk;
+  uint8_t *buf[2];
+  uint32_t len[2];    // Bytes requested into each buffer (0: none)
+  uint32_t ticket[2];
+  int8_t held;        // Buffer returned by the last next() (-1: none)
+} xip_stream_reader_t;
+
+void xip_stream_reader_open(xip_stream_reader_t *r, const void *src,
+                            uint32_t len, void *buf0, void *buf1,
+                            uint32_t chunk);
+
+// Wait for the next chunk and return it (NULL at the end); starts the
+// refill of the chunk returned by the previous call, which must no longer
+// be in use
+const void *xip_stream_reader_next(xip_stream_reader_t *r, uint32_t *len);
+
+// Stop early: waits for the reads in flight so the buffers can be reused
+void xip_stream_reader_close(xip_stream_reader_t *r);
+
+#endif
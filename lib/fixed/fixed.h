@@ -0,0 +1,149 @@
+#ifndef FIXED_H
+#define FIXED_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Fixed-Point Math
+ * The M0+ cores have no FPU, so every float add, multiply or compare is a
+ * soft-float call. These types keep simulation state in integers:
+ *   fx16_t  16.16 (+-32768, step 1/65536): positions, velocities, vectors
+ *   fx8_t   24.8  (+-8388608, step 1/256): wide ranges, 32-bit divides
+ *   fx_angle_t  binary angle, 65536 units per turn (wraps for free)
+ *
+ * Multiplies are built from 16x16 partial products (MULS is single-cycle;
+ * a 32x32->64 multiply is a library call). Divides go through the SIO
+ * hardware divider, which the SDK routes 32-bit '/' to. Results that do not
+ * fit wrap unless the function is marked _sat.
+ */
+
+typedef int32_t fx16_t;
+typedef int32_t fx8_t;
+typedef uint16_t fx_angle_t;
+
+#define FX16_ONE ((fx16_t)0x10000)
+#define FX16_HALF ((fx16_t)0x8000)
+#define FX16_MAX INT32_MAX
+#define FX16_MIN INT32_MIN
+#define FX8_ONE ((fx8_t)0x100)
+
+// Constants from literals (folded by the compiler; not for runtime floats)
+#define FX16_CONST(f) ((fx16_t)((f) * 65536.0 + ((f) >= 0 ? 0.5 : -0.5)))
+#define FX8_CONST(f) ((fx8_t)((f) * 256.0 + ((f) >= 0 ? 0.5 : -0.5)))
+#define FX_ANGLE_DEG(d) ((fx_angle_t)(int32_t)((d) * 65536.0 / 360.0))
+
+// --- Conversion ---
+static inline fx16_t fx16_from_int(int32_t i) {
+  return (fx16_t)((uint32_t)i << 16);
+}
+static inline int32_t fx16_floor(fx16_t a) { return a >> 16; }
+static inline int32_t fx16_ceil(fx16_t a) { return (a + 0xFFFF) >> 16; }
+static inline int32_t fx16_round(fx16_t a) { return (a + FX16_HALF) >> 16; }
+static inline fx16_t fx16_frac(fx16_t a) { return a & 0xFFFF; }
+
+static inline fx8_t fx8_from_int(int32_t i) {
+  return (fx8_t)((uint32_t)i << 8);
+}
+static inline int32_t fx8_floor(fx8_t a) { return a >> 8; }
+static inline int32_t fx8_round(fx8_t a) { return (a + 0x80) >> 8; }
+
+static inline fx8_t fx16_to_fx8(fx16_t a) { return a >> 8; }
+static inline fx16_t fx8_to_fx16(fx8_t a) {
+  return (fx16_t)((uint32_t)a << 8);
+}
+
+// --- Arithmetic ---
+// floor(a * b / 2^shift) mod 2^32 from four 32-bit partial products
+static inline int32_t fx_mul_shift(int32_t a, int32_t b, int shift) {
+  uint32_t mask = (1u << shift) - 1;
+  uint32_t ah = (uint32_t)(a >> shift), bh = (uint32_t)(b >> shift);
+  uint32_t al = (uint32_t)a & mask, bl = (uint32_t)b & mask;
+  return (int32_t)(((ah * bh) << shift) + ah * bl + al * bh +
+                   ((al * bl) >> shift));
+}
+
+static inline fx16_t fx16_mul(fx16_t a, fx16_t b) {
+  return fx_mul_shift(a, b, 16);
+}
+static inline fx8_t fx8_mul(fx8_t a, fx8_t b) { return fx_mul_shift(a, b, 8); }
+
+// a * b with b an integer (plain multiply, no shift)
+static inline fx16_t fx16_muli(fx16_t a, int32_t b) { return a * b; }
+
+fx16_t fx16_div(fx16_t a, fx16_t b); // Saturates on overflow and b == 0
+fx8_t fx8_div(fx8_t a, fx8_t b);     // One hardware divide for |a| < 32768
+fx16_t fx16_recip(fx16_t a);         // 1 / a, one hardware divide
+fx16_t fx16_sqrt(fx16_t a);          // 0 for a <= 0
+uint16_t fx_isqrt(uint32_t v);       // floor(sqrt(v)) for plain integers
+uint32_t fx_isqrt64(uint64_t v);     // Same, 64-bit (shifts and adds only)
+
+static inline fx16_t fx16_abs(fx16_t a) { return a < 0 ? -a : a; }
+static inline fx16_t fx16_min(fx16_t a, fx16_t b) { return a < b ? a : b; }
+static inline fx16_t fx16_max(fx16_t a, fx16_t b) { return a > b ? a : b; }
+static inline fx16_t fx16_clamp(fx16_t a, fx16_t lo, fx16_t hi) {
+  return a < lo ? lo : (a > hi ? hi : a);
+}
+// a + (b - a) * t, t in 0..FX16_ONE
+static inline fx16_t fx16_lerp(fx16_t a, fx16_t b, fx16_t t) {
+  return a + fx16_mul(b - a, t);
+}
+
+// --- Saturating ---
+static inline fx16_t fx16_add_sat(fx16_t a, fx16_t b) {
+  int32_t r;
+  if (__builtin_add_overflow(a, b, &r))
+    return a < 0 ? FX16_MIN : FX16_MAX;
+  return r;
+}
+static inline fx16_t fx16_sub_sat(fx16_t a, fx16_t b) {
+  int32_t r;
+  if (__builtin_sub_overflow(a, b, &r))
+    return a < 0 ? FX16_MIN : FX16_MAX;
+  return r;
+}
+fx16_t fx16_mul_sat(fx16_t a, fx16_t b); // 64-bit product (slow path)
+
+// --- Trigonometry (table-driven, linear interpolation) ---
+fx16_t fx_sin(fx_angle_t a);
+static inline fx16_t fx_cos(fx_angle_t a) {
+  return fx_sin((fx_angle_t)(a + 0x4000));
+}
+// Angle of (x, y) from the +x axis; any common scale (fx16, fx8, int)
+fx_angle_t fx_atan2(int32_t y, int32_t x);
+
+// --- 2D Vectors ---
+typedef struct {
+  fx16_t x, y;
+} vec2_t;
+
+static inline vec2_t vec2(fx16_t x, fx16_t y) { return (vec2_t){x, y}; }
+static inline vec2_t vec2_add(vec2_t a, vec2_t b) {
+  return (vec2_t){a.x + b.x, a.y + b.y};
+}
+static inline vec2_t vec2_sub(vec2_t a, vec2_t b) {
+  return (vec2_t){a.x - b.x, a.y - b.y};
+}
+static inline vec2_t vec2_scale(vec2_t v, fx16_t s) {
+  return (vec2_t){fx16_mul(v.x, s), fx16_mul(v.y, s)};
+}
+static inline fx16_t vec2_dot(vec2_t a, vec2_t b) {
+  return fx16_mul(a.x, b.x) + fx16_mul(a.y, b.y);
+}
+static inline fx16_t vec2_cross(vec2_t a, vec2_t b) {
+  return fx16_mul(a.x, b.y) - fx16_mul(a.y, b.x);
+}
+static inline vec2_t vec2_from_angle(fx_angle_t a, fx16_t length) {
+  return (vec2_t){fx16_mul(fx_cos(a), length), fx16_mul(fx_sin(a), length)};
+}
+static inline vec2_t vec2_rotate(vec2_t v, fx_angle_t a) {
+  fx16_t c = fx_cos(a), s = fx_sin(a);
+  return (vec2_t){fx16_mul(v.x, c) - fx16_mul(v.y, s),
+                  fx16_mul(v.x, s) + fx16_mul(v.y, c)};
+}
+static inline fx_angle_t vec2_angle(vec2_t v) { return fx_atan2(v.y, v.x); }
+
+fx16_t vec2_length(vec2_t v); // No intermediate overflow
+vec2_t vec2_normalize(vec2_t v); // Zero vector stays zero
+
+#endif
@@ -0,0 +1,56 @@
+#include "mat4.h"
+
+vec3_t vec3_normalize(vec3_t v) {
+  int64_t x = v.x, y = v.y, z = v.z;
+  uint32_t len = fx_isqrt64((uint64_t)(x * x) + (uint64_t)(y * y) +
+                            (uint64_t)(z * z));
+  if (len == 0)
+    return v;
+  return (vec3_t){fx16_div(v.x, (fx16_t)len), fx16_div(v.y, (fx16_t)len),
+                  fx16_div(v.z, (fx16_t)len)};
+}
+
+mat4_t mat4_identity(void) {
+  return (mat4_t){
+      {{FX16_ONE, 0, 0, 0}, {0, FX16_ONE, 0, 0}, {0, 0, FX16_ONE, 0}}};
+}
+
+mat4_t mat4_translation(fx16_t x, fx16_t y, fx16_t z) {
+  mat4_t m = mat4_identity();
+  m.m[0][3] = x;
+  m.m[1][3] = y;
+  m.m[2][3] = z;
+  return m;
+}
+
+mat4_t mat4_scaling(fx16_t s) {
+  return (mat4_t){{{s, 0, 0, 0}, {0, s, 0, 0}, {0, 0, s, 0}}};
+}
+
+mat4_t mat4_rotation_x(fx_angle_t a) {
+  fx16_t c = fx_cos(a), s = fx_sin(a);
+  return (mat4_t){{{FX16_ONE, 0, 0, 0}, {0, c, -s, 0}, {0, s, c, 0}}};
+}
+
+mat4_t mat4_rotation_y(fx_angle_t a) {
+  fx16_t c = fx_cos(a), s = fx_sin(a);
+  return (mat4_t){{{c, 0, s, 0}, {0, FX16_ONE, 0, 0}, {-s, 0, c, 0}}};
+}
+
+mat4_t mat4_rotation_z(fx_angle_t a) {
+  fx16_t c = fx_cos(a), s = fx_sin(a);
+  return (mat4_t){{{c, -s, 0, 0}, {s, c, 0, 0}, {0, 0, FX16_ONE, 0}}};
+}
+
+mat4_t mat4_mul(const mat4_t *a, const mat4_t *b) {
+  mat4_t r;
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 4; j++) {
+      fx16_t v = fx16_mul(a->m[i][0], b->m[0][j]) +
+                 fx16_mul(a->m[i][1], b->m[1][j]) +
+                 fx16_mul(a->m[i][2], b->m[2][j]);
+      r.m[i][j] = (j == 3) ? v + a->m[i][3] : v;
+    }
+  }
+  return r;
+}
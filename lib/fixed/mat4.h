@@ -0,0 +1,73 @@
+#ifndef MAT4_H
+#define MAT4_H
+
+#include "fixed.h"
+
+/**
+ * 3D Vectors and Transforms
+ * 16.16 vectors and affine matrices for the 3D pipeline. A mat4_t stores
+ * the top three rows of a 4x4 matrix (rotation/scale | translation); the
+ * bottom row is always 0 0 0 1, so a point transform is 9 multiplies.
+ */
+
+typedef struct {
+  fx16_t x, y, z;
+} vec3_t;
+
+typedef struct {
+  fx16_t m[3][4];
+} mat4_t;
+
+static inline vec3_t vec3(fx16_t x, fx16_t y, fx16_t z) {
+  return (vec3_t){x, y, z};
+}
+static inline vec3_t vec3_add(vec3_t a, vec3_t b) {
+  return (vec3_t){a.x + b.x, a.y + b.y, a.z + b.z};
+}
+static inline vec3_t vec3_sub(vec3_t a, vec3_t b) {
+  return (vec3_t){a.x - b.x, a.y - b.y, a.z - b.z};
+}
+static inline vec3_t vec3_scale(vec3_t v, fx16_t s) {
+  return (vec3_t){fx16_mul(v.x, s), fx16_mul(v.y, s), fx16_mul(v.z, s)};
+}
+static inline fx16_t vec3_dot(vec3_t a, vec3_t b) {
+  return fx16_mul(a.x, b.x) + fx16_mul(a.y, b.y) + fx16_mul(a.z, b.z);
+}
+static inline vec3_t vec3_cross(vec3_t a, vec3_t b) {
+  return (vec3_t){fx16_mul(a.y, b.z) - fx16_mul(a.z, b.y),
+                  fx16_mul(a.z, b.x) - fx16_mul(a.x, b.z),
+                  fx16_mul(a.x, b.y) - fx16_mul(a.y, b.x)};
+}
+vec3_t vec3_normalize(vec3_t v); // Zero vector stays zero
+
+// Builders
+mat4_t mat4_identity(void);
+mat4_t mat4_translation(fx16_t x, fx16_t y, fx16_t z);
+mat4_t mat4_scaling(fx16_t s);
+mat4_t mat4_rotation_x(fx_angle_t a);
+mat4_t mat4_rotation_y(fx_angle_t a);
+mat4_t mat4_rotation_z(fx_angle_t a);
+
+// a * b: applies b first, then a
+mat4_t mat4_mul(const mat4_t *a, const mat4_t *b);
+
+// Point (with translation) and direction (without)
+static inline vec3_t mat4_transform(const mat4_t *m, vec3_t v) {
+  return (vec3_t){
+      fx16_mul(m->m[0][0], v.x) + fx16_mul(m->m[0][1], v.y) +
+          fx16_mul(m->m[0][2], v.z) + m->m[0][3],
+      fx16_mul(m->m[1][0], v.x) + fx16_mul(m->m[1][1], v.y) +
+          fx16_mul(m->m[1][2], v.z) + m->m[1][3],
+      fx16_mul(m->m[2][0], v.x) + fx16_mul(m->m[2][1], v.y) +
+          fx16_mul(m->m[2][2], v.z) + m->m[2][3]};
+}
+static inline vec3_t mat4_rotate(const mat4_t *m, vec3_t v) {
+  return (vec3_t){fx16_mul(m->m[0][0], v.x) + fx16_mul(m->m[0][1], v.y) +
+                      fx16_mul(m->m[0][2], v.z),
+                  fx16_mul(m->m[1][0], v.x) + fx16_mul(m->m[1][1], v.y) +
+                      fx16_mul(m->m[1][2], v.z),
+                  fx16_mul(m->m[2][0], v.x) + fx16_mul(m->m[2][1], v.y) +
+                      fx16_mul(m->m[2][2], v.z)};
+}
+
+#endif
@@ -0,0 +1,262 @@
+#include "asset.h"
+#include "hardware/regs/addressmap.h"
+#include "occlusion.h"
+#include "xip_stream.h"
+#include <string.h>
+
+// Bytes of one stored line before padding
+static uint32_t line_bytes(const asset_t *a) {
+  uint32_t n = a->layout == SURFACE_LAYOUT_COLUMN_MAJOR ? a->height : a->width;
+  if (a->format == ASSET_FORMAT_RGB565)
+    return n * 2;
+  if (a->format == ASSET_FORMAT_RGB444)
+    return (n * 3 + 1) / 2;
+  return n;
+}
+
+// line_indexed looks indices up without a bounds check, so every stored
+// index (bar a colour key, which is never looked up) must be in the palette.
+// Frames are contiguous, so this is one pass over all their lines.
+static bool indices_in_palette(const asset_t *a) {
+  uint32_t lines = a->frame_count * (a->frame_bytes / a->stride);
+  uint32_t n = line_bytes(a);
+  bool keyed = a->flags & ASSET_FLAG_COLOR_KEY;
+  uint8_t key = (uint8_t)a->color_key;
+  const uint8_t *line = asset_frame(a, 0);
+  for (uint32_t l = 0; l < lines; l++, line += a->stride)
+    for (uint32_t i = 0; i < n; i++)
+      if (line[i] >= a->palette_count && !(keyed && line[i] == key))
+        return false;
+  return true;
+}
+
+const asset_t *asset_map(const void *data) {
+  const asset_t *a = (const asset_t *)data;
+  if (a == NULL || ((uintptr_t)a & 3) || a->magic != ASSET_MAGIC)
+    return NULL;
+  if (a->format != ASSET_FORMAT_RGB565 && a->format != ASSET_FORMAT_RGB444 &&
+      a->format != ASSET_FORMAT_RGB332 && a->format != ASSET_FORMAT_INDEXED8)
+    return NULL;
+  if (a->type > ASSET_TYPE_FONT || a->layout > SURFACE_LAYOUT_COLUMN_MAJOR ||
+      a->frame_count == 0)
+    return NULL;
+
+  uint32_t lines =
+      a->layout == SURFACE_LAYOUT_COLUMN_MAJOR ? a->width : a->height;
+  if ((a->stride % ASSET_LINE_ALIGN) || a->stride < line_bytes(a) ||
+      a->frame_bytes != a->stride * lines)
+    return NULL;
+  if (a->pixels_offset < sizeof(asset_t) || (a->pixels_offset & 3))
+    return NULL;
+  if (a->format == ASSET_FORMAT_INDEXED8 &&
+      (a->palette_offset < sizeof(asset_t) || (a->palette_offset & 3) ||
+       a->palette_count == 0 || a->palette_count > 256))
+    return NULL;
+  if (a->format == ASSET_FORMAT_INDEXED8 && a->palette_count < 256 &&
+      !indices_in_palette(a))
+    return NULL;
+  return a;
+}
+
+const asset_t *asset_map_flash(uint32_t offset) {
+  return asset_map((const void *)(XIP_BASE + offset));
+}
+
+// --- Line kernels ---
+// RGB444 pixel i of a packed array as 0x0RGB
+static inline uint16_t get444(const uint8_t *px, uint32_t i) {
+  const uint8_t *p = px + (i >> 1) * 3;
+  return (i & 1) ? ((p[1] & 0x0F) << 8) | p[2] : (p[0] << 4) | (p[1] >> 4);
+}
+
+static inline void put444(uint8_t *px, uint32_t i, uint16_t v) {
+  uint8_t *p = px + (i >> 1) * 3;
+  if (i & 1) {
+    p[1] = (p[1] & 0xF0) | (v >> 8);
+    p[2] = (uint8_t)v;
+  } else {
+    p[0] = (uint8_t)(v >> 4);
+    p[1] = ((v & 0x0F) << 4) | (p[1] & 0x0F);
+  }
+}
+
+static inline uint16_t rgb565_to_444(uint16_t c) {
+  return ((c >> 4) & 0xF00) | ((c >> 3) & 0x0F0) | ((c >> 1) & 0x00F);
+}
+
+// Copy `len` pixels from source position sp to destination index di
+static void line565(uint8_t *pixels, uint32_t di, const uint8_t *src, int sp,
+                    int len, const asset_t *a) {
+  uint16_t *d = (uint16_t *)pixels + di;
+  const uint16_t *s = (const uint16_t *)src + sp;
+  if (!(a->flags & ASSET_FLAG_COLOR_KEY)) {
+    memcpy(d, s, len * 2);
+    return;
+  }
+  uint16_t key = (uint16_t)a->color_key;
+  for (int i = 0; i < len; i++)
+    if (s[i] != key)
+      d[i] = s[i];
+}
+
+static void line444(uint8_t *pixels, uint32_t di, const uint8_t *src, int sp,
+                    int len, const asset_t *a) {
+  bool keyed = a->flags & ASSET_FLAG_COLOR_KEY;
+  if (!keyed && !(di & 1) && !(sp & 1)) {
+    // Both ends start on a pair: whole pairs are a byte copy
+    memcpy(pixels + (di >> 1) * 3, src + (sp >> 1) * 3, (len >> 1) * 3);
+    if (len & 1)
+      put444(pixels, di + len - 1, get444(src, sp + len - 1));
+    return;
+  }
+  uint16_t key = (uint16_t)a->color_key;
+  for (int i = 0; i < len; i++) {
+    uint16_t v = get444(src, sp + i);
+    if (!keyed || v != key)
+      put444(pixels, di + i, v);
+  }
+}
+
+// RGB332 and INDEXED8: one byte per pixel
+static void line8(uint8_t *pixels, uint32_t di, const uint8_t *src, int sp,
+                  int len, const asset_t *a) {
+  uint8_t *d = pixels + di;
+  const uint8_t *s = src + sp;
+  if (!(a->flags & ASSET_FLAG_COLOR_KEY)) {
+    memcpy(d, s, len);
+    return;
+  }
+  uint8_t key = (uint8_t)a->color_key;
+  for (int i = 0; i < len; i++)
+    if (s[i] != key)
+      d[i] = s[i];
+}
+
+static void line_indexed(const surface_t *surf, uint32_t di,
+                         const uint8_t *src, int sp, int len,
+                         const asset_t *a) {
+  const uint16_t *pal = asset_palette(a);
+  const uint8_t *s = src + sp;
+  bool keyed = a->flags & ASSET_FLAG_COLOR_KEY;
+  uint8_t key = (uint8_t)a->color_key;
+
+  if (surf->format == PIXEL_FORMAT_RGB565) {
+    uint16_t *d = (uint16_t *)surf->pixels + di;
+    for (int i = 0; i < len; i++)
+      if (!keyed || s[i] != key)
+        d[i] = pal[s[i]];
+  } else {
+    for (int i = 0; i < len; i++)
+      if (!keyed || s[i] != key)
+        put444(surf->pixels, di + i, rgb565_to_444(pal[s[i]]));
+  }
+}
+
+// --- Drawing ---
+bool asset_draw(surface_t *surf, int x, int y, const asset_t *a,
+                uint16_t frame) {
+  if (surf->pixels == NULL || a->layout != surf->layout ||
+      frame >= a->frame_count)
+    return false;
+  bool indexed = a->format == ASSET_FORMAT_INDEXED8;
+  if (!indexed && a->format != surf->format)
+    return false;
+
+  int sx0 = (x < 0) ? -x : 0;
+  int sy0 = (y < 0) ? -y : 0;
+  int w = a->width - sx0;
+  int h = a->height - sy0;
+  if (x + sx0 + w > surf->width)
+    w = surf->width - (x + sx0);
+  if (y + sy0 + h > surf->height)
+    h = surf->height - (y + sy0);
+  if (w <= 0 || h <= 0)
+    return true;
+
+  occlusion_resolve();
+
+  // Walk the stored lines: rows, or columns when column-major
+  bool columns = a->layout == SURFACE_LAYOUT_COLUMN_MAJOR;
+  int lines = columns ? w : h;
+  int len = columns ? h : w;
+  int sp = columns ? sy0 : sx0;
+  const uint8_t *src =
+      asset_frame(a, frame) + (columns ? sx0 : sy0) * a->stride;
+
+  for (int l = 0; l < lines; l++, src += a->stride) {
+    uint32_t di = columns ? surface_index(surf, x + sx0 + l, y + sy0)
+                          : surface_index(surf, x + sx0, y + sy0 + l);
+    if (indexed && surf->format != PIXEL_FORMAT_RGB332)
+      line_indexed(surf, di, src, sp, len, a);
+    else if (surf->format == PIXEL_FORMAT_RGB565)
+      line565(surf->pixels, di, src, sp, len, a);
+    else if (surf->format == PIXEL_FORMAT_RGB444)
+      line444(surf->pixels, di, src, sp, len, a);
+    else
+      line8(surf->pixels, di, src, sp, len, a);
+  }
+  return true;
+}
+
+// --- Streaming ---
+// Byte offset of pixel index i (even for RGB444)
+static uint32_t pixel_offset(const surface_t *surf, uint32_t i) {
+  if (surf->format == PIXEL_FORMAT_RGB565)
+    return i * 2;
+  if (surf->format == PIXEL_FORMAT_RGB444)
+    return (i >> 1) * 3;
+  return i;
+}
+
+uint32_t asset_stream(surface_t *surf, int x, int y, const asset_t *a,
+                      uint16_t frame, void (*done)(void *), void *arg) {
+  if (surf->pixels == NULL || a->format != surf->format ||
+      a->layout != surf->layout || (a->flags & ASSET_FLAG_COLOR_KEY) ||
+      frame >= a->frame_count)
+    return 0;
+  if (x < 0 || y < 0 || x + a->width > surf->width ||
+      y + a->height > surf->height)
+    return 0;
+
+  bool columns = a->layout == SURFACE_LAYOUT_COLUMN_MAJOR;
+  int lines = columns ? a->width : a->height;
+  uint32_t surf_line = columns ? surf->height : surf->width;
+  uint32_t first = surface_index(surf, x, y);
+  if (surf->format == PIXEL_FORMAT_RGB444 &&
+      ((first & 1) || (lines > 1 && (surf_line & 1))))
+    return 0; // A line would start mid-pair
+
+  uint32_t len = line_bytes(a);
+  uint32_t dst_stride = pixel_offset(surf, surf_line);
+  uint8_t *dst = surf->pixels + pixel_offset(surf, first);
+  if (((uintptr_t)dst | dst_stride | len) & 3)
+    return 0;
+
+  occlusion_resolve();
+
+  // A scrolled surface's ring seam splits the rows in two copies
+  const uint8_t *src = asset_frame(a, frame);
+  if (!columns) {
+    int row = surface_row(surf, y);
+    int before_seam = surf->height - row;
+    if (lines > before_seam) {
+      xip_stream_copy_rect(dst, dst_stride, src, a->stride, len,
+                           (uint16_t)before_seam, NULL, NULL);
+      src += before_seam * a->stride;
+      dst = surf->pixels + pixel_offset(surf, x);
+      lines -= before_seam;
+    }
+  }
+  return xip_stream_copy_rect(dst, dst_stride, src, a->stride, len,
+                              (uint16_t)lines, done, arg);
+}
+
+int asset_draw_string(surface_t *surf, int x, int y, const asset_t *font,
+                      const char *str) {
+  for (; *str; str++, x += font->width) {
+    uint32_t frame = (uint8_t)*str - font->first_char;
+    if (frame < font->frame_count)
+      asset_draw(surf, x, y, font, (uint16_t)frame);
+  }
+  return x;
+}
@@ -0,0 +1,103 @@
+#ifndef ASSET_H
+#define ASSET_H
+
+#include "surface.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Pre-Packed Assets
+ * Images, sprite sheets and fonts converted on the host
+ * (tools/asset_pack.py) into the exact byte layout of a surface_t: native
+ * RGB565, RGB444 pairs (2 pixels in 3 bytes), RGB332, or 8-bit palette
+ * indices, row- or column-major. Assets are linked into flash (or written
+ * to a flash offset) and mapped in place: asset_map() validates the header
+ * (and, for INDEXED8, that every index is in the palette) and returns it,
+ * so nothing is copied into RAM and drawing reads straight through XIP.
+ *
+ * Blob layout (little-endian, every section 4-byte aligned):
+ *   asset_t header | RGB565 palette (INDEXED8) | frames
+ * Each frame is `lines` stored lines of `stride` bytes; a line is a row
+ * (row-major) or a column (column-major) and starts on a pixel pair.
+ */
+
+#define ASSET_MAGIC 0x3141424Du // "MBA1"
+#define ASSET_LINE_ALIGN 4
+
+typedef enum {
+  ASSET_FORMAT_RGB565 = PIXEL_FORMAT_RGB565,
+  ASSET_FORMAT_RGB444 = PIXEL_FORMAT_RGB444,
+  ASSET_FORMAT_RGB332 = PIXEL_FORMAT_RGB332,
+  ASSET_FORMAT_INDEXED8 = 0x08 // Palette indices, RGB565 palette
+} asset_format_t;
+
+typedef enum {
+  ASSET_TYPE_IMAGE = 0, // One frame
+  ASSET_TYPE_SPRITES,   // Equal-sized frames
+  ASSET_TYPE_FONT       // One frame per character from first_char
+} asset_type_t;
+
+// Pixels equal to color_key are skipped when drawing
+#define ASSET_FLAG_COLOR_KEY 0x01
+
+typedef struct {
+  uint32_t magic;
+  uint8_t type;            // asset_type_t
+  uint8_t format;          // asset_format_t
+  uint8_t layout;          // surface_layout_t of the stored lines
+  uint8_t flags;           // ASSET_FLAG_*
+  uint16_t width;          // One frame (one glyph cell for fonts)
+  uint16_t height;
+  uint16_t frame_count;
+  uint16_t first_char;     // Fonts: character of frame 0
+  uint16_t stride;         // Bytes per stored line (ASSET_LINE_ALIGN multiple)
+  uint16_t palette_count;  // INDEXED8 only
+  uint32_t color_key;      // Stored encoding (palette index for INDEXED8)
+  uint32_t frame_bytes;    // stride * stored lines
+  uint32_t palette_offset; // From the start of the asset; 0 if none
+  uint32_t pixels_offset;
+} asset_t;
+
+// Validate a blob and return it as an asset (no copy); NULL if malformed
+// or not 4-byte aligned. INDEXED8 blobs with a palette under 256 entries
+// are read once in full to check their indices.
+const asset_t *asset_map(const void *data);
+
+// Same for a blob written to flash at `offset` (e.g. by picotool)
+const asset_t *asset_map_flash(uint32_t offset);
+
+static inline const uint8_t *asset_frame(const asset_t *a, uint16_t frame) {
+  return (const uint8_t *)a + a->pixels_offset + frame * a->frame_bytes;
+}
+
+static inline const uint16_t *asset_palette(const asset_t *a) {
+  return (const uint16_t *)((const uint8_t *)a + a->palette_offset);
+}
+
+// Draw a frame with its top-left at (x, y), clipped to the surface. When
+// the formats match, each line is a memcpy (colour-keyed assets compare
+// native pixels instead). INDEXED8 frames are looked up in the palette on
+// RGB565/RGB444 surfaces and copied verbatim onto RGB332 ones, where the
+// indices are meant to be shown through a raster effect palette.
+// Returns false (nothing drawn) for Direct Mode, a layout other than the
+// surface's, or an RGB frame in another surface format.
+bool asset_draw(surface_t *surf, int x, int y, const asset_t *a,
+                uint16_t frame);
+
+// Stream a frame into the surface in the background through the XIP
+// streaming FIFO (xip_stream.h): no CPU copy and no XIP cache eviction,
+// for backgrounds and other large images. The frame must lie wholly on
+// the surface in its own format and layout with no colour key, and every
+// line must start and end on a word (RGB444 pairs also need an even x).
+// The lines must not be drawn or presented until the returned ticket
+// completes (xip_stream_wait_job); `done` runs from the DMA IRQ. Returns
+// 0 (nothing queued) when the frame cannot be streamed: use asset_draw.
+uint32_t asset_stream(surface_t *surf, int x, int y, const asset_t *a,
+                      uint16_t frame, void (*done)(void *), void *arg);
+
+// Fonts: one cell per character, advancing by the cell width; characters
+// outside the font are skipped. Returns the x after the last cell.
+int asset_draw_string(surface_t *surf, int x, int y, const asset_t *font,
+                      const char *str);
+
+#endif
@@ -0,0 +1,414 @@
+#include "blend.h"
+#include "occlusion.h"
+
+// RGB565 pair masks. A word holds two native pixels (p0 low, p1 high).
+// Each mask keeps three 5/6-bit fields with enough zero bits above them
+// that a multiply by a 5-bit alpha cannot carry into the next field.
+#define M565_A 0x07E0F81Fu // word:      p0.B, p0.R, p1.G
+#define M565_B 0x07C0F83Fu // word >> 5: p0.G, p1.B, p1.R
+
+// RGB444 nibble lanes: even and odd nibbles each get a byte of headroom
+#define NIB 0x0F0F0F0Fu
+
+static const uint8_t a4_to_a5[16] = {0,  2,  4,  6,  9,  11, 13, 15,
+                                     17, 19, 21, 23, 26, 28, 30, 32};
+static const uint8_t a4_to_a16[16] = {0, 1,  2,  3,  4,  5,  6,  7,
+                                      9, 10, 11, 12, 13, 14, 15, 16};
+
+// --- RGB565 pair kernels ---
+static inline uint32_t lerp565x2(uint32_t d, uint32_t s_a, uint32_t s_b,
+                                 uint32_t inv) {
+  uint32_t ra = (((d & M565_A) * inv + s_a) >> 5) & M565_A;
+  uint32_t rb = ((((d >> 5) & M565_B) * inv + s_b) >> 5) & M565_B;
+  return ra | (rb << 5);
+}
+
+static inline uint32_t lerp565x2_src(uint32_t d, uint32_t s, uint32_t a5) {
+  return lerp565x2(d, (s & M565_A) * a5, ((s >> 5) & M565_B) * a5, 32 - a5);
+}
+
+static inline uint32_t add565x2(uint32_t d, uint32_t s) {
+  // Overflow lands in the bit above each field; smear it into a saturate
+  uint32_t ta = (d & M565_A) + (s & M565_A);
+  uint32_t o5 = ta & 0x00010020u, o6 = ta & 0x08000000u;
+  ta |= (o5 - (o5 >> 5)) | (o6 - (o6 >> 6));
+
+  uint32_t tb = ((d >> 5) & M565_B) + ((s >> 5) & M565_B);
+  o5 = tb & 0x08010000u;
+  o6 = tb & 0x00000040u;
+  tb |= (o5 - (o5 >> 5)) | (o6 - (o6 >> 6));
+
+  return (ta & M565_A) | ((tb & M565_B) << 5);
+}
+
+static inline uint32_t mul565x2(uint32_t d, uint32_t r1, uint32_t g1,
+                                uint32_t b1) {
+  // One channel of both pixels per multiply; factors are channel + 1
+  uint32_t r = ((((d >> 11) & 0x001F001Fu) * r1) >> 5) & 0x001F001Fu;
+  uint32_t g = ((((d >> 5) & 0x003F003Fu) * g1) >> 6) & 0x003F003Fu;
+  uint32_t b = (((d & 0x001F001Fu) * b1) >> 5) & 0x001F001Fu;
+  return (r << 11) | (g << 5) | b;
+}
+
+typedef struct {
+  blend_mode_t mode;
+  uint32_t inv;      // 32 - alpha (ALPHA)
+  uint32_t s_a, s_b; // Pre-multiplied source fields (ALPHA)
+  uint32_t s_add;    // Alpha-scaled source pair (ADD)
+  uint32_t r1, g1, b1;
+} ctx565_t;
+
+static void ctx565_init(ctx565_t *c, uint16_t color, uint8_t alpha,
+                        blend_mode_t mode) {
+  uint32_t a5 = (alpha + 4) >> 3;
+  uint32_t s = color | ((uint32_t)color << 16);
+  c->mode = mode;
+  c->inv = 32 - a5;
+  c->s_a = (s & M565_A) * a5;
+  c->s_b = ((s >> 5) & M565_B) * a5;
+  c->s_add = lerp565x2(s, 0, 0, a5);
+  c->r1 = ((color >> 11) & 0x1F) + 1;
+  c->g1 = ((color >> 5) & 0x3F) + 1;
+  c->b1 = (color & 0x1F) + 1;
+}
+
+static inline uint32_t op565(uint32_t d, const ctx565_t *c) {
+  if (c->mode == BLEND_ALPHA)
+    return lerp565x2(d, c->s_a, c->s_b, c->inv);
+  if (c->mode == BLEND_ADD)
+    return add565x2(d, c->s_add);
+  return mul565x2(d, c->r1, c->g1, c->b1);
+}
+
+static void row565(uint8_t *p, int w, const ctx565_t *c) {
+  uint16_t *p16 = (uint16_t *)p;
+  if (((uintptr_t)p16 & 2) && w) {
+    *p16 = op565(*p16, c);
+    p16++;
+    w--;
+  }
+
+  uint32_t *p32 = (uint32_t *)p16;
+  while (w >= 2) {
+    *p32 = op565(*p32, c);
+    p32++;
+    w -= 2;
+  }
+
+  if (w)
+    *(uint16_t *)p32 = op565(*(uint16_t *)p32, c);
+}
+
+// --- RGB444 nibble kernels ---
+// Memory order R0 G0 B0 R1 G1 B1: an 8-pixel run is 3 words, a pixel pair
+// is the low 24 bits of one. The colour pattern uses the same layout, so
+// each nibble lines up with its own channel.
+static inline uint32_t lerp_nib(uint32_t d, uint32_t s_e, uint32_t s_o,
+                                uint32_t inv) {
+  uint32_t e = (((d & NIB) * inv + s_e) >> 4) & NIB;
+  uint32_t o = ((((d >> 4) & NIB) * inv + s_o) >> 4) & NIB;
+  return e | (o << 4);
+}
+
+static inline uint32_t lerp_nib_src(uint32_t d, uint32_t s, uint32_t a16) {
+  return lerp_nib(d, (s & NIB) * a16, ((s >> 4) & NIB) * a16, 16 - a16);
+}
+
+static inline uint32_t add_nib(uint32_t d, uint32_t s) {
+  uint32_t e = (d & NIB) + (s & NIB);
+  uint32_t o = ((d >> 4) & NIB) + ((s >> 4) & NIB);
+  uint32_t oe = e & 0x10101010u, oo = o & 0x10101010u;
+  e = (e | (oe - (oe >> 4))) & NIB;
+  o = (o | (oo - (oo >> 4))) & NIB;
+  return e | (o << 4);
+}
+
+static inline uint32_t mul_nib(uint32_t d, uint32_t s) {
+  uint32_t r = 0;
+  for (int sh = 0; sh < 32; sh += 4)
+    r |= ((((d >> sh) & 0xF) * (((s >> sh) & 0xF) + 1)) >> 4) << sh;
+  return r;
+}
+
+typedef struct {
+  blend_mode_t mode;
+  uint32_t inv;
+  uint32_t pat[3];      // Colour pattern words (8 pixels)
+  uint32_t s_e[3], s_o[3]; // Pre-multiplied even/odd nibbles (ALPHA)
+  uint32_t s_add[3];    // Alpha-scaled pattern (ADD)
+} ctx444_t;
+
+static void ctx444_init(ctx444_t *c, uint16_t color, uint8_t alpha,
+                        blend_mode_t mode) {
+  uint32_t a16 = (alpha + 8) >> 4;
+  uint8_t r4 = ((color >> 11) & 0x1F) >> 1;
+  uint8_t g4 = ((color >> 5) & 0x3F) >> 2;
+  uint8_t b4 = (color & 0x1F) >> 1;
+  uint8_t b0 = (r4 << 4) | g4;
+  uint8_t b1 = (b4 << 4) | r4;
+  uint8_t b2 = (g4 << 4) | b4;
+
+  c->mode = mode;
+  c->inv = 16 - a16;
+  c->pat[0] = b0 | (b1 << 8) | (b2 << 16) | (b0 << 24);
+  c->pat[1] = b1 | (b2 << 8) | (b0 << 16) | (b1 << 24);
+  c->pat[2] = b2 | (b0 << 8) | (b1 << 16) | (b2 << 24);
+  for (int k = 0; k < 3; k++) {
+    c->s_e[k] = (c->pat[k] & NIB) * a16;
+    c->s_o[k] = ((c->pat[k] >> 4) & NIB) * a16;
+    c->s_add[k] = lerp_nib(c->pat[k], 0, 0, a16);
+  }
+}
+
+static inline uint32_t op444(uint32_t d, int k, const ctx444_t *c) {
+  if (c->mode == BLEND_ALPHA)
+    return lerp_nib(d, c->s_e[k], c->s_o[k], c->inv);
+  if (c->mode == BLEND_ADD)
+    return add_nib(d, c->s_add[k]);
+  return mul_nib(d, c->pat[k]);
+}
+
+// Nibbles of the even / odd pixel within a 24-bit pair
+#define PAIR_EVEN 0x00F0FFu
+#define PAIR_ODD 0xFF0F00u
+
+static inline uint32_t pair_load(const uint8_t *p) {
+  return p[0] | (p[1] << 8) | (p[2] << 16);
+}
+
+static inline void pair_store(uint8_t *p, uint32_t v) {
+  p[0] = v & 0xFF;
+  p[1] = (v >> 8) & 0xFF;
+  p[2] = (v >> 16) & 0xFF;
+}
+
+static inline void pair_merge(uint8_t *p, uint32_t v, uint32_t mask) {
+  uint32_t d = pair_load(p);
+  pair_store(p, (d & ~mask) | (v & mask));
+}
+
+static void row444(uint8_t *pixels, uint32_t idx, int w, const ctx444_t *c) {
+  uint8_t *p = pixels + (idx / 2) * 3;
+
+  if ((idx % 2) && w) {
+    pair_merge(p, op444(pair_load(p), 0, c), PAIR_ODD);
+    p += 3;
+    idx++;
+    w--;
+  }
+
+  while (w >= 2 && (idx % 8) != 0) {
+    pair_store(p, op444(pair_load(p), 0, c));
+    p += 3;
+    idx += 2;
+    w -= 2;
+  }
+
+  uint32_t *p32 = (uint32_t *)p;
+  while (w >= 8) {
+    p32[0] = op444(p32[0], 0, c);
+    p32[1] = op444(p32[1], 1, c);
+    p32[2] = op444(p32[2], 2, c);
+    p32 += 3;
+    w -= 8;
+  }
+  p = (uint8_t *)p32;
+
+  while (w >= 2) {
+    pair_store(p, op444(pair_load(p), 0, c));
+    p += 3;
+    w -= 2;
+  }
+
+  if (w)
+    pair_merge(p, op444(pair_load(p), 0, c), PAIR_EVEN);
+}
+
+// --- RGB332 (per pixel through RGB565) ---
+static inline uint16_t rgb332_to_565(uint8_t c8) {
+  uint16_t r3 = (c8 >> 5) & 0x07, g3 = (c8 >> 2) & 0x07, b2 = c8 & 0x03;
+  return (((r3 << 2) | (r3 >> 1)) << 11) | (((g3 << 3) | g3) << 5) |
+         ((b2 << 3) | (b2 << 1) | (b2 >> 1));
+}
+
+static inline uint8_t rgb565_to_332(uint16_t c) {
+  return (((c >> 13) & 0x07) << 5) | (((c >> 8) & 0x07) << 2) |
+         ((c >> 3) & 0x03);
+}
+
+void blend_rect(surface_t *surf, int x, int y, int w, int h, uint16_t color,
+                uint8_t alpha, blend_mode_t mode) {
+  if (surf->pixels == NULL)
+    return;
+  if (x < 0) {
+    w += x;
+    x = 0;
+  }
+  if (y < 0) {
+    h += y;
+    y = 0;
+  }
+  if (x + w > surf->width)
+    w = surf->width - x;
+  if (y + h > surf->height)
+    h = surf->height - y;
+  if (w <= 0 || h <= 0)
+    return;
+
+  occlusion_resolve(); // Blending reads what recorded primitives will write
+
+  // Kernels walk stored lines: rows, or the contiguous columns of a
+  // column-major surface (a constant-colour blend ignores orientation)
+  surface_t lines = *surf;
+  if (surf->layout == SURFACE_LAYOUT_COLUMN_MAJOR) {
+    lines.width = surf->height;
+    lines.height = surf->width;
+    int t = x;
+    x = y;
+    y = t;
+    t = w;
+    w = h;
+    h = t;
+  }
+  surf = &lines;
+
+  if (surf->format == PIXEL_FORMAT_RGB565) {
+    ctx565_t c;
+    ctx565_init(&c, color, alpha, mode);
+    for (int row = 0; row < h; row++)
+      row565(surf->pixels + (surface_row(surf, y + row) * surf->width + x) * 2,
+             w, &c);
+  } else if (surf->format == PIXEL_FORMAT_RGB444) {
+    ctx444_t c;
+    ctx444_init(&c, color, alpha, mode);
+    for (int row = 0; row < h; row++)
+      row444(surf->pixels, surface_row(surf, y + row) * surf->width + x, w,
+             &c);
+  } else {
+    ctx565_t c;
+    ctx565_init(&c, color, alpha, mode);
+    for (int row = 0; row < h; row++) {
+      uint8_t *p = surf->pixels + surface_row(surf, y + row) * surf->width + x;
+      for (int i = 0; i < w; i++)
+        p[i] = rgb565_to_332(op565(rgb332_to_565(p[i]), &c));
+    }
+  }
+}
+
+static inline uint8_t sprite_alpha(const sprite_a4_t *spr, int sx, int sy) {
+  uint8_t a = spr->alpha4[sy * ((spr->width + 1) / 2) + sx / 2];
+  return (sx & 1) ? (a >> 4) : (a & 0x0F);
+}
+
+static inline uint32_t rgb565_to_nib_pair(uint16_t c0, uint16_t c1) {
+  uint32_t r0 = c0 >> 12, g0 = (c0 >> 7) & 0xF, b0 = (c0 >> 1) & 0xF;
+  uint32_t r1 = c1 >> 12, g1 = (c1 >> 7) & 0xF, b1 = (c1 >> 1) & 0xF;
+  return ((r0 << 4) | g0) | (((b0 << 4) | r1) << 8) | (((g1 << 4) | b1) << 16);
+}
+
+static void sprite_row565(uint8_t *p, const uint16_t *src,
+                          const sprite_a4_t *spr, int sx, int sy, int w) {
+  uint16_t *p16 = (uint16_t *)p;
+  int i = 0;
+  if (((uintptr_t)p16 & 2) && w) {
+    p16[0] = lerp565x2_src(p16[0], src[0],
+                           a4_to_a5[sprite_alpha(spr, sx, sy)]);
+    i = 1;
+  }
+
+  for (; i + 1 < w; i += 2) {
+    uint32_t *p32 = (uint32_t *)(p16 + i);
+    uint8_t a0 = sprite_alpha(spr, sx + i, sy);
+    uint8_t a1 = sprite_alpha(spr, sx + i + 1, sy);
+    uint32_t s = src[i] | ((uint32_t)src[i + 1] << 16);
+
+    if ((a0 | a1) == 0)
+      continue; // Fully transparent pair
+    if ((a0 & a1) == 15) {
+      *p32 = s; // Fully opaque pair
+      continue;
+    }
+
+    uint32_t d = *p32;
+    uint32_t r = lerp565x2_src(d, s, a4_to_a5[a0]);
+    if (a1 != a0) // Second pixel needs its own alpha
+      r = (r & 0xFFFF) | (lerp565x2_src(d, s, a4_to_a5[a1]) & 0xFFFF0000u);
+    *p32 = r;
+  }
+
+  if (i < w)
+    p16[i] = lerp565x2_src(p16[i], src[i],
+                           a4_to_a5[sprite_alpha(spr, sx + i, sy)]);
+}
+
+static void sprite_row444(uint8_t *pixels, uint32_t idx, const uint16_t *src,
+                          const sprite_a4_t *spr, int sx, int sy, int w) {
+  int i = 0;
+  while (i < w) {
+    uint8_t *p = pixels + (idx / 2) * 3;
+    bool odd = idx & 1;
+    bool pair = !odd && i + 1 < w;
+
+    uint16_t c0 = odd ? 0 : src[i];
+    uint16_t c1 = odd ? src[i] : (pair ? src[i + 1] : 0);
+    uint32_t s = rgb565_to_nib_pair(c0, c1);
+    uint32_t d = pair_load(p);
+
+    uint8_t a_even = odd ? 0 : sprite_alpha(spr, sx + i, sy);
+    uint8_t a_odd =
+        odd ? sprite_alpha(spr, sx + i, sy)
+            : (pair ? sprite_alpha(spr, sx + i + 1, sy) : 0);
+
+    uint32_t r = d;
+    if (!odd && a_even)
+      r = (r & ~PAIR_EVEN) | (lerp_nib_src(d, s, a4_to_a16[a_even]) & PAIR_EVEN);
+    if ((odd || pair) && a_odd)
+      r = (r & ~PAIR_ODD) | (lerp_nib_src(d, s, a4_to_a16[a_odd]) & PAIR_ODD);
+    if (r != d)
+      pair_store(p, r);
+
+    int n = pair ? 2 : 1;
+    i += n;
+    idx += n;
+  }
+}
+
+void blend_sprite_a4(surface_t *surf, int x, int y, const sprite_a4_t *spr) {
+  if (surf->pixels == NULL || surf->layout != SURFACE_LAYOUT_ROW_MAJOR)
+    return;
+
+  int sx0 = (x < 0) ? -x : 0;
+  int sy0 = (y < 0) ? -y : 0;
+  int w = spr->width - sx0;
+  int h = spr->height - sy0;
+  if (x + sx0 + w > surf->width)
+    w = surf->width - (x + sx0);
+  if (y + sy0 + h > surf->height)
+    h = surf->height - (y + sy0);
+  if (w <= 0 || h <= 0)
+    return;
+
+  occlusion_resolve();
+
+  for (int row = 0; row < h; row++) {
+    int sy = sy0 + row;
+    int dy = surface_row(surf, y + sy);
+    int dx = x + sx0;
+    const uint16_t *src = spr->pixels + sy * spr->width + sx0;
+
+    if (surf->format == PIXEL_FORMAT_RGB565) {
+      sprite_row565(surf->pixels + (dy * surf->width + dx) * 2, src, spr, sx0,
+                    sy, w);
+    } else if (surf->format == PIXEL_FORMAT_RGB444) {
+      sprite_row444(surf->pixels, dy * surf->width + dx, src, spr, sx0, sy, w);
+    } else {
+      uint8_t *p = surf->pixels + dy * surf->width + dx;
+      for (int i = 0; i < w; i++) {
+        uint8_t a = sprite_alpha(spr, sx0 + i, sy);
+        if (a)
+          p[i] = rgb565_to_332(
+              lerp565x2_src(rgb332_to_565(p[i]), src[i], a4_to_a5[a]));
+      }
+    }
+  }
+}
@@ -0,0 +1,36 @@
+#ifndef BLEND_H
+#define BLEND_H
+
+#include "surface.h"
+
+/**
+ * Blending Kernels
+ * Translucent fills and alpha sprites. RGB565 runs two pixels per 32-bit
+ * word (SIMD-within-a-register, 5-bit alpha); RGB444 runs on packed nibbles
+ * (8 channels per word, 4-bit alpha) without unpacking its 3-byte pairs.
+ * RGB332 falls back to a per-pixel path. Direct Mode surfaces are ignored.
+ */
+
+typedef enum {
+  BLEND_ALPHA = 0, // dst + (src - dst) * alpha
+  BLEND_ADD,       // Saturating dst + src * alpha
+  BLEND_MULTIPLY   // dst * src (alpha ignored)
+} blend_mode_t;
+
+// Sprite with a 4-bit alpha per pixel (2 per byte, low nibble first).
+// Colours are native RGB565; alpha rows are (width + 1) / 2 bytes.
+typedef struct {
+  const uint16_t *pixels;
+  const uint8_t *alpha4;
+  uint16_t width;
+  uint16_t height;
+} sprite_a4_t;
+
+// Blend a solid colour over a rectangle (alpha 0..255)
+void blend_rect(surface_t *surf, int x, int y, int w, int h, uint16_t color,
+                uint8_t alpha, blend_mode_t mode);
+
+// Blend a 4-bit alpha sprite (BLEND_ALPHA) with its top-left at (x, y)
+void blend_sprite_a4(surface_t *surf, int x, int y, const sprite_a4_t *sprite);
+
+#endif
@@ -0,0 +1,397 @@
+#include "cimage.h"
+#include "display_driver.h"
+#include "occlusion.h"
+#include <string.h>
+
+#define OP_INDEX 0x00
+#define OP_RUN 0x40
+#define OP_RUN16 0x7F
+#define OP_DIFF 0x80
+#define OP_LUMA 0xC0
+#define OP_RAW 0xE0
+
+#define RUN_MAX 63
+#define RUN16_MAX 0xFFFF
+
+// Field layout of a value in each format
+typedef struct {
+  uint8_t r_shift, g_shift;
+  uint8_t r_mask, g_mask, b_mask;
+  uint8_t r_scale, b_scale; // Green delta >> scale: LUMA reference
+} channels_t;
+
+static const channels_t ch565 = {11, 5, 0x1F, 0x3F, 0x1F, 1, 1};
+static const channels_t ch444 = {8, 4, 0x0F, 0x0F, 0x0F, 0, 0};
+static const channels_t ch332 = {5, 2, 0x07, 0x07, 0x03, 0, 1};
+
+static inline const channels_t *channels_of(uint8_t format) {
+  if (format == PIXEL_FORMAT_RGB565)
+    return &ch565;
+  return format == PIXEL_FORMAT_RGB444 ? &ch444 : &ch332;
+}
+
+static inline uint32_t hash(uint32_t v) { return ((v * 0x9E37u) >> 10) & 63; }
+
+static inline uint16_t add_deltas(const channels_t *c, uint32_t v, int dr,
+                                  int dg, int db) {
+  uint32_t r = ((v >> c->r_shift) + dr) & c->r_mask;
+  uint32_t g = ((v >> c->g_shift) + dg) & c->g_mask;
+  uint32_t b = (v + db) & c->b_mask;
+  return (uint16_t)((r << c->r_shift) | (g << c->g_shift) | b);
+}
+
+const cimage_t *cimage_map(const void *data) {
+  const cimage_t *img = (const cimage_t *)data;
+  if (img == NULL || ((uintptr_t)img & 3) || img->magic != CIMAGE_MAGIC)
+    return NULL;
+  if (img->format != PIXEL_FORMAT_RGB565 &&
+      img->format != PIXEL_FORMAT_RGB444 && img->format != PIXEL_FORMAT_RGB332)
+    return NULL;
+  if (img->layout > SURFACE_LAYOUT_COLUMN_MAJOR)
+    return NULL;
+  return img;
+}
+
+void cimage_decoder_init(cimage_decoder_t *d, const cimage_t *img) {
+  cimage_decoder_start(d, img->format, img + 1, img->data_bytes);
+}
+
+void cimage_decoder_start(cimage_decoder_t *d, uint8_t format,
+                          const void *ops, uint32_t bytes) {
+  d->src = (const uint8_t *)ops;
+  d->end = d->src + bytes;
+  d->run = 0;
+  d->prev = 0;
+  d->format = format;
+  memset(d->table, 0, sizeof(d->table));
+}
+
+// --- Decode ---
+// Next value of the op stream (d->run must be 0). Sets d->run for runs.
+static inline uint16_t next_op(cimage_decoder_t *d, const channels_t *c,
+                               uint16_t prev) {
+  const uint8_t *s = d->src;
+  if (s >= d->end) { // Truncated: hold the last value
+    d->run = 0xFFFFFFFFu;
+    return prev;
+  }
+
+  uint32_t op = *s++;
+  uint16_t v;
+  if (op < OP_RUN) {
+    d->src = s;
+    return d->table[op];
+  } else if (op < OP_DIFF) {
+    if (op == OP_RUN16) {
+      d->run = s[0] | (s[1] << 8);
+      s += 2;
+    } else {
+      d->run = (op & 0x3F) + 1;
+    }
+    d->src = s;
+    if (d->run)
+      d->run--; // This call returns the first copy
+    return prev;
+  } else if (op < OP_LUMA) {
+    v = add_deltas(c, prev, (int)((op >> 4) & 3) - 2,
+                   (int)((op >> 2) & 3) - 2, (int)(op & 3) - 2);
+  } else if (op < OP_RAW) {
+    int dg = (int)(op & 0x1F) - 16;
+    uint32_t rb = *s++;
+    v = add_deltas(c, prev, (int)(rb >> 4) - 8 + (dg >> c->r_scale), dg,
+                   (int)(rb & 0x0F) - 8 + (dg >> c->b_scale));
+  } else if (op == OP_RAW) {
+    v = s[0];
+    s++;
+    if (d->format != PIXEL_FORMAT_RGB332)
+      v |= *s++ << 8;
+  } else { // Reserved: treat as the end
+    d->src = d->end;
+    d->run = 0xFFFFFFFFu;
+    return prev;
+  }
+  d->table[hash(v)] = v;
+  d->src = s;
+  return v;
+}
+
+// n values into a uint16_t (RGB565/RGB444 values) or uint8_t array
+static inline void decode_values(cimage_decoder_t *d, void *out, uint32_t n,
+                                 bool bytes) {
+  const channels_t *c = channels_of(d->format);
+  uint16_t prev = d->prev;
+  uint16_t *out16 = (uint16_t *)out;
+  uint8_t *out8 = (uint8_t *)out;
+
+  for (uint32_t i = 0; i < n;) {
+    if (d->run) {
+      uint32_t k = n - i < d->run ? n - i : d->run;
+      d->run -= k;
+      if (bytes)
+        memset(out8 + i, prev, k);
+      else
+        for (uint32_t e = i + k, j = i; j < e; j++)
+          out16[j] = prev;
+      i += k;
+      continue;
+    }
+    prev = next_op(d, c, prev);
+    if (bytes)
+      out8[i++] = (uint8_t)prev;
+    else
+      out16[i++] = prev;
+  }
+  d->prev = prev;
+}
+
+// RGB444: decode 0x0RGB values in chunks and pack them
+static void decode444(cimage_decoder_t *d, uint8_t *pixels, uint32_t index,
+                      uint32_t n) {
+  uint16_t chunk[64];
+  while (n) {
+    uint32_t k = n < 64 ? n : 64;
+    decode_values(d, chunk, k, false);
+    uint32_t i = 0;
+    if (index & 1) { // Finish the pair in progress
+      uint8_t *p = pixels + (index >> 1) * 3;
+      p[1] = (p[1] & 0xF0) | (chunk[0] >> 8);
+      p[2] = (uint8_t)chunk[0];
+      i = 1;
+    }
+    uint8_t *p = pixels + ((index + i) >> 1) * 3;
+    for (; i + 1 < k; i += 2, p += 3) {
+      uint16_t a = chunk[i], b = chunk[i + 1];
+      p[0] = (uint8_t)(a >> 4);
+      p[1] = (uint8_t)((a << 4) | (b >> 8));
+      p[2] = (uint8_t)b;
+    }
+    if (i < k) { // Start a pair
+      p[0] = (uint8_t)(chunk[i] >> 4);
+      p[1] = (uint8_t)((chunk[i] << 4) | (p[1] & 0x0F));
+    }
+    index += k;
+    n -= k;
+  }
+}
+
+void cimage_decode(cimage_decoder_t *d, uint8_t *pixels, uint32_t index,
+                   uint32_t n) {
+  if (d->format == PIXEL_FORMAT_RGB565)
+    decode_values(d, (uint16_t *)pixels + index, n, false);
+  else if (d->format == PIXEL_FORMAT_RGB332)
+    decode_values(d, pixels + index, n, true);
+  else
+    decode444(d, pixels, index, n);
+}
+
+void cimage_skip(cimage_decoder_t *d, uint32_t n) {
+  const channels_t *c = channels_of(d->format);
+  while (n) {
+    if (d->run) {
+      uint32_t k = n < d->run ? n : d->run;
+      d->run -= k;
+      n -= k;
+      continue;
+    }
+    d->prev = next_op(d, c, d->prev);
+    n--;
+  }
+}
+
+// --- Drawing ---
+bool cimage_draw(surface_t *surf, int x, int y, const cimage_t *img) {
+  if (surf->pixels == NULL || img->format != surf->format ||
+      img->layout != surf->layout)
+    return false;
+
+  int sx0 = (x < 0) ? -x : 0;
+  int sy0 = (y < 0) ? -y : 0;
+  int w = img->width - sx0;
+  int h = img->height - sy0;
+  if (x + sx0 + w > surf->width)
+    w = surf->width - (x + sx0);
+  if (y + sy0 + h > surf->height)
+    h = surf->height - (y + sy0);
+  if (w <= 0 || h <= 0)
+    return true;
+
+  occlusion_resolve();
+
+  // Stored lines: rows, or columns when column-major. Clipped pixels are
+  // still decoded (skipped) to keep the stream state.
+  bool columns = img->layout == SURFACE_LAYOUT_COLUMN_MAJOR;
+  int line_len = columns ? img->height : img->width;
+  int first = columns ? sx0 : sy0;
+  int lines = columns ? w : h;
+  int lead = columns ? sy0 : sx0;
+  int len = columns ? h : w;
+
+  cimage_decoder_t d;
+  cimage_decoder_init(&d, img);
+  cimage_skip(&d, (uint32_t)first * line_len);
+  for (int l = 0; l < lines; l++) {
+    uint32_t di = columns ? surface_index(surf, x + sx0 + l, y + sy0)
+                          : surface_index(surf, x + sx0, y + sy0 + l);
+    cimage_skip(&d, lead);
+    cimage_decode(&d, surf->pixels, di, len);
+    cimage_skip(&d, line_len - lead - len);
+  }
+  return true;
+}
+
+// --- Panel ---
+static uint32_t packed_bytes(uint8_t format, uint32_t pixels) {
+  if (format == PIXEL_FORMAT_RGB565)
+    return pixels * 2;
+  if (format == PIXEL_FORMAT_RGB444)
+    return (pixels * 3 + 1) / 2;
+  return pixels;
+}
+
+bool cimage_present(const cimage_t *img, int x, int y, void *buf,
+                    uint32_t buf_bytes) {
+  if (img->layout != SURFACE_LAYOUT_ROW_MAJOR ||
+      img->format != display_get_wire_format() || x < 0 || y < 0 ||
+      x + img->width > display_get_width() ||
+      y + img->height > display_get_height())
+    return false;
+
+  // Rows per band; even so that RGB444 bands start on a pair
+  uint32_t half = (buf_bytes / 2) & ~3u;
+  uint32_t rows = half / packed_bytes(img->format, img->width);
+  if (img->format == PIXEL_FORMAT_RGB444 && (img->width & 1))
+    rows &= ~1u;
+  if (rows == 0)
+    return false;
+
+  cimage_decoder_t d;
+  cimage_decoder_init(&d, img);
+  uint8_t *bands[2] = {(uint8_t *)buf, (uint8_t *)buf + half};
+
+  display_set_window(x, y, x + img->width - 1, y + img->height - 1);
+  display_start_bulk();
+  for (uint32_t row = 0, b = 0; row < img->height; row += rows, b ^= 1) {
+    uint32_t n = img->height - row < rows ? img->height - row : rows;
+    // Decode while the other band is on its way out, then queue this one
+    // once that send has left memory
+    cimage_decode(&d, bands[b], 0, n * img->width);
+    display_wait_ready();
+    display_send_buffer(bands[b],
+                        packed_bytes(img->format, n * img->width));
+  }
+  display_end_bulk();
+  return true;
+}
+
+// --- Encode ---
+static uint16_t read_value(const surface_t *surf, uint32_t i) {
+  if (surf->format == PIXEL_FORMAT_RGB565)
+    return ((const uint16_t *)surf->pixels)[i];
+  if (surf->format == PIXEL_FORMAT_RGB332)
+    return surf->pixels[i];
+  const uint8_t *p = surf->pixels + (i >> 1) * 3;
+  return (i & 1) ? ((p[1] & 0x0F) << 8) | p[2] : (p[0] << 4) | (p[1] >> 4);
+}
+
+// Signed delta between two field values, wrapped into the field
+static inline int wrap(int delta, uint32_t mask) {
+  int half = (int)(mask + 1) >> 1;
+  return ((delta + half) & (int)mask) - half;
+}
+
+typedef struct {
+  uint8_t *out;
+  uint32_t pos;
+  uint32_t capacity;
+} writer_t;
+
+static inline void put(writer_t *w, uint32_t byte) {
+  if (w->pos < w->capacity)
+    w->out[w->pos] = (uint8_t)byte;
+  w->pos++;
+}
+
+static void flush_run(writer_t *w, uint32_t run) {
+  while (run) {
+    if (run <= RUN_MAX) {
+      put(w, OP_RUN | (run - 1));
+      return;
+    }
+    uint32_t k = run < RUN16_MAX ? run : RUN16_MAX;
+    put(w, OP_RUN16);
+    put(w, k & 0xFF);
+    put(w, k >> 8);
+    run -= k;
+  }
+}
+
+uint32_t cimage_encode(const surface_t *surf, int x, int y, int w, int h,
+                       uint8_t *out, uint32_t capacity) {
+  if (surf->pixels == NULL || x < 0 || y < 0 || w <= 0 || h <= 0 ||
+      x + w > surf->width || y + h > surf->height ||
+      capacity < sizeof(cimage_t) || ((uintptr_t)out & 3))
+    return 0;
+  occlusion_resolve(); // Read what recorded primitives will have drawn
+
+  const channels_t *c = channels_of(surf->format);
+  bool columns = surf->layout == SURFACE_LAYOUT_COLUMN_MAJOR;
+  int lines = columns ? w : h;
+  int len = columns ? h : w;
+  uint16_t table[64] = {0};
+  uint16_t prev = 0;
+  uint32_t run = 0;
+  writer_t wr = {out + sizeof(cimage_t), 0, capacity - sizeof(cimage_t)};
+
+  for (int l = 0; l < lines; l++) {
+    for (int i = 0; i < len; i++) {
+      uint32_t si = columns ? surface_index(surf, x + l, y + i)
+                            : surface_index(surf, x + i, y + l);
+      uint16_t v = read_value(surf, si);
+      if (v == prev) {
+        run++;
+        continue;
+      }
+      flush_run(&wr, run);
+      run = 0;
+
+      uint32_t h6 = hash(v);
+      if (table[h6] == v) {
+        put(&wr, OP_INDEX | h6);
+        prev = v;
+        continue;
+      }
+      table[h6] = v;
+
+      int dr = wrap((int)((v >> c->r_shift) & c->r_mask) -
+                        (int)((prev >> c->r_shift) & c->r_mask),
+                    c->r_mask);
+      int dg = wrap((int)((v >> c->g_shift) & c->g_mask) -
+                        (int)((prev >> c->g_shift) & c->g_mask),
+                    c->g_mask);
+      int db = wrap((int)(v & c->b_mask) - (int)(prev & c->b_mask), c->b_mask);
+      int lr = dr - (dg >> c->r_scale), lb = db - (dg >> c->b_scale);
+
+      if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+        put(&wr, OP_DIFF | ((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2));
+      } else if (dg >= -16 && dg <= 15 && lr >= -8 && lr <= 7 && lb >= -8 &&
+                 lb <= 7) {
+        put(&wr, OP_LUMA | (dg + 16));
+        put(&wr, ((lr + 8) << 4) | (lb + 8));
+      } else {
+        put(&wr, OP_RAW);
+        put(&wr, v & 0xFF);
+        if (surf->format != PIXEL_FORMAT_RGB332)
+          put(&wr, v >> 8);
+      }
+      prev = v;
+    }
+  }
+  flush_run(&wr, run);
+  if (wr.pos > wr.capacity)
+    return 0;
+
+  cimage_t *img = (cimage_t *)out;
+  *img = (cimage_t){CIMAGE_MAGIC, surf->format, surf->layout, (uint16_t)w,
+                    (uint16_t)h, 0, wr.pos};
+  return sizeof(cimage_t) + wr.pos;
+}
@@ -0,0 +1,82 @@
+#ifndef CIMAGE_H
+#define CIMAGE_H
+
+#include "surface.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Compressed Images
+ * A byte-oriented QOI-style codec over pixels in a surface encoding
+ * (RGB565, RGB444 or RGB332 values). Each op is one byte, maybe with
+ * one or two operand bytes:
+ *   00iiiiii            INDEX  value from a 64-entry table of recent colours
+ *   01nnnnnn            RUN    repeat the previous value n + 1 (1..63) times
+ *   01111111 lo hi      RUN    16-bit run length
+ *   10rrggbb            DIFF   channel deltas -2..1
+ *   110ggggg rrrrbbbb   LUMA   green delta -16..15, red/blue relative to it
+ *   11100000 value      RAW    1 (RGB332) or 2 little-endian bytes
+ * Channel deltas wrap within each field; LUMA's red and blue deltas are
+ * relative to the green delta scaled to their width. Every non-INDEX op
+ * stores its value in the table slot (v * 0x9E37 >> 10) & 63. Pixels run
+ * in stored-line order (rows, or columns when column-major), and the
+ * state carried across lines is a small cimage_decoder_t, so the decoder
+ * writes straight into a surface or a line buffer with no image buffer.
+ *
+ * Images come from tools/cimage_pack.py (PNG) or cimage_encode() (a surface
+ * region) and are mapped in place like assets.
+ */
+
+#define CIMAGE_MAGIC 0x3151424Du // "MBQ1"
+
+typedef struct {
+  uint32_t magic;
+  uint8_t format; // display_pixel_format_t of the values
+  uint8_t layout; // surface_layout_t: order of the stored lines
+  uint16_t width;
+  uint16_t height;
+  uint16_t reserved;
+  uint32_t data_bytes; // Op stream following the header
+} cimage_t;
+
+typedef struct {
+  const uint8_t *src;
+  const uint8_t *end;
+  uint32_t run; // Copies of `prev` still owed
+  uint16_t prev;
+  uint8_t format;
+  uint16_t table[64];
+} cimage_decoder_t;
+
+// Validate a blob (4-byte aligned) and return it; NULL if malformed
+const cimage_t *cimage_map(const void *data);
+
+void cimage_decoder_init(cimage_decoder_t *d, const cimage_t *img);
+// Same for a bare op stream (containers such as video frames)
+void cimage_decoder_start(cimage_decoder_t *d, uint8_t format,
+                          const void *ops, uint32_t bytes);
+
+// Decode the next `n` pixels into `pixels` (packed in the image's format)
+// from pixel index `index` on: a surface's linear index or 0 for a buffer
+void cimage_decode(cimage_decoder_t *d, uint8_t *pixels, uint32_t index,
+                   uint32_t n);
+void cimage_skip(cimage_decoder_t *d, uint32_t n);
+
+// Decode with the top-left at (x, y), clipped, into a surface of the same
+// format and layout. false (nothing drawn) otherwise or in Direct Mode.
+bool cimage_draw(surface_t *surf, int x, int y, const cimage_t *img);
+
+// Decode row-major bands into the two halves of `buf` and send each to the
+// panel window at (x, y) while the next decodes; no framebuffer involved.
+// The image must be in the wire format (RGB565 or RGB444) and on screen.
+// Call between presents (after framebuffer_wait_last_swap), then
+// framebuffer_invalidate().
+bool cimage_present(const cimage_t *img, int x, int y, void *buf,
+                    uint32_t buf_bytes);
+
+// Compress a region of a surface (its format and layout) into `out`.
+// Returns the blob size (header included), 0 if it did not fit.
+uint32_t cimage_encode(const surface_t *surf, int x, int y, int w, int h,
+                       uint8_t *out, uint32_t capacity);
+
+#endif
@@ -0,0 +1,251 @@
+#include "compositor.h"
+#include "arena.h"
+#include "display_driver.h"
+#include "framebuffer.h"
+#include <string.h>
+
+static surface_t background;
+static surface_t hud;
+static uint16_t hud_rows = 0;
+static bool active = false;
+static volatile bool hud_dirty = false;
+
+// Ping-pong wire lines for rows that need composing or RGB332 expansion
+static uint8_t *line_buffer = NULL;
+static uint32_t line_bytes = 0;
+
+// Key colour in each format's stored layout
+static uint16_t key_color = 0x0000;
+static uint32_t key_rgb565x2 = 0; // Two native pixels in one word
+static uint32_t key_rgb444x2 = 0; // One 3-byte pair
+static uint8_t key_rgb332 = 0;
+
+// Nibbles of the even / odd pixel within an RGB444 pair
+#define PAIR_EVEN 0x00F0FFu
+#define PAIR_ODD 0xFF0F00u
+
+static uint32_t layer_bytes(uint16_t width, uint16_t height,
+                            display_pixel_format_t format) {
+  if (format == PIXEL_FORMAT_RGB565)
+    return width * height * 2;
+  if (format == PIXEL_FORMAT_RGB444)
+    return (width * height * 3) / 2;
+  return width * height; // RGB332
+}
+
+// Bytes of one line as sent to the panel
+static uint32_t wire_line_bytes(uint16_t width, display_pixel_format_t format) {
+  if (format == PIXEL_FORMAT_RGB444)
+    return (width * 3) / 2;
+  return width * 2; // RGB565, RGB332 expanded
+}
+
+uint32_t compositor_get_arena_size(uint16_t width, uint16_t height,
+                                   display_pixel_format_t format,
+                                   uint16_t rows, bool bg) {
+  if (rows == 0 && !bg)
+    return 0;
+  if (rows > height)
+    rows = height;
+
+  uint32_t bytes =
+      arena_reserve_size(2 * wire_line_bytes(width, format), ARENA_ALIGN_DMA);
+  if (rows)
+    bytes += arena_reserve_size(layer_bytes(width, rows, format),
+                                ARENA_ALIGN_DMA);
+  if (bg)
+    bytes += arena_reserve_size(layer_bytes(width, height, format),
+                                ARENA_ALIGN_DMA);
+  return bytes;
+}
+
+static bool layer_alloc(surface_t *surf, uint16_t width, uint16_t height,
+                        display_pixel_format_t format) {
+  surf->width = width;
+  surf->height = height;
+  surf->format = format;
+  surf->size = layer_bytes(width, height, format);
+  surf->pixels =
+      (uint8_t *)arena_alloc(ARENA_TAG_FRAMEBUFFER, surf->size, ARENA_ALIGN_DMA);
+  if (surf->pixels == NULL)
+    return false;
+  memset(surf->pixels, 0, surf->size);
+  return true;
+}
+
+bool compositor_init(uint16_t width, uint16_t height,
+                     display_pixel_format_t format, uint16_t rows, bool bg) {
+  active = false;
+  if (rows == 0 && !bg)
+    return true;
+  if (rows > height)
+    rows = height;
+
+  line_bytes = wire_line_bytes(width, format);
+  line_buffer =
+      (uint8_t *)arena_alloc(ARENA_TAG_PRESENT, 2 * line_bytes, ARENA_ALIGN_DMA);
+  if (line_buffer == NULL)
+    return false;
+
+  memset(&hud, 0, sizeof(hud));
+  memset(&background, 0, sizeof(background));
+  if (rows && !layer_alloc(&hud, width, rows, format))
+    return false;
+  if (bg && !layer_alloc(&background, width, height, format))
+    return false;
+
+  hud_rows = rows;
+  hud_dirty = true;
+  compositor_set_key(key_color);
+  active = true;
+  return true;
+}
+
+bool compositor_is_active(void) { return active; }
+
+surface_t *compositor_get_layer(compositor_layer_t layer) {
+  if (layer == COMPOSITOR_LAYER_GAME)
+    return framebuffer_get_surface();
+  surface_t *surf = (layer == COMPOSITOR_LAYER_HUD) ? &hud : &background;
+  return (active && surf->pixels) ? surf : NULL;
+}
+
+void compositor_mark_hud_dirty(void) { hud_dirty = true; }
+
+bool compositor_hud_is_dirty(void) { return hud_dirty; }
+
+void compositor_set_key(uint16_t color) {
+  key_color = color;
+
+  key_rgb565x2 = color | ((uint32_t)color << 16);
+
+  uint8_t r4 = ((color >> 11) & 0x1F) >> 1;
+  uint8_t g4 = ((color >> 5) & 0x3F) >> 2;
+  uint8_t b4 = (color & 0x1F) >> 1;
+  key_rgb444x2 = ((r4 << 4) | g4) | (((b4 << 4) | r4) << 8) |
+                 (((g4 << 4) | b4) << 16);
+
+  key_rgb332 = (((color >> 13) & 0x07) << 5) | (((color >> 8) & 0x07) << 2) |
+               ((color >> 3) & 0x03);
+}
+
+// --- Line Kernels ---
+static void compose_rgb565(uint8_t *dst, const uint8_t *fg, const uint8_t *bg,
+                           uint16_t width) {
+  const uint32_t *f = (const uint32_t *)fg;
+  const uint32_t *b = (const uint32_t *)bg;
+  uint32_t *d = (uint32_t *)dst;
+
+  for (uint16_t i = 0; i < width / 2; i++) {
+    uint32_t x = f[i] ^ key_rgb565x2;
+    uint32_t m = ((x & 0xFFFF) ? 0 : 0x0000FFFFu) |
+                 ((x >> 16) ? 0 : 0xFFFF0000u);
+    d[i] = m ? ((f[i] & ~m) | (b[i] & m)) : f[i];
+  }
+  if (width & 1) {
+    uint16_t i = width - 1;
+    const uint16_t *f16 = (const uint16_t *)fg;
+    ((uint16_t *)dst)[i] =
+        (f16[i] == key_color) ? ((const uint16_t *)bg)[i] : f16[i];
+  }
+}
+
+static void compose_rgb444(uint8_t *dst, const uint8_t *fg, const uint8_t *bg,
+                           uint16_t width) {
+  for (uint16_t i = 0; i < width / 2; i++, fg += 3, bg += 3, dst += 3) {
+    uint32_t g = fg[0] | (fg[1] << 8) | (fg[2] << 16);
+    uint32_t x = g ^ key_rgb444x2;
+    uint32_t m = ((x & PAIR_EVEN) ? 0 : PAIR_EVEN) |
+                 ((x & PAIR_ODD) ? 0 : PAIR_ODD);
+    if (m)
+      g = (g & ~m) | ((bg[0] | (bg[1] << 8) | (bg[2] << 16)) & m);
+    dst[0] = g & 0xFF;
+    dst[1] = (g >> 8) & 0xFF;
+    dst[2] = (g >> 16) & 0xFF;
+  }
+}
+
+static void expand_rgb332(uint16_t *dst, const uint8_t *fg, const uint8_t *bg,
+                          uint16_t width) {
+  const uint16_t *lut = framebuffer_get_rgb332_lut();
+  if (bg) {
+    for (uint16_t x = 0; x < width; x++) {
+      uint8_t c = fg[x];
+      dst[x] = lut[c == key_rgb332 ? bg[x] : c];
+    }
+  } else {
+    for (uint16_t x = 0; x < width; x++)
+      dst[x] = lut[fg[x]];
+  }
+}
+
+// Wire bytes for row y: points into a layer when no work is needed,
+// otherwise into `line`
+static const uint8_t *build_line(const surface_t *game, int y, uint8_t *line) {
+  uint32_t stride = layer_bytes(game->width, 1, game->format);
+  const uint8_t *bg = NULL;
+  const uint8_t *src;
+
+  if (y < hud_rows) {
+    src = hud.pixels + y * stride;
+  } else {
+    src = game->pixels + y * stride;
+    if (background.pixels)
+      bg = background.pixels + y * stride;
+  }
+
+  if (game->format == PIXEL_FORMAT_RGB332) {
+    expand_rgb332((uint16_t *)line, src, bg, game->width);
+    return line;
+  }
+  if (bg == NULL)
+    return src;
+
+  if (game->format == PIXEL_FORMAT_RGB565)
+    compose_rgb565(line, src, bg, game->width);
+  else
+    compose_rgb444(line, src, bg, game->width);
+  return line;
+}
+
+void compositor_present_task(void *arg) {
+  surface_t *game = (surface_t *)arg;
+  uint32_t stride = layer_bytes(game->width, 1, game->format);
+
+  // A clean HUD is already on the panel: start the window below it
+  bool send_hud = hud_dirty;
+  hud_dirty = false;
+  int y0 = send_hud ? 0 : hud_rows;
+  if (y0 >= game->height)
+    return;
+
+  display_end_bulk(); // Previous present must drain before re-windowing
+  display_set_window(0, y0, game->width - 1, game->height - 1);
+  display_start_bulk();
+
+  if (background.pixels == NULL && game->format != PIXEL_FORMAT_RGB332) {
+    // Nothing to compose: one DMA per layer, straight from its pixels
+    if (y0 < hud_rows) {
+      display_send_buffer(hud.pixels, hud.size);
+      display_wait_ready();
+    }
+    int g0 = (y0 > hud_rows) ? y0 : hud_rows;
+    if (g0 < game->height)
+      display_send_buffer(game->pixels + g0 * stride,
+                          (game->height - g0) * stride);
+    return;
+  }
+
+  // Build line y + 1 while line y is on the wire
+  const uint8_t *out = build_line(game, y0, line_buffer);
+  for (int y = y0; y < game->height; y++) {
+    display_wait_ready();
+    display_send_buffer(out, line_bytes);
+
+    if (y + 1 < game->height)
+      out = build_line(game, y + 1,
+                       line_buffer + ((y + 1 - y0) % 2) * line_bytes);
+  }
+
+  display_end_bulk();
+}
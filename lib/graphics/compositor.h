@@ -0,0 +1,55 @@
+#ifndef COMPOSITOR_H
+#define COMPOSITOR_H
+
+#include "surface.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Layered Compositor
+ * Merges up to three layers line by line while the frame streams out:
+ *  - BACKGROUND: cached full-screen surface, drawn once. Shows through game
+ *    pixels that equal the key colour.
+ *  - GAME: the framebuffer's back buffer, redrawn every frame.
+ *  - HUD: opaque strip over the top rows, retained between frames. Its rows
+ *    only go on the wire while the strip is dirty.
+ * Only the HUD tracks dirty state: the game layer is a new back buffer every
+ * present, and the background shows through it on any line, so both are
+ * composed and sent every present.
+ * The present runs on Core 1 (like the RGB332 flush) and takes precedence
+ * over raster effects, row-hash presents and the triple-buffer queue.
+ */
+
+typedef enum {
+  COMPOSITOR_LAYER_BACKGROUND = 0,
+  COMPOSITOR_LAYER_GAME,
+  COMPOSITOR_LAYER_HUD,
+  COMPOSITOR_LAYER_COUNT
+} compositor_layer_t;
+
+// Arena bytes compositor_init() consumes (hud_rows 0 = no HUD strip)
+uint32_t compositor_get_arena_size(uint16_t width, uint16_t height,
+                                   display_pixel_format_t format,
+                                   uint16_t hud_rows, bool background);
+
+// Call after framebuffer_init (buffered modes only)
+bool compositor_init(uint16_t width, uint16_t height,
+                     display_pixel_format_t format, uint16_t hud_rows,
+                     bool background);
+bool compositor_is_active(void);
+
+// Surface to draw a layer into (NULL if the layer is disabled). GAME is
+// the current back buffer.
+surface_t *compositor_get_layer(compositor_layer_t layer);
+
+// The HUD strip changed (or the panel lost it): resend it at the next present
+void compositor_mark_hud_dirty(void);
+bool compositor_hud_is_dirty(void);
+
+// Game colour that reveals the background (default 0x0000)
+void compositor_set_key(uint16_t color);
+
+// Core 1 present task (render job callback, arg = game surface)
+void compositor_present_task(void *arg);
+
+#endif
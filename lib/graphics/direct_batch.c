@@ -0,0 +1,129 @@
+#include "direct_batch.h"
+#include "arena.h"
+#include "display_driver.h"
+#include <string.h>
+
+typedef struct {
+  uint16_t x, y, w, h;
+  uint16_t color;
+} batch_rect_t;
+
+// How far back a new rectangle may travel looking for a merge/sort slot
+#define BATCH_SCAN_DEPTH 32
+
+static batch_rect_t *rects = NULL;
+static uint16_t capacity = 0;
+static uint16_t count = 0;
+
+static uint32_t submitted = 0;
+static uint32_t last_submitted = 0;
+static uint32_t last_emitted = 0;
+
+uint32_t direct_batch_get_arena_size(uint16_t cap) {
+  return arena_reserve_size(cap * sizeof(batch_rect_t), 4);
+}
+
+bool direct_batch_init(uint16_t cap) {
+  rects = (batch_rect_t *)arena_alloc(ARENA_TAG_PRESENT,
+                                      cap * sizeof(batch_rect_t), 4);
+  if (rects == NULL)
+    return false;
+  capacity = cap;
+  count = 0;
+  return true;
+}
+
+static bool overlaps(const batch_rect_t *a, const batch_rect_t *b) {
+  return a->x < b->x + b->w && b->x < a->x + a->w && a->y < b->y + b->h &&
+         b->y < a->y + a->h;
+}
+
+// Grow `e` to cover `r` when the union is still a rectangle
+static bool try_merge(batch_rect_t *e, const batch_rect_t *r) {
+  if (e->color != r->color)
+    return false;
+
+  // Same rows, touching or overlapping columns
+  if (e->y == r->y && e->h == r->h && r->x <= e->x + e->w &&
+      e->x <= r->x + r->w) {
+    uint16_t x1 = (e->x + e->w > r->x + r->w) ? e->x + e->w : r->x + r->w;
+    if (r->x < e->x)
+      e->x = r->x;
+    e->w = x1 - e->x;
+    return true;
+  }
+
+  // Same columns, touching or overlapping rows
+  if (e->x == r->x && e->w == r->w && r->y <= e->y + e->h &&
+      e->y <= r->y + r->h) {
+    uint16_t y1 = (e->y + e->h > r->y + r->h) ? e->y + e->h : r->y + r->h;
+    if (r->y < e->y)
+      e->y = r->y;
+    e->h = y1 - e->y;
+    return true;
+  }
+
+  // Already covered
+  return r->x >= e->x && r->y >= e->y && r->x + r->w <= e->x + e->w &&
+         r->y + r->h <= e->y + e->h;
+}
+
+void direct_batch_rect(int x, int y, int w, int h, uint16_t color) {
+  if (rects == NULL || w <= 0 || h <= 0)
+    return;
+
+  batch_rect_t r = {.x = x, .y = y, .w = w, .h = h, .color = color};
+  submitted++;
+
+  // Walk back over rectangles `r` does not touch: merging into, or sorting
+  // in front of, any of them leaves the painted result unchanged.
+  int insert_at = count;
+  int limit = (count > BATCH_SCAN_DEPTH) ? count - BATCH_SCAN_DEPTH : 0;
+  for (int i = count - 1; i >= limit; i--) {
+    batch_rect_t *e = &rects[i];
+    if (try_merge(e, &r))
+      return;
+    if (overlaps(e, &r))
+      break; // Painter's order must be kept past this one
+    if (e->y > r.y)
+      insert_at = i;
+  }
+
+  if (count == capacity) {
+    direct_batch_flush();
+    insert_at = 0;
+  }
+
+  memmove(&rects[insert_at + 1], &rects[insert_at],
+          (count - insert_at) * sizeof(batch_rect_t));
+  rects[insert_at] = r;
+  count++;
+}
+
+void direct_batch_clear(uint16_t width, uint16_t height, uint16_t color) {
+  if (rects == NULL)
+    return;
+  submitted += count; // Discarded but still submitted by the app
+  count = 0;
+  direct_batch_rect(0, 0, width, height, color);
+}
+
+void direct_batch_flush(void) {
+  for (uint16_t i = 0; i < count; i++) {
+    const batch_rect_t *r = &rects[i];
+    display_set_window(r->x, r->y, r->x + r->w - 1, r->y + r->h - 1);
+    display_start_bulk();
+    display_push_pixels(r->color, (uint32_t)r->w * r->h);
+    display_end_bulk();
+  }
+
+  last_submitted = submitted;
+  last_emitted = count;
+  submitted = 0;
+  count = 0;
+}
+
+void direct_batch_get_stats(uint32_t *out_submitted, uint32_t *out_emitted) {
+  *out_submitted = last_submitted;
+  *out_emitted = last_emitted;
+}
@@ -0,0 +1,36 @@
+#ifndef DIRECT_BATCH_H
+#define DIRECT_BATCH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Direct Mode Batcher (buffer_count == 0)
+ * Records solid-colour rectangles for the frame instead of writing each
+ * primitive to the panel. Adjacent same-colour spans are merged, the list is
+ * kept roughly sorted by y without reordering overlapping primitives, and the
+ * flush sends one window + one ring-DMA fill per surviving rectangle.
+ */
+
+// Default rectangles held before a forced mid-frame flush
+#define DIRECT_BATCH_CAPACITY 512
+
+// Arena bytes direct_batch_init() consumes
+uint32_t direct_batch_get_arena_size(uint16_t capacity);
+
+bool direct_batch_init(uint16_t capacity);
+
+// Record a rectangle (already clipped to the screen)
+void direct_batch_rect(int x, int y, int w, int h, uint16_t color);
+
+// Full-screen fill: earlier rectangles are discarded
+void direct_batch_clear(uint16_t width, uint16_t height, uint16_t color);
+
+// Send everything recorded so far and empty the batch. Call before any
+// write that goes to the panel directly.
+void direct_batch_flush(void);
+
+// Rectangles recorded vs. sent by the last flush
+void direct_batch_get_stats(uint32_t *submitted, uint32_t *emitted);
+
+#endif
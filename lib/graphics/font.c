@@ -1,6 +1,7 @@
 #include "font.h"
-#include "framebuffer.h"
+#include "direct_batch.h"
 #include "display_driver.h"
+#include "framebuffer.h"
 
 
 static const uint8_t font_5x7_data[][5] = {
@@ -70,33 +71,34 @@ const font_t font_5x7 = {.data = (const uint8_t *)font_5x7_data,
                          .height = 7,
                          .scale = 1};
 
-void font_draw_char(surface_t *surf, int x, int y, char c, uint16_t fg,
-                    uint16_t bg, const font_t *font) {
+const uint8_t *font_glyph(const font_t *font, char c) {
   if (c < 0x20 || c > 0x5A) {
     if (c >= 'a' && c <= 'z')
       c -= 32;
-    else if (c == 'k')
-      c = 'K';
     else
-      return;
+      return NULL;
   }
+  return font->data + ((c - 0x20) * 5);
+}
 
-  int index = c - 0x20;
-  const uint8_t *glyph = font->data + (index * 5);
+void font_draw_char(surface_t *surf, int x, int y, char c, uint16_t fg,
+                    uint16_t bg, const font_t *font) {
+  const uint8_t *glyph = font_glyph(font, c);
+  if (glyph == NULL)
+    return;
 
   if (surf->pixels == NULL && font->scale == 1) {
     uint16_t buffer[35];
-    uint16_t fg_be = (fg >> 8) | (fg << 8);
-    uint16_t bg_be = (bg >> 8) | (bg << 8);
 
     int idx = 0;
     for (int row = 0; row < 7; row++) {
       for (int col = 0; col < 5; col++) {
         uint8_t bits = glyph[col];
-        buffer[idx++] = (bits & (1 << row)) ? fg_be : bg_be;
+        buffer[idx++] = (bits & (1 << row)) ? fg : bg;
       }
     }
     
+    direct_batch_flush(); // Keep painter's order with batched fills
     display_set_window(x, y, x + 4, y + 6);
     display_start_bulk();
     display_send_buffer((uint8_t *)buffer, 70);
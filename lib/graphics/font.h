@@ -13,6 +13,10 @@ typedef struct {
 // Built-in 5x7 font
 extern const font_t font_5x7;
 
+// Column bitmap of a glyph (5 bytes, bit n = row n), NULL if unsupported.
+// Lowercase maps to uppercase.
+const uint8_t *font_glyph(const font_t *font, char c);
+
 // Drawing functions
 void font_draw_char(surface_t *surf, int x, int y, char c, uint16_t fg,
                     uint16_t bg, const font_t *font);
@@ -1,9 +1,16 @@
 #include "framebuffer.h"
+#include "arena.h"
+#include "compositor.h"
 #include "display_driver.h"
+#include "direct_batch.h"
 #include "dma_mem.h"
+#include "occlusion.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
 #include "render_service.h"
+#include "span.h"
+#include "system_config.h"
 #include "surface.h"
-#include <stdlib.h>
 #include <string.h>
 
 static surface_t surfaces[3]; // Max 3 buffers
@@ -21,8 +28,102 @@ typedef enum {
 
 static swap_state_t swap_active = SWAP_IDLE;
 
+// Row-hash present: CRC of each band as the *panel* currently holds it.
+// Comparing against the panel (not the buffer's own history) keeps double
+// and triple buffering correct, since the buffers alternate on the wire.
+static present_mode_t present_mode = PRESENT_MODE_FULL;
+static uint32_t *band_crc = NULL;
+static uint16_t band_count = 0;
+static bool band_crc_valid = false;
+static volatile uint16_t bands_sent = 0;
+
+// Present Queue (buffer_count == 3, DMA formats, full-frame presents).
+// Finished frames queue up. The transport's completion IRQ retires the
+// scanout buffer and pends a lowest-priority IRQ that starts the next frame,
+// so the wire never waits for Core 0, which only blocks when no buffer is
+// free.
+typedef enum {
+  BUF_FREE = 0,
+  BUF_DRAWING,
+  BUF_QUEUED,
+  BUF_SCANOUT
+} buffer_state_t;
+
+static volatile buffer_state_t buffer_state[3];
+static volatile int8_t scanout_idx = -1;
+static volatile int8_t present_queue[2];
+static volatile uint8_t present_queue_len = 0;
+static volatile uint32_t queued_at_us[3];
+static present_queue_mode_t queue_mode = PRESENT_QUEUE_FIFO;
+static int queue_kick_irq = -1; // User IRQ running queue_pump on Core 0
+
+// Scroll present: logical rows [dirty_y0, dirty_y1) changed since the last
+// present. The panel's scroll start follows the surfaces' ring offset.
+static int16_t dirty_y0 = 0;
+static int16_t dirty_y1 = 0;
+static bool scroll_area_set = false;
+static bool scroll_start_dirty = false;
+
+// Interlaced present: row parity of the next field
+static uint8_t field_parity = 0;
+
+// Raster effect, evaluated per output line during the present
+static raster_effect_t raster_effect = NULL;
+static void *raster_arg = NULL;
+
+// Present-complete notification
+static void (*present_cb)(void *) = NULL;
+static void *present_cb_arg = NULL;
+static volatile bool dma_present_pending = false; // Next completion ends it
+static void (*core1_present)(void *) = NULL;      // Task wrapped on Core 1
+static uint32_t core1_present_ticket = 0;         // Its render-service job
+
+static void queue_reset(void);
+static void queue_pump(void);
+static void present_notify(void);
+static void present_on_complete(void *arg);
+
 // Instrumentation
 static volatile uint32_t last_wait_time_us = 0;
+static volatile uint32_t queue_drops = 0;
+static volatile uint32_t queue_latency_us = 0;
+static volatile uint32_t queue_latency_samples = 0;
+static volatile uint8_t queue_max_depth = 0;
+
+static uint32_t surface_bytes(uint16_t width, uint16_t height,
+                              display_pixel_format_t format) {
+  if (format == PIXEL_FORMAT_RGB565)
+    return width * height * 2;
+  if (format == PIXEL_FORMAT_RGB444)
+    return (width * height * 3) / 2;
+  return width * height; // RGB332
+}
+
+static uint16_t band_count_for(uint16_t height) {
+  return (height + PRESENT_BAND_ROWS - 1) / PRESENT_BAND_ROWS;
+}
+
+// Bytes per row in the packed surface layout
+static uint32_t surface_stride(const surface_t *surf) {
+  return surface_bytes(surf->width, 1, surf->format);
+}
+
+uint32_t framebuffer_get_arena_size(uint16_t width, uint16_t height,
+                                    display_pixel_format_t format,
+                                    uint8_t count) {
+  if (count > 3)
+    count = 3;
+  if (count == 0)
+    return direct_batch_get_arena_size(DIRECT_BATCH_CAPACITY);
+
+  uint32_t bytes =
+      count * arena_reserve_size(surface_bytes(width, height, format),
+                                 ARENA_ALIGN_DMA);
+  if (format == PIXEL_FORMAT_RGB332)
+    bytes += arena_reserve_size(width * 2 * 2, ARENA_ALIGN_DMA);
+  bytes += arena_reserve_size(band_count_for(height) * sizeof(uint32_t), 4);
+  return bytes;
+}
 
 bool framebuffer_init(uint16_t width, uint16_t height,
                       display_pixel_format_t format, uint8_t count) {
@@ -34,22 +135,35 @@ bool framebuffer_init(uint16_t width, uint16_t height,
 
   uint32_t fb_size = 0;
   if (count > 0) {
-    if (format == PIXEL_FORMAT_RGB565) {
-      fb_size = width * height * 2;
-    } else if (format == PIXEL_FORMAT_RGB444) {
-      fb_size = (width * height * 3) / 2;
-    } else { // RGB332
-      fb_size = width * height;
+    fb_size = surface_bytes(width, height, format);
+    if (format == PIXEL_FORMAT_RGB332) {
       // Line buffers for streaming expansion (Ping-Pong: 2 lines)
-      expansion_buffer = (uint8_t *)malloc(width * 2 * 2);
+      expansion_buffer = (uint8_t *)arena_alloc(ARENA_TAG_PRESENT,
+                                                width * 2 * 2, ARENA_ALIGN_DMA);
       if (expansion_buffer == NULL)
         return false;
     }
   }
 
+  if (count == 0) {
+    // Direct Mode: batched fills, panel driven in 16-bit so each rectangle
+    // is a single ring-DMA (RGB444's 3-byte pairs cannot ring)
+    if (!direct_batch_init(DIRECT_BATCH_CAPACITY))
+      return false;
+    display_set_wire_format(PIXEL_FORMAT_RGB565);
+  } else {
+    band_count = band_count_for(height);
+    band_crc = (uint32_t *)arena_alloc(ARENA_TAG_PRESENT,
+                                       band_count * sizeof(uint32_t), 4);
+    if (band_crc == NULL)
+      return false;
+    band_crc_valid = false;
+  }
+
   for (int i = 0; i < 3; i++) {
     if (i < count && count > 0) {
-      surfaces[i].pixels = (uint8_t *)malloc(fb_size);
+      surfaces[i].pixels = (uint8_t *)arena_alloc(ARENA_TAG_FRAMEBUFFER,
+                                                  fb_size, ARENA_ALIGN_DMA);
       if (surfaces[i].pixels == NULL)
         return false;
       memset(surfaces[i].pixels, 0, fb_size);
@@ -70,12 +184,22 @@ bool framebuffer_init(uint16_t width, uint16_t height,
       uint16_t r5 = (r3 << 2) | (r3 >> 1);
       uint16_t g6 = (g3 << 3) | g3;
       uint16_t b5 = (b2 << 3) | (b2 << 1) | (b2 >> 1);
-      uint16_t rgb565 = (r5 << 11) | (g6 << 5) | b5;
-      rgb332_to_rgb565[i] = (rgb565 >> 8) | ((rgb565 & 0xFF) << 8);
+      rgb332_to_rgb565[i] = (r5 << 11) | (g6 << 5) | b5;
     }
     lut_initialized = true;
   }
 
+  queue_reset();
+  if (queue_kick_irq < 0) {
+    // Below DMA_IRQ_0, so a start never delays a completion
+    queue_kick_irq = user_irq_claim_unused(true);
+    irq_set_exclusive_handler(queue_kick_irq, queue_pump);
+    irq_set_priority(queue_kick_irq, PICO_LOWEST_IRQ_PRIORITY);
+    irq_set_enabled(queue_kick_irq, true);
+  }
+  dma_present_pending = false;
+  display_set_complete_callback(present_on_complete, NULL);
+
   dma_mem_init();
   render_service_init();
 
@@ -86,17 +210,18 @@ surface_t *framebuffer_get_surface(void) { return &surfaces[back_buffer_idx]; }
 
 void draw_clear(surface_t *surf, uint16_t color) {
   if (surf->pixels == NULL) {
-    // Direct Mode Flood
-    display_set_window(0, 0, surf->width - 1, surf->height - 1);
-    display_start_bulk();
-    display_push_pixels(color, (uint32_t)surf->width * surf->height);
-    display_end_bulk();
+    // Direct Mode Flood (batched until present)
+    direct_batch_clear(surf->width, surf->height, color);
     return;
   }
 
-  // Note: This still uses the render_service for multicore clearing
+  if (occlusion_record_clear(surf, color))
+    return; // Resolved at present, minus covered spans
+
+  // Core 1 clears the second half, unless a pipelined update holds it
+  bool split = render_service_core1_free();
   uint32_t total_bytes = surf->size;
-  uint32_t half_bytes = total_bytes / 2;
+  uint32_t half_bytes = split ? total_bytes / 2 : total_bytes;
 
   if (surf->format == PIXEL_FORMAT_RGB444) {
     half_bytes -= (half_bytes % 12);
@@ -106,9 +231,7 @@ void draw_clear(surface_t *surf, uint16_t color) {
 
   uint32_t color32 = 0;
   if (surf->format == PIXEL_FORMAT_RGB565) {
-    uint8_t hi = color >> 8;
-    uint8_t lo = color & 0xFF;
-    color32 = (lo << 24) | (hi << 16) | (lo << 8) | hi;
+    color32 = color | ((uint32_t)color << 16);
   } else if (surf->format == PIXEL_FORMAT_RGB332) {
     uint8_t r3 = (color >> 13) & 0x07;
     uint8_t g3 = (color >> 8) & 0x07;
@@ -118,13 +241,16 @@ void draw_clear(surface_t *surf, uint16_t color) {
   }
 
   // Submit job to Core 1
-  render_job_t job = {.type = RENDER_CMD_CLEAR,
-                      .surface = surf,
-                      .color16 = color,
-                      .color32 = color32,
-                      .start_offset = half_bytes,
-                      .count = (total_bytes - half_bytes) / 4};
-  render_service_submit(&job);
+  uint32_t ticket = 0;
+  if (split) {
+    render_job_t job = {.type = RENDER_CMD_CLEAR,
+                        .surface = surf,
+                        .color16 = color,
+                        .color32 = color32,
+                        .start_offset = half_bytes,
+                        .count = (total_bytes - half_bytes) / 4};
+    ticket = render_service_submit(&job);
+  }
 
   // Core 0 Job
   if (surf->format == PIXEL_FORMAT_RGB444) {
@@ -149,7 +275,8 @@ void draw_clear(surface_t *surf, uint16_t color) {
     dma_mem_fill32((uint32_t *)surf->pixels, color32, half_bytes / 4);
   }
 
-  render_service_wait();
+  if (split)
+    render_service_wait_job(ticket);
   dma_mem_wait();
 }
 
@@ -158,20 +285,17 @@ void draw_pixel(surface_t *surf, int x, int y, uint16_t color) {
     return;
 
   if (surf->pixels == NULL) {
-    // Direct Mode
-    display_set_window(x, y, x, y);
-    display_start_bulk();
-    display_push_pixels(color, 1);
-    display_end_bulk();
+    // Direct Mode (batched until present)
+    direct_batch_rect(x, y, 1, 1, color);
     return;
   }
 
+  occlusion_note_pixel(surf, x, y);
+  uint32_t pixel_idx = surface_index(surf, x, y);
+
   if (surf->format == PIXEL_FORMAT_RGB565) {
-    int idx = (y * surf->width + x) * 2;
-    surf->pixels[idx] = color >> 8;
-    surf->pixels[idx + 1] = color & 0xFF;
+    ((uint16_t *)surf->pixels)[pixel_idx] = color;
   } else if (surf->format == PIXEL_FORMAT_RGB444) {
-    int pixel_idx = y * surf->width + x;
     int byte_idx = (pixel_idx / 2) * 3;
     uint8_t r4 = ((color >> 11) & 0x1F) >> 1;
     uint8_t g4 = ((color >> 5) & 0x3F) >> 2;
@@ -185,11 +309,10 @@ void draw_pixel(surface_t *surf, int x, int y, uint16_t color) {
       surf->pixels[byte_idx + 2] = (g4 << 4) | b4;
     }
   } else { // RGB332
-    int idx = y * surf->width + x;
     uint8_t r3 = (color >> 13) & 0x07;
     uint8_t g3 = (color >> 8) & 0x07;
     uint8_t b2 = (color >> 3) & 0x03;
-    surf->pixels[idx] = (r3 << 5) | (g3 << 2) | b2;
+    surf->pixels[pixel_idx] = (r3 << 5) | (g3 << 2) | b2;
   }
 }
 
@@ -210,51 +333,31 @@ void draw_rect(surface_t *surf, int x, int y, int w, int h, uint16_t color) {
     return;
 
   if (surf->pixels == NULL) {
-    // Direct Mode
-    display_set_window(x, y, x + w - 1, y + h - 1);
-    display_start_bulk();
-    display_push_pixels(color, (uint32_t)w * h);
-    display_end_bulk();
+    // Direct Mode (batched until present)
+    direct_batch_rect(x, y, w, h, color);
     return;
   }
 
-  if (surf->format == PIXEL_FORMAT_RGB444) {
-    uint8_t r4 = ((color >> 11) & 0x1F) >> 1;
-    uint8_t g4 = ((color >> 5) & 0x3F) >> 2;
-    uint8_t b4 = (color & 0x1F) >> 1;
-    uint8_t b0 = (r4 << 4) | g4;
-    uint8_t b1 = (b4 << 4) | r4;
-    uint8_t b2 = (g4 << 4) | b4;
-    uint32_t w0 = b0 | (b1 << 8) | (b2 << 16) | (b0 << 24);
-    uint32_t w1 = b1 | (b2 << 8) | (b0 << 16) | (b1 << 24);
-    uint32_t w2 = b2 | (b0 << 8) | (b1 << 16) | (b2 << 24);
+  if (occlusion_record_rect(surf, x, y, w, h, color))
+    return;
 
-    for (int row = 0; row < h; row++) {
-      int py = y + row;
-      int start_pixel = py * surf->width + x;
-      if ((start_pixel % 8 == 0) && (w % 8 == 0)) {
-        uint32_t *ptr32 = (uint32_t *)&surf->pixels[(start_pixel / 2) * 3];
-        int words = (w / 8) * 3;
-        for (int i = 0; i < words; i += 3) {
-          ptr32[i] = w0;
-          ptr32[i + 1] = w1;
-          ptr32[i + 2] = w2;
-        }
-      } else {
-        for (int px = x; px < x + w; px++)
-          draw_pixel(surf, px, py, color);
-      }
-    }
-  } else {
-    for (int row = 0; row < h; row++) {
-      for (int col = 0; col < w; col++) {
-        draw_pixel(surf, x + col, y + row, color);
-      }
-    }
+  if (surf->layout == SURFACE_LAYOUT_COLUMN_MAJOR) {
+    for (int col = 0; col < w; col++)
+      span_fill_v(surf, x + col, y, h, color);
+    return;
   }
+  for (int row = 0; row < h; row++)
+    span_fill(surf, x, y + row, w, color);
+}
+
+void draw_vline(surface_t *surf, int x, int y, int h, uint16_t color) {
+  draw_rect(surf, x, y, 1, h, color);
 }
 
 void draw_circle(surface_t *surf, int cx, int cy, int radius, uint16_t color) {
+  if (occlusion_record_circle(surf, cx, cy, radius, color))
+    return;
+
   int x = radius;
   int y = 0;
   int err = 0;
@@ -272,6 +375,86 @@ void draw_circle(surface_t *surf, int cx, int cy, int radius, uint16_t color) {
   }
 }
 
+bool draw_copy_rect_async(surface_t *dst, int dx, int dy, const surface_t *src,
+                          int sx, int sy, int w, int h, void (*done)(void *),
+                          void *arg) {
+  if (dst->pixels == NULL || src->pixels == NULL ||
+      dst->format != src->format || dst->layout != src->layout)
+    return false;
+
+  // Clip against both surfaces
+  if (sx < 0) {
+    w += sx;
+    dx -= sx;
+    sx = 0;
+  }
+  if (sy < 0) {
+    h += sy;
+    dy -= sy;
+    sy = 0;
+  }
+  if (dx < 0) {
+    w += dx;
+    sx -= dx;
+    dx = 0;
+  }
+  if (dy < 0) {
+    h += dy;
+    sy -= dy;
+    dy = 0;
+  }
+  if (sx + w > src->width)
+    w = src->width - sx;
+  if (sy + h > src->height)
+    h = src->height - sy;
+  if (dx + w > dst->width)
+    w = dst->width - dx;
+  if (dy + h > dst->height)
+    h = dst->height - dy;
+  if (w <= 0 || h <= 0)
+    return false;
+
+  // Column-major surfaces store columns as lines: copy w lines of h pixels
+  uint32_t src_stride = surface_stride(src);
+  uint32_t dst_stride = surface_stride(dst);
+  if (dst->layout == SURFACE_LAYOUT_COLUMN_MAJOR) {
+    int t = sx;
+    sx = sy;
+    sy = t;
+    t = dx;
+    dx = dy;
+    dy = t;
+    t = w;
+    w = h;
+    h = t;
+    src_stride = surface_bytes(src->height, 1, src->format);
+    dst_stride = surface_bytes(dst->height, 1, dst->format);
+  }
+
+  if (dst->format == PIXEL_FORMAT_RGB444 && ((sx | dx | w) & 1))
+    return false; // Pixel pairs share a byte
+
+  // Scrolled surfaces: the rows must not cross the ring seam (column-major
+  // surfaces never scroll, and clipping already bounds their lines)
+  int src_row = sy;
+  int dst_row = dy;
+  if (dst->layout == SURFACE_LAYOUT_ROW_MAJOR) {
+    src_row = surface_row(src, sy);
+    dst_row = surface_row(dst, dy);
+    if (src_row + h > src->height || dst_row + h > dst->height)
+      return false;
+  }
+
+  occlusion_resolve(); // Recorded primitives land before the copy
+
+  const uint8_t *from = src->pixels + src_row * src_stride +
+                        surface_bytes(sx, 1, src->format);
+  uint8_t *to = dst->pixels + dst_row * dst_stride +
+                surface_bytes(dx, 1, dst->format);
+  return dma_mem_copy_rect(to, dst_stride, from, src_stride,
+                           surface_bytes(w, 1, dst->format), h, done, arg);
+}
+
 void framebuffer_clear(uint16_t color) {
   draw_clear(framebuffer_get_surface(), color);
 }
@@ -280,19 +463,19 @@ void framebuffer_fill_circle(int cx, int cy, int radius, uint16_t color) {
   draw_circle(framebuffer_get_surface(), cx, cy, radius, color);
 }
 
-// --- Core 1 Task ---
-static void flush_rgb332_task(void *arg) {
-    surface_t *surf = (surface_t *)arg;
+// --- Core 1 Tasks ---
+// Stream rows [y0, y1) through the RGB332 -> RGB565 expansion line buffers
+static void flush_rgb332_rows(surface_t *surf, int y0, int y1) {
     uint16_t *expansion_base = (uint16_t *)expansion_buffer;
     uint32_t stride = surf->width;
     
     // Set Window ONCE
-    display_set_window(0, 0, surf->width - 1, surf->height - 1);
+    display_set_window(0, y0, surf->width - 1, y1 - 1);
     display_start_bulk();
 
-    // 1. Pre-fill first buffer (Line 0)
+    // 1. Pre-fill first buffer (Line y0)
     {
-      uint8_t *src = surf->pixels;
+      uint8_t *src = surf->pixels + (y0 * stride);
       uint16_t *dst = expansion_base; // Buffer 0
       for (int x = 0; x < stride; x++) {
         dst[x] = rgb332_to_rgb565[src[x]];
@@ -300,19 +483,19 @@ static void flush_rgb332_task(void *arg) {
     }
 
     // 2. Main Loop
-    for (int y = 0; y < surf->height; y++) {
-      int curr_buf_idx = y % 2;
-      int next_buf_idx = (y + 1) % 2;
+    for (int y = y0; y < y1; y++) {
+      int curr_buf_idx = (y - y0) % 2;
+      int next_buf_idx = (y - y0 + 1) % 2;
       uint16_t *curr_buf = expansion_base + (curr_buf_idx * stride);
       uint16_t *next_buf = expansion_base + (next_buf_idx * stride);
 
       // Wait for previous line DMA
-      while(display_is_busy()) ; 
+      display_wait_ready();
       
       display_send_buffer((uint8_t*)curr_buf, stride * 2);
 
       // Convert next line
-      if (y < surf->height - 1) {
+      if (y < y1 - 1) {
         uint8_t *src = surf->pixels + ((y + 1) * stride);
         for (int x = 0; x < stride; x++) {
           next_buf[x] = rgb332_to_rgb565[src[x]];
@@ -323,12 +506,403 @@ static void flush_rgb332_task(void *arg) {
     display_end_bulk(); 
 }
 
+static void flush_rgb332_task(void *arg) {
+    surface_t *surf = (surface_t *)arg;
+    flush_rgb332_rows(surf, 0, surf->height);
+}
+
+// Send rows [y0, y1). DMA formats leave the transfer in flight.
+static void present_rows(surface_t *surf, int y0, int y1) {
+  if (surf->format == PIXEL_FORMAT_RGB332) {
+    flush_rgb332_rows(surf, y0, y1);
+    return;
+  }
+
+  uint32_t stride = surface_stride(surf);
+  display_end_bulk(); // Previous run must drain before re-windowing
+  display_set_window(0, y0, surf->width - 1, y1 - 1);
+  display_start_bulk();
+  display_send_buffer(surf->pixels + (y0 * stride), (y1 - y0) * stride);
+}
+
+// Hash each band with the DMA sniffer and send only runs of changed bands
+static void present_row_hash_task(void *arg) {
+  surface_t *surf = (surface_t *)arg;
+  uint32_t stride = surface_stride(surf);
+  int run_start = -1;
+  uint16_t sent = 0;
+
+  for (int b = 0; b <= band_count; b++) {
+    bool changed = false;
+    if (b < band_count) {
+      int y0 = b * PRESENT_BAND_ROWS;
+      int rows = surf->height - y0;
+      if (rows > PRESENT_BAND_ROWS)
+        rows = PRESENT_BAND_ROWS;
+
+      uint32_t crc = dma_mem_crc32(surf->pixels + (y0 * stride), rows * stride);
+      changed = !band_crc_valid || crc != band_crc[b];
+      band_crc[b] = crc;
+    }
+
+    if (changed) {
+      if (run_start < 0)
+        run_start = b;
+      sent++;
+    } else if (run_start >= 0) {
+      int y1 = b * PRESENT_BAND_ROWS;
+      if (y1 > surf->height)
+        y1 = surf->height;
+      present_rows(surf, run_start * PRESENT_BAND_ROWS, y1);
+      run_start = -1;
+    }
+  }
+
+  band_crc_valid = true;
+  bands_sent = sent;
+}
+
+// --- Interlaced Present ---
+// Send every other row, alternating parity per present. The panel cannot
+// skip rows inside a window, so each row gets its own page window: the
+// column range is cached, and PASET's parameters go out as one burst, so a
+// row costs a PIO drain plus 6 bytes at the command clock. The rows of the
+// other field keep the previous frame's pixels.
+static void present_interlaced_task(void *arg) {
+  surface_t *surf = (surface_t *)arg;
+  for (int y = field_parity; y < surf->height; y += 2)
+    present_rows(surf, y, y + 1);
+  field_parity ^= 1;
+  band_crc_valid = false;
+}
+
+// Offloaded presents end on Core 1 once their last line has left memory
+static void present_core1_task(void *arg) {
+  core1_present(arg);
+  display_wait_ready();
+  present_notify();
+}
+
+// --- Scroll Present ---
+// Single retained buffer: only the dirty rows (up to two runs around the
+// ring seam) go out, then the panel scrolls onto them.
+static void present_scroll(surface_t *surf) {
+  framebuffer_wait_last_swap();
+
+  if (!scroll_area_set) {
+    display_set_scroll_area(0, surf->height,
+                            DISPLAY_GATE_LINES - surf->height);
+    scroll_area_set = true;
+    scroll_start_dirty = true;
+  }
+
+  int rows = dirty_y1 - dirty_y0;
+  if (rows > 0) {
+    int p0 = surface_row(surf, dirty_y0);
+    int first = surf->height - p0;
+    if (first > rows)
+      first = rows;
+    if (rows > first) {
+      present_rows(surf, p0, p0 + first);
+      display_end_bulk(); // Only the last run's completion ends the present
+      p0 = 0;
+      first = rows - first;
+    }
+    if (surf->format == PIXEL_FORMAT_RGB332) {
+      // One DMA per expanded line, and the rows have all left on return
+      present_rows(surf, p0, p0 + first);
+      present_notify();
+    } else {
+      dma_present_pending = true; // The run is a single DMA
+      present_rows(surf, p0, p0 + first);
+      swap_active = SWAP_DMA;
+    }
+  } else {
+    present_notify(); // Nothing changed on the wire
+  }
+
+  if (scroll_start_dirty) {
+    display_end_bulk(); // New rows land before the panel scrolls onto them
+    display_set_scroll_start(surf->row_offset);
+    scroll_start_dirty = false;
+    swap_active = SWAP_IDLE;
+  }
+
+  dirty_y0 = dirty_y1 = 0;
+  band_crc_valid = false; // Row-hash CRCs no longer match the panel
+}
+
+bool framebuffer_scroll(int rows) {
+  surface_t *surf = &surfaces[back_buffer_idx];
+  // Only the scroll present programs the panel's scroll start; the other
+  // presents would send the rotated rows with the panel unscrolled
+  if (surf->pixels == NULL || present_mode != PRESENT_MODE_SCROLL ||
+      !display_scroll_is_vertical() || compositor_is_active() ||
+      raster_effect != NULL || surf->layout != SURFACE_LAYOUT_ROW_MAJOR)
+    return false;
+
+  int h = surf->height;
+  framebuffer_wait_last_swap(); // Stored rows may still be on the wire
+  if (rows >= h || rows <= -h) {
+    framebuffer_mark_rows_dirty(0, h);
+    rows %= h;
+  }
+
+  uint16_t offset = (surf->row_offset + rows + h) % h;
+  for (int i = 0; i < 3; i++)
+    surfaces[i].row_offset = offset;
+
+  // Rows already marked move with the content
+  if (dirty_y1 > dirty_y0) {
+    int y0 = dirty_y0 - rows;
+    int y1 = dirty_y1 - rows;
+    dirty_y0 = (y0 < 0) ? 0 : (y0 > h ? h : y0);
+    dirty_y1 = (y1 < 0) ? 0 : (y1 > h ? h : y1);
+  }
+  if (rows > 0)
+    framebuffer_mark_rows_dirty(h - rows, h);
+  else if (rows < 0)
+    framebuffer_mark_rows_dirty(0, -rows);
+
+  scroll_start_dirty = true;
+  return true;
+}
+
+void framebuffer_mark_rows_dirty(int y0, int y1) {
+  int h = surfaces[0].height;
+  if (y0 < 0)
+    y0 = 0;
+  if (y1 > h)
+    y1 = h;
+  if (y0 >= y1)
+    return;
+  if (dirty_y1 <= dirty_y0) {
+    dirty_y0 = y0;
+    dirty_y1 = y1;
+    return;
+  }
+  if (y0 < dirty_y0)
+    dirty_y0 = y0;
+  if (y1 > dirty_y1)
+    dirty_y1 = y1;
+}
+
+// --- Raster Effects ---
+static void raster_line_for(const surface_t *surf, int y, raster_line_t *line) {
+  line->src_y = y;
+  line->scroll_x = 0;
+  line->palette = NULL;
+  raster_effect(y, line, raster_arg);
+
+  int sy = line->src_y % surf->height;
+  int sx = line->scroll_x % surf->width;
+  if (sy < 0)
+    sy += surf->height;
+  if (sx < 0)
+    sx += surf->width;
+  if (surf->format == PIXEL_FORMAT_RGB444)
+    sx &= ~1; // Scroll whole 3-byte pairs
+  line->src_y = sy;
+  line->scroll_x = sx;
+}
+
+static void expand_rgb332_line(uint16_t *dst, const uint8_t *src, int width,
+                               int scroll, const uint16_t *lut) {
+  int head = width - scroll;
+  for (int x = 0; x < head; x++)
+    dst[x] = lut[src[scroll + x]];
+  for (int x = head; x < width; x++)
+    dst[x] = lut[src[x - head]];
+}
+
+// Stream the frame line by line. The next line's parameters (and RGB332
+// expansion) are prepared while the current line is on the wire.
+static void present_raster_task(void *arg) {
+  surface_t *surf = (surface_t *)arg;
+  uint32_t stride = surface_stride(surf);
+  raster_line_t line;
+
+  display_set_window(0, 0, surf->width - 1, surf->height - 1);
+  display_start_bulk();
+  raster_line_for(surf, 0, &line);
+
+  if (surf->format == PIXEL_FORMAT_RGB332) {
+    uint16_t *lines = (uint16_t *)expansion_buffer;
+    expand_rgb332_line(lines, surf->pixels + line.src_y * stride, surf->width,
+                       line.scroll_x,
+                       line.palette ? line.palette : rgb332_to_rgb565);
+
+    for (int y = 0; y < surf->height; y++) {
+      uint16_t *curr = lines + (y % 2) * surf->width;
+      display_wait_ready();
+      display_send_buffer((uint8_t *)curr, surf->width * 2);
+
+      if (y + 1 < surf->height) {
+        raster_line_for(surf, y + 1, &line);
+        expand_rgb332_line(lines + ((y + 1) % 2) * surf->width,
+                           surf->pixels + line.src_y * stride, surf->width,
+                           line.scroll_x,
+                           line.palette ? line.palette : rgb332_to_rgb565);
+      }
+    }
+  } else {
+    // No copy: a scrolled line is two DMAs straight from the source row
+    uint32_t pair_bytes = (surf->format == PIXEL_FORMAT_RGB565) ? 4 : 3;
+
+    for (int y = 0; y < surf->height; y++) {
+      const uint8_t *row = surf->pixels + line.src_y * stride;
+      uint32_t split = (line.scroll_x * pair_bytes) / 2;
+
+      display_wait_ready();
+      display_send_buffer(row + split, stride - split);
+      if (split) {
+        display_wait_ready();
+        display_send_buffer(row, split);
+      }
+
+      if (y + 1 < surf->height)
+        raster_line_for(surf, y + 1, &line);
+    }
+  }
+
+  display_end_bulk();
+  bands_sent = band_count;
+}
+
+// --- Present Queue ---
+static bool queue_active(void) {
+  return buffer_count == 3 && surfaces[0].format != PIXEL_FORMAT_RGB332 &&
+         present_mode == PRESENT_MODE_FULL && !compositor_is_active() &&
+         raster_effect == NULL;
+}
+
+// Start the oldest queued frame if the wire is free. Runs only as the kick
+// IRQ handler, which serializes starts: the completion IRQ and queue_submit
+// pend it rather than re-windowing themselves (the PIO tail drain and RAMWR
+// at the slow clock take a few microseconds, too long for DMA_IRQ_0; the
+// full-frame window is cached, so CASET/PASET are skipped).
+static void queue_pump(void) {
+  uint32_t irq_state = save_and_disable_interrupts();
+  int8_t idx = -1;
+  if (scanout_idx < 0 && present_queue_len > 0) {
+    idx = present_queue[0];
+    present_queue[0] = present_queue[1];
+    present_queue_len--;
+    scanout_idx = idx; // Claimed: no other start until its IRQ retires it
+    buffer_state[idx] = BUF_SCANOUT;
+  }
+  restore_interrupts(irq_state);
+  if (idx < 0)
+    return;
+
+  surface_t *surf = &surfaces[idx];
+  display_end_bulk(); // Drain the PIO tail of the previous frame
+  display_set_window(0, 0, surf->width - 1, surf->height - 1);
+  display_start_bulk();
+  display_send_buffer(surf->pixels, surf->size);
+}
+
+static void present_notify(void) {
+  if (present_cb)
+    present_cb(present_cb_arg);
+}
+
+static void queue_kick(void) { irq_set_pending(queue_kick_irq); }
+
+// Retire the scanout buffer and hand the next start to the kick IRQ, which
+// runs as soon as this handler returns
+static void queue_on_complete(void) {
+  queue_latency_us += time_us_32() - queued_at_us[scanout_idx];
+  queue_latency_samples++;
+  buffer_state[scanout_idx] = BUF_FREE;
+  scanout_idx = -1;
+  if (present_queue_len > 0)
+    queue_kick();
+  present_notify();
+  __sev();
+}
+
+// Transport completion IRQ (every DMA on the pixel channel)
+static void present_on_complete(void *arg) {
+  (void)arg;
+  if (scanout_idx >= 0) {
+    queue_on_complete();
+  } else if (dma_present_pending) {
+    dma_present_pending = false; // Last DMA of a Core 0 present
+    present_notify();
+  }
+}
+
+static void queue_reset(void) {
+  for (int i = 0; i < 3; i++)
+    buffer_state[i] = BUF_FREE;
+  buffer_state[back_buffer_idx] = BUF_DRAWING;
+  scanout_idx = -1;
+  present_queue_len = 0;
+}
+
+static void queue_submit(void) {
+  int8_t idx = back_buffer_idx;
+  queued_at_us[idx] = time_us_32();
+
+  uint32_t irq_state = save_and_disable_interrupts();
+  if (queue_mode == PRESENT_QUEUE_MAILBOX && present_queue_len > 0) {
+    // Replace the stale frame that never reached the wire
+    present_queue_len--;
+    buffer_state[present_queue[present_queue_len]] = BUF_FREE;
+    queue_drops++;
+  }
+  buffer_state[idx] = BUF_QUEUED;
+  present_queue[present_queue_len++] = idx;
+  restore_interrupts(irq_state);
+
+  queue_kick(); // Starts it now if the wire is free
+  if (present_queue_len > queue_max_depth)
+    queue_max_depth = present_queue_len;
+
+  // Acquire the next free buffer; only blocks when FIFO mode is full, and
+  // then sleeps until the completion IRQ retires a buffer
+  uint32_t start = system_idle_begin();
+  int8_t next = -1;
+  while (next < 0) {
+    for (int i = 0; i < 3; i++) {
+      int8_t cand = (idx + 1 + i) % 3;
+      if (buffer_state[cand] == BUF_FREE) {
+        next = cand;
+        break;
+      }
+    }
+    if (next < 0)
+      __wfe();
+  }
+  system_idle_end(start);
+  last_wait_time_us += (time_us_32() - start);
+
+  buffer_state[next] = BUF_DRAWING;
+  back_buffer_idx = next;
+}
+
+static void queue_drain(void) {
+  uint32_t start = system_idle_begin();
+  while (scanout_idx >= 0 || present_queue_len > 0)
+    __wfe(); // Woken by the completion and kick IRQs
+  system_idle_end(start);
+  display_end_bulk();
+  last_wait_time_us += (time_us_32() - start);
+}
+
 void framebuffer_wait_last_swap(void) {
+  if (queue_active()) {
+    queue_drain();
+    return;
+  }
+
   if (swap_active) {
     uint32_t start = time_us_32();
     
     if (swap_active == SWAP_CORE1) {
-        render_service_wait(); // Wait for Core 1 flush task
+        // Only the flush task: a pipelined update may share Core 1
+        render_service_wait_job(core1_present_ticket);
         display_end_bulk();    // Ensure DMA is fully complete
     } else {
         display_end_bulk();    // Standard DMA wait
@@ -344,18 +918,62 @@ void framebuffer_swap_async(void) {
   uint8_t *send_buffer = surf->pixels;
   uint32_t send_size = surf->size;
 
-  if (surf->format == PIXEL_FORMAT_RGB332) {
-    // RGB332: Offload to Core 1
+  if (send_buffer == NULL) {
+    // Direct Mode: send the frame's batched rectangles
+    direct_batch_flush();
+    present_notify(); // Each rectangle ended its own bulk transfer
+    return;
+  }
+
+  // DMA copies into the frame land before it is resolved over or sent (the
+  // compositor also reads its other layers during the present)
+  if (compositor_is_active() ? dma_mem_copy_is_busy()
+                             : dma_mem_copy_in_flight(send_buffer, send_size))
+    dma_mem_copy_wait();
+
+  // Write the frame's recorded opaque primitives (visible spans only)
+  occlusion_resolve();
+
+  if (queue_active()) {
+    // Triple Buffer: queue the frame, keep drawing into a free buffer
+    queue_submit();
+    return;
+  }
+
+  bool row_hash = (present_mode == PRESENT_MODE_ROW_HASH);
+  bool interlaced = (present_mode == PRESENT_MODE_INTERLACED);
+  bool layered = compositor_is_active();
+  bool raster = (raster_effect != NULL);
+  if (present_mode == PRESENT_MODE_SCROLL && !layered && !raster) {
+    // Retained buffer: no flip, the next frame draws on top of this one
+    present_scroll(surf);
+    return;
+  }
+
+  if (surf->format == PIXEL_FORMAT_RGB332 || row_hash || interlaced ||
+      layered || raster) {
+    // RGB332 / Row-Hash / Interlaced / Layers / Raster: Offload to Core 1
     framebuffer_wait_last_swap();
-    
+
+    void (*task)(void *) = flush_rgb332_task;
+    if (layered)
+      task = compositor_present_task;
+    else if (raster)
+      task = present_raster_task;
+    else if (row_hash)
+      task = present_row_hash_task;
+    else if (interlaced)
+      task = present_interlaced_task;
+    core1_present = task;
+
     // Submit FLUSH job
     render_job_t job = {
         .type = RENDER_CMD_CALLBACK,
         .surface = surf, // Pass surface as arg
-        .callback = flush_rgb332_task,
+        .callback = present_core1_task,
         .callback_arg = surf
     };
-    render_service_submit(&job);
+    core1_present_ticket = render_service_submit(&job);
     swap_active = SWAP_CORE1;
 
     // Update Buffer Index immediately (Core 0 is free to draw)
@@ -379,6 +997,7 @@ void framebuffer_swap_async(void) {
     // Now trigger send
     display_set_window(0, 0, surf->width - 1, surf->height - 1);
     display_start_bulk();
+    dma_present_pending = true;
     display_send_buffer(send_buffer, send_size);
     swap_active = SWAP_DMA;
 
@@ -391,22 +1010,96 @@ void framebuffer_swap_async(void) {
     // 2. Start DMA on CURRENT back buffer
     display_set_window(0, 0, surf->width - 1, surf->height - 1);
     display_start_bulk();
+    dma_present_pending = true;
     display_send_buffer(send_buffer, send_size);
     swap_active = SWAP_DMA;
 
     // 3. Flip index
     back_buffer_idx = 1 - back_buffer_idx;
-  } else if (buffer_count == 3) {
-    // Triple Buffer
-    framebuffer_wait_last_swap();
+  }
+  // buffer_count == 3 is handled by the present queue above
+}
 
-    display_set_window(0, 0, surf->width - 1, surf->height - 1);
-    display_start_bulk();
-    display_send_buffer(send_buffer, send_size);
-    swap_active = SWAP_DMA;
+void framebuffer_set_present_mode(present_mode_t mode) {
+  if (surfaces[0].layout != SURFACE_LAYOUT_ROW_MAJOR)
+    mode = PRESENT_MODE_FULL; // Partial presents work on rows
+  framebuffer_wait_last_swap(); // Don't switch under an in-flight present
+  if (present_mode == PRESENT_MODE_SCROLL && scroll_start_dirty) {
+    // Stored rows keep the ring offset: the panel must scroll to match
+    display_set_scroll_start(surfaces[0].row_offset);
+    scroll_start_dirty = false;
+  }
+  present_mode = mode;
+  field_parity = 0;
+  band_crc_valid = false;
+  framebuffer_mark_rows_dirty(0, surfaces[0].height);
+  bands_sent = band_count;
+  queue_reset();
+}
+
+bool framebuffer_set_layout(surface_layout_t layout) {
+  if (buffer_count == 0)
+    return false; // Direct Mode has no surface to lay out
+  if (layout == SURFACE_LAYOUT_COLUMN_MAJOR &&
+      (compositor_is_active() || raster_effect != NULL))
+    return false; // Both stream rows
 
-    back_buffer_idx = (back_buffer_idx + 1) % 3;
+  framebuffer_wait_last_swap();
+  if (!display_set_column_major(layout == SURFACE_LAYOUT_COLUMN_MAJOR))
+    return false;
+
+  for (int i = 0; i < 3; i++) {
+    surfaces[i].layout = layout;
+    surfaces[i].row_offset = 0;
   }
+  if (layout == SURFACE_LAYOUT_COLUMN_MAJOR)
+    framebuffer_set_present_mode(PRESENT_MODE_FULL);
+  framebuffer_invalidate();
+  return true;
+}
+
+void framebuffer_set_raster_effect(raster_effect_t effect, void *arg) {
+  if (surfaces[0].layout != SURFACE_LAYOUT_ROW_MAJOR)
+    return; // Line effects index rows
+  framebuffer_wait_last_swap(); // Core 1 may be calling the old effect
+  raster_effect = effect;
+  raster_arg = arg;
+  band_crc_valid = false;
+  queue_reset();
+}
+
+void framebuffer_set_queue_mode(present_queue_mode_t mode) {
+  queue_mode = mode;
+}
+
+void framebuffer_get_queue_stats(present_queue_stats_t *stats) {
+  stats->max_depth = queue_max_depth;
+  stats->drops = queue_drops;
+  stats->avg_latency_us =
+      queue_latency_samples ? queue_latency_us / queue_latency_samples : 0;
+}
+
+present_mode_t framebuffer_get_present_mode(void) { return present_mode; }
+
+void framebuffer_invalidate(void) {
+  band_crc_valid = false;
+  framebuffer_mark_rows_dirty(0, surfaces[0].height);
+  compositor_mark_hud_dirty(); // Panel lost the strip too
+}
+
+const uint16_t *framebuffer_get_rgb332_lut(void) { return rgb332_to_rgb565; }
+
+uint16_t framebuffer_get_bands_sent(void) {
+  return (present_mode == PRESENT_MODE_ROW_HASH) ? bands_sent : band_count;
+}
+
+uint16_t framebuffer_get_band_count(void) { return band_count; }
+
+void framebuffer_set_present_callback(void (*callback)(void *), void *arg) {
+  framebuffer_wait_last_swap(); // No present may be reading the old pair
+  present_cb = NULL;
+  present_cb_arg = arg;
+  present_cb = callback;
 }
 
 uint32_t framebuffer_get_last_wait_time(void) { return last_wait_time_us; }
@@ -414,4 +1107,11 @@ uint8_t framebuffer_get_buffer_count(void) { return buffer_count; }
 void framebuffer_reset_profile_stats(void) {
   render_service_reset_stats();
   last_wait_time_us = 0;
+
+  uint32_t irq_state = save_and_disable_interrupts();
+  queue_drops = 0;
+  queue_latency_us = 0;
+  queue_latency_samples = 0;
+  queue_max_depth = present_queue_len;
+  restore_interrupts(irq_state);
 }
@@ -7,11 +7,50 @@
 #include "display_driver.h"
 #include "surface.h"
 
-// Initialize framebuffer
+// Present Modes
+typedef enum {
+  PRESENT_MODE_FULL = 0, // Send the whole frame every swap
+  PRESENT_MODE_ROW_HASH, // DMA-sniffer CRC per band, send changed bands only
+  PRESENT_MODE_SCROLL,   // Retained buffer + hardware scroll, dirty rows only
+  PRESENT_MODE_INTERLACED // Odd rows on one present, even rows on the next
+} present_mode_t;
+
+// Triple-buffer present queue policy
+typedef enum {
+  PRESENT_QUEUE_FIFO = 0, // Every frame is shown; Core 0 blocks when full
+  PRESENT_QUEUE_MAILBOX   // Newest frame replaces a queued one (drop)
+} present_queue_mode_t;
+
+typedef struct {
+  uint8_t max_depth;       // Deepest queue seen since the last reset
+  uint32_t drops;          // Mailbox replacements since the last reset
+  uint32_t avg_latency_us; // Submit -> scanout complete
+} present_queue_stats_t;
+
+// Per-scanline raster effect (HDMA-style). Called on Core 1 for every output
+// line y while the previous line is on the wire; fields arrive as defaults
+// (src_y = y, scroll_x = 0, palette = NULL) and may be changed.
+typedef struct {
+  int16_t src_y;           // Framebuffer row shown on line y (wraps)
+  int16_t scroll_x;        // Horizontal offset, wraps (RGB444: 2-px steps)
+  const uint16_t *palette; // RGB332 only: 256 RGB565 entries
+} raster_line_t;
+
+typedef void (*raster_effect_t)(int y, raster_line_t *line, void *arg);
+
+// Rows per change-detection band in PRESENT_MODE_ROW_HASH
+#define PRESENT_BAND_ROWS 8
+
 // Initialize framebuffer (buffer_count: 1=Single, 2=Double, 3=Triple)
+// Buffers come from the engine arena, which must be initialized first
 bool framebuffer_init(uint16_t width, uint16_t height,
                       display_pixel_format_t format, uint8_t buffer_count);
 
+// Arena bytes framebuffer_init() will consume for this configuration
+uint32_t framebuffer_get_arena_size(uint16_t width, uint16_t height,
+                                    display_pixel_format_t format,
+                                    uint8_t buffer_count);
+
 // Get the active drawing surface
 surface_t *framebuffer_get_surface(void);
 
@@ -20,6 +59,19 @@ void draw_clear(surface_t *surf, uint16_t color);
 void draw_pixel(surface_t *surf, int x, int y, uint16_t color);
 void draw_rect(surface_t *surf, int x, int y, int w, int h, uint16_t color);
 void draw_circle(surface_t *surf, int cx, int cy, int radius, uint16_t color);
+// Vertical span; contiguous writes on column-major surfaces
+void draw_vline(surface_t *surf, int x, int y, int h, uint16_t color);
+
+// Copy a rectangle between surfaces of the same format with the 2D DMA
+// engine (dma_mem_copy_rect); `done` runs from the DMA IRQ. Both regions are
+// in flight until then: framebuffer_swap_async and the occlusion resolve
+// wait for a copy touching their surface, other drawing must not touch it.
+// RGB444 needs even x and width. Returns false if the copy cannot be done by
+// DMA (nothing is copied), including rectangles that cross a scrolled
+// surface's ring seam.
+bool draw_copy_rect_async(surface_t *dst, int dx, int dy, const surface_t *src,
+                          int sx, int sy, int w, int h, void (*done)(void *),
+                          void *arg);
 
 // High-level framebuffer operations
 void framebuffer_clear(uint16_t color);
@@ -27,9 +79,47 @@ void framebuffer_fill_circle(int cx, int cy, int radius, uint16_t color);
 void framebuffer_swap_async(void);
 void framebuffer_wait_last_swap(void);
 
+// Present mode (default FULL). ROW_HASH runs the present on Core 1.
+void framebuffer_set_present_mode(present_mode_t mode);
+present_mode_t framebuffer_get_present_mode(void);
+// Queue policy for buffer_count == 3 (RGB565/RGB444, PRESENT_MODE_FULL)
+void framebuffer_set_queue_mode(present_queue_mode_t mode);
+// Hardware scrolling (portrait panels). Moves the content up by `rows`
+// (negative: down) by rotating the surfaces' ring offset; the exposed rows
+// still hold old pixels and must be redrawn. The next present sends only the
+// exposed and marked rows, then the scroll start. Returns false outside
+// PRESENT_MODE_SCROLL, in Direct Mode, landscape, or with layers / raster
+// effects.
+bool framebuffer_scroll(int rows);
+// PRESENT_MODE_SCROLL: rows [y0, y1) were drawn and must be sent
+void framebuffer_mark_rows_dirty(int y0, int y1);
+
+// Surface memory layout (default row-major). Column-major switches the
+// panel's scan direction to match and supports full presents only (no
+// row-hash, scroll, interlaced, raster effects or compositor layers).
+bool framebuffer_set_layout(surface_layout_t layout);
+
+// Install a raster effect (NULL removes it). While set, every present
+// streams line by line on Core 1 (replaces row-hash and the present queue).
+void framebuffer_set_raster_effect(raster_effect_t effect, void *arg);
+// Forget the panel's band CRCs and retained HUD (call after drawing to the
+// panel directly)
+void framebuffer_invalidate(void);
+
+// RGB332 -> RGB565 expansion table, valid after init
+const uint16_t *framebuffer_get_rgb332_lut(void);
+
+// Called once per present when its last pixel has left memory: from the
+// transport IRQ for DMA presents, on Core 1 for offloaded ones, inline in
+// Direct Mode. Keep it short; NULL disables.
+void framebuffer_set_present_callback(void (*callback)(void *), void *arg);
+
 // Performance & Profiling
 uint32_t framebuffer_get_last_wait_time(void);
 uint8_t framebuffer_get_buffer_count(void);
 void framebuffer_reset_profile_stats(void);
+uint16_t framebuffer_get_bands_sent(void); // Bands sent by the last present
+uint16_t framebuffer_get_band_count(void);
+void framebuffer_get_queue_stats(present_queue_stats_t *stats);
 
 #endif
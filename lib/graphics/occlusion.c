@@ -0,0 +1,236 @@
+#include "occlusion.h"
+#include "arena.h"
+#include "dma_mem.h"
+#include "span.h"
+#include <string.h>
+
+typedef enum { PRIM_RECT = 0, PRIM_CIRCLE } prim_type_t;
+
+typedef struct {
+  uint8_t type;
+  uint16_t color;
+  int16_t x, y; // Rect origin or circle centre
+  int16_t w, h; // Rect size, or w = radius
+} prim_t;
+
+static prim_t *prims = NULL;
+static uint16_t capacity = 0;
+static uint16_t count = 0;
+static surface_t *target = NULL;
+
+// 1 bit per pixel, row-major, `row_words` words per scanline
+static uint32_t *coverage = NULL;
+static uint32_t *pixel_mask = NULL; // Immediate draw_pixel writes
+static uint16_t row_words = 0;
+static uint16_t rows = 0;
+static int pixel_epoch = -1; // Primitives [0, epoch) lie under pixel_mask
+
+static uint32_t submitted_px = 0;
+static uint32_t written_px = 0;
+static uint32_t last_submitted_px = 0;
+static uint32_t last_written_px = 0;
+
+static uint32_t bitmap_bytes(uint16_t width, uint16_t height) {
+  return ((width + 31) / 32) * 4 * height;
+}
+
+uint32_t occlusion_get_arena_size(uint16_t width, uint16_t height,
+                                  uint16_t cap) {
+  return arena_reserve_size(cap * sizeof(prim_t), 4) +
+         2 * arena_reserve_size(bitmap_bytes(width, height), 4);
+}
+
+bool occlusion_init(uint16_t width, uint16_t height, uint16_t cap) {
+  prims = (prim_t *)arena_alloc(ARENA_TAG_PRESENT, cap * sizeof(prim_t), 4);
+  coverage = (uint32_t *)arena_alloc(ARENA_TAG_PRESENT,
+                                     bitmap_bytes(width, height), 4);
+  pixel_mask = (uint32_t *)arena_alloc(ARENA_TAG_PRESENT,
+                                       bitmap_bytes(width, height), 4);
+  if (!prims || !coverage || !pixel_mask)
+    return false;
+
+  capacity = cap;
+  row_words = (width + 31) / 32;
+  rows = height;
+  count = 0;
+  pixel_epoch = -1;
+  memset(pixel_mask, 0, bitmap_bytes(width, height));
+  return true;
+}
+
+bool occlusion_is_enabled(void) { return prims != NULL; }
+
+static bool begin_record(surface_t *surf) {
+  if (prims == NULL || surf->pixels == NULL)
+    return false;
+  if (target != surf || count == capacity)
+    occlusion_resolve();
+  target = surf;
+  return true;
+}
+
+static void push(prim_type_t type, int x, int y, int w, int h,
+                 uint16_t color) {
+  prim_t *p = &prims[count++];
+  p->type = type;
+  p->color = color;
+  p->x = x;
+  p->y = y;
+  p->w = w;
+  p->h = h;
+}
+
+bool occlusion_record_clear(surface_t *surf, uint16_t color) {
+  if (!begin_record(surf))
+    return false;
+
+  // Everything recorded so far, and any noted pixels, is overwritten
+  if (pixel_epoch >= 0)
+    memset(pixel_mask, 0, row_words * 4 * rows);
+  pixel_epoch = -1;
+  count = 0;
+
+  push(PRIM_RECT, 0, 0, surf->width, surf->height, color);
+  return true;
+}
+
+bool occlusion_record_rect(surface_t *surf, int x, int y, int w, int h,
+                           uint16_t color) {
+  if (!begin_record(surf))
+    return false;
+  push(PRIM_RECT, x, y, w, h, color);
+  return true;
+}
+
+bool occlusion_record_circle(surface_t *surf, int cx, int cy, int radius,
+                             uint16_t color) {
+  if (!begin_record(surf))
+    return false;
+  push(PRIM_CIRCLE, cx, cy, radius, 0, color);
+  return true;
+}
+
+void occlusion_note_pixel(surface_t *surf, int x, int y) {
+  if (prims == NULL || count == 0 || surf != target)
+    return;
+
+  if (pixel_epoch >= 0 && pixel_epoch != count) {
+    // A second pixel layer would need its own mask: resolve instead
+    occlusion_resolve();
+    return;
+  }
+
+  pixel_epoch = count;
+  pixel_mask[y * row_words + (x >> 5)] |= 1u << (x & 31);
+}
+
+// Write the parts of [x, x + w) on row y not covered by a later primitive
+static void resolve_span(int x, int y, int w, uint16_t color) {
+  if (y < 0 || y >= target->height)
+    return;
+  if (x < 0) {
+    w += x;
+    x = 0;
+  }
+  if (x + w > target->width)
+    w = target->width - x;
+  if (w <= 0)
+    return;
+
+  submitted_px += w;
+  uint32_t *row = coverage + y * row_words;
+  int run_start = -1;
+  int run_end = -1;
+  int end = x + w;
+
+  while (x < end) {
+    int wi = x >> 5;
+    int bit = x & 31;
+    int n = (end - x < 32 - bit) ? end - x : 32 - bit;
+    uint32_t mask = (n == 32) ? 0xFFFFFFFFu : (((1u << n) - 1) << bit);
+    uint32_t visible = mask & ~row[wi];
+    row[wi] |= mask;
+    written_px += __builtin_popcount(visible);
+
+    while (visible) {
+      int s = __builtin_ctz(visible);
+      uint32_t rest = visible >> s;
+      int len = (rest == 0xFFFFFFFFu) ? 32 : __builtin_ctz(~rest);
+      int px = (wi << 5) + s;
+
+      if (px == run_end) {
+        run_end += len; // Continues across the word boundary
+      } else {
+        if (run_start >= 0)
+          span_fill(target, run_start, y, run_end - run_start, color);
+        run_start = px;
+        run_end = px + len;
+      }
+      visible &= (len == 32) ? 0 : ~(((1u << len) - 1) << s);
+    }
+    x += n;
+  }
+
+  if (run_start >= 0)
+    span_fill(target, run_start, y, run_end - run_start, color);
+}
+
+static void resolve_prim(const prim_t *p) {
+  if (p->type == PRIM_RECT) {
+    for (int row = 0; row < p->h; row++)
+      resolve_span(p->x, p->y + row, p->w, p->color);
+    return;
+  }
+
+  // Same midpoint walk as draw_circle
+  int cx = p->x, cy = p->y;
+  int x = p->w;
+  int y = 0;
+  int err = 0;
+  while (x >= y) {
+    resolve_span(cx - x, cy + y, 2 * x + 1, p->color);
+    resolve_span(cx - x, cy - y, 2 * x + 1, p->color);
+    resolve_span(cx - y, cy + x, 2 * y + 1, p->color);
+    resolve_span(cx - y, cy - x, 2 * y + 1, p->color);
+    y++;
+    err += 1 + 2 * y;
+    if (2 * (err - x) + 1 > 0) {
+      x--;
+      err += 1 - 2 * x;
+    }
+  }
+}
+
+void occlusion_resolve(void) {
+  if (count == 0 || target == NULL)
+    return;
+
+  // A DMA copy into the target lands before the spans go over it
+  if (dma_mem_copy_in_flight(target->pixels, target->size))
+    dma_mem_copy_wait();
+
+  uint32_t words = row_words * rows;
+  memset(coverage, 0, words * 4);
+  submitted_px = 0;
+  written_px = 0;
+
+  // Back to front: the topmost primitive claims each pixel first
+  for (int i = count - 1; i >= 0; i--) {
+    if (i == pixel_epoch - 1) {
+      for (uint32_t k = 0; k < words; k++)
+        coverage[k] |= pixel_mask[k];
+      memset(pixel_mask, 0, words * 4);
+    }
+    resolve_prim(&prims[i]);
+  }
+
+  last_submitted_px = submitted_px;
+  last_written_px = written_px;
+  count = 0;
+  pixel_epoch = -1;
+}
+
+void occlusion_get_stats(uint32_t *out_submitted, uint32_t *out_written) {
+  *out_submitted = last_submitted_px;
+  *out_written = last_written_px;
+}
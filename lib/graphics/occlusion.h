@@ -0,0 +1,44 @@
+#ifndef OCCLUSION_H
+#define OCCLUSION_H
+
+#include "surface.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Overdraw Elimination
+ * Opaque primitives (clear, rect, circle) are recorded for the frame instead
+ * of being written immediately. At present they are resolved back to front
+ * against a per-scanline coverage bitmap, so each pixel is filled once by
+ * the topmost primitive and covered parts of a clear are never written.
+ *
+ * draw_pixel stays immediate; its pixels occlude the primitives recorded
+ * before it. Primitives are resolved early when pixels and primitives
+ * interleave more than once, or when the list is full.
+ */
+
+#define OCCLUSION_CAPACITY 256
+
+uint32_t occlusion_get_arena_size(uint16_t width, uint16_t height,
+                                  uint16_t capacity);
+bool occlusion_init(uint16_t width, uint16_t height, uint16_t capacity);
+bool occlusion_is_enabled(void);
+
+// Record a primitive (pre-clipped rect). Return false when not recording,
+// in which case the caller draws immediately.
+bool occlusion_record_clear(surface_t *surf, uint16_t color);
+bool occlusion_record_rect(surface_t *surf, int x, int y, int w, int h,
+                           uint16_t color);
+bool occlusion_record_circle(surface_t *surf, int cx, int cy, int radius,
+                             uint16_t color);
+
+// Call before an immediate pixel write to `surf`
+void occlusion_note_pixel(surface_t *surf, int x, int y);
+
+// Write every recorded primitive (visible spans only)
+void occlusion_resolve(void);
+
+// Pixels submitted by primitives vs. actually written, last resolve
+void occlusion_get_stats(uint32_t *submitted_px, uint32_t *written_px);
+
+#endif
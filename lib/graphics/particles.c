@@ -0,0 +1,277 @@
+#include "particles.h"
+#include "arena.h"
+#include "framebuffer.h"
+#include "occlusion.h"
+#include "pico/stdlib.h"
+#include "render_service.h"
+#include <string.h>
+
+// Arrays: x, y, vx, vy (4 bytes) + life, color, order (2 bytes)
+#define PARTICLE_FX_ARRAYS 4
+#define PARTICLE_U16_ARRAYS 3
+
+uint32_t particles_get_arena_size(uint16_t capacity) {
+  return PARTICLE_FX_ARRAYS * arena_reserve_size(capacity * 4, 4) +
+         PARTICLE_U16_ARRAYS * arena_reserve_size(capacity * 2, 4);
+}
+
+bool particles_init(particle_system_t *ps, uint16_t capacity) {
+  memset(ps, 0, sizeof(*ps));
+  fx16_t **fx[PARTICLE_FX_ARRAYS] = {&ps->x, &ps->y, &ps->vx, &ps->vy};
+  uint16_t **u16[PARTICLE_U16_ARRAYS] = {&ps->life, &ps->color, &ps->order};
+
+  for (int i = 0; i < PARTICLE_FX_ARRAYS; i++) {
+    *fx[i] = (fx16_t *)arena_alloc(ARENA_TAG_APP, capacity * 4, 4);
+    if (!*fx[i])
+      return false;
+  }
+  for (int i = 0; i < PARTICLE_U16_ARRAYS; i++) {
+    *u16[i] = (uint16_t *)arena_alloc(ARENA_TAG_APP, capacity * 2, 4);
+    if (!*u16[i])
+      return false;
+  }
+
+  ps->capacity = capacity;
+  ps->rng = 0x9E3779B9u;
+  return true;
+}
+
+void particles_clear(particle_system_t *ps) { ps->count = 0; }
+
+// --- Emit ---
+static inline uint32_t next_rand(particle_system_t *ps) {
+  uint32_t s = ps->rng; // xorshift32
+  s ^= s << 13;
+  s ^= s >> 17;
+  s ^= s << 5;
+  ps->rng = s;
+  return s;
+}
+
+uint32_t particles_emit(particle_system_t *ps, const particle_emitter_t *em,
+                        uint32_t count) {
+  uint32_t room = ps->capacity - ps->count;
+  if (count > room)
+    count = room;
+
+  uint32_t life_range = (uint32_t)(em->life_max - em->life_min) + 1;
+  for (uint32_t n = 0; n < count; n++) {
+    uint32_t i = ps->count++;
+    uint32_t r0 = next_rand(ps), r1 = next_rand(ps);
+
+    // 16-bit random fractions: r & 0xFFFF is 0..1 in 16.16
+    fx_angle_t angle = (fx_angle_t)(em->angle - (em->spread >> 1) +
+                                    (((r0 & 0xFFFF) * em->spread) >> 16));
+    fx16_t speed = em->speed_min +
+                   fx16_mul(em->speed_max - em->speed_min, r0 >> 16);
+    ps->vx[i] = fx16_mul(fx_cos(angle), speed);
+    ps->vy[i] = fx16_mul(fx_sin(angle), speed);
+
+    fx16_t jx = (fx16_t)(r1 & 0xFFFF) * 2 - FX16_ONE; // -1..1
+    fx16_t jy = (fx16_t)(r1 >> 16) * 2 - FX16_ONE;
+    ps->x[i] = em->x + fx16_mul(em->jitter, jx);
+    ps->y[i] = em->y + fx16_mul(em->jitter, jy);
+
+    ps->life[i] = em->life_min + (uint16_t)(next_rand(ps) % life_range);
+    if (ps->life[i] == 0)
+      ps->life[i] = 1;
+    ps->color[i] = em->color;
+  }
+  return count;
+}
+
+// --- Update ---
+// One field (or field pair) per loop
+static void update_range(particle_system_t *ps, uint32_t start,
+                         uint32_t end) {
+  fx16_t *vx = ps->vx, *vy = ps->vy;
+  fx16_t gx = ps->gravity_x, gy = ps->gravity_y;
+
+  if (gx || gy) {
+    for (uint32_t i = start; i < end; i++) {
+      vx[i] += gx;
+      vy[i] += gy;
+    }
+  }
+  if (ps->drag_shift) {
+    int shift = ps->drag_shift;
+    for (uint32_t i = start; i < end; i++) {
+      vx[i] -= vx[i] >> shift;
+      vy[i] -= vy[i] >> shift;
+    }
+  }
+
+  fx16_t *x = ps->x;
+  for (uint32_t i = start; i < end; i++)
+    x[i] += vx[i];
+  fx16_t *y = ps->y;
+  for (uint32_t i = start; i < end; i++)
+    y[i] += vy[i];
+
+  uint16_t *life = ps->life;
+  for (uint32_t i = start; i < end; i++)
+    life[i]--;
+}
+
+typedef struct {
+  particle_system_t *ps;
+  surface_t *surf;
+  uint32_t start;
+  uint32_t end;
+} particle_job_t;
+
+// Core 1 half of a split loop (Core 0 waits for it before returning)
+static particle_job_t core1_job;
+
+static void core1_update_task(void *arg) {
+  particle_job_t *job = (particle_job_t *)arg;
+  update_range(job->ps, job->start, job->end);
+}
+
+static uint32_t submit_core1(void (*task)(void *), particle_system_t *ps,
+                             surface_t *surf, uint32_t start, uint32_t end) {
+  core1_job = (particle_job_t){ps, surf, start, end};
+  render_job_t job = {.type = RENDER_CMD_CALLBACK,
+                      .callback = task,
+                      .callback_arg = &core1_job};
+  return render_service_submit(&job);
+}
+
+// Swap-remove particles whose life ran out
+static void compact(particle_system_t *ps) {
+  uint32_t n = ps->count;
+  uint16_t *life = ps->life;
+  for (uint32_t i = 0; i < n;) {
+    if (life[i] != 0) {
+      i++;
+      continue;
+    }
+    n--;
+    ps->x[i] = ps->x[n];
+    ps->y[i] = ps->y[n];
+    ps->vx[i] = ps->vx[n];
+    ps->vy[i] = ps->vy[n];
+    life[i] = life[n];
+    ps->color[i] = ps->color[n];
+  }
+  ps->count = (uint16_t)n;
+}
+
+void particles_update(particle_system_t *ps) {
+  uint32_t count = ps->count;
+  if (count >= PARTICLE_PARALLEL_MIN && get_core_num() == 0 &&
+      render_service_core1_free()) {
+    uint32_t half = count / 2;
+    uint32_t ticket = submit_core1(core1_update_task, ps, NULL, 0, half);
+    update_range(ps, half, count);
+    render_service_wait_job(ticket);
+  } else {
+    update_range(ps, 0, count);
+  }
+  compact(ps);
+}
+
+// --- Draw ---
+static void plot_range(const particle_system_t *ps, surface_t *surf,
+                       uint32_t start, uint32_t end) {
+  const uint16_t *order = ps->order;
+
+  if (surf->format == PIXEL_FORMAT_RGB565) {
+    uint16_t *pixels = (uint16_t *)surf->pixels;
+    for (uint32_t k = start; k < end; k++) {
+      uint32_t i = order[k];
+      pixels[surface_index(surf, ps->x[i] >> 16, ps->y[i] >> 16)] =
+          ps->color[i];
+    }
+  } else if (surf->format == PIXEL_FORMAT_RGB444) {
+    uint8_t *pixels = surf->pixels;
+    for (uint32_t k = start; k < end; k++) {
+      uint32_t i = order[k];
+      uint32_t idx = surface_index(surf, ps->x[i] >> 16, ps->y[i] >> 16);
+      uint16_t c = ps->color[i];
+      uint8_t r4 = c >> 12, g4 = (c >> 7) & 0x0F, b4 = (c >> 1) & 0x0F;
+      uint8_t *p = pixels + (idx >> 1) * 3;
+      if ((idx & 1) == 0) {
+        p[0] = (r4 << 4) | g4;
+        p[1] = (b4 << 4) | (p[1] & 0x0F);
+      } else {
+        p[1] = (p[1] & 0xF0) | r4;
+        p[2] = (g4 << 4) | b4;
+      }
+    }
+  } else { // RGB332
+    uint8_t *pixels = surf->pixels;
+    for (uint32_t k = start; k < end; k++) {
+      uint32_t i = order[k];
+      uint16_t c = ps->color[i];
+      pixels[surface_index(surf, ps->x[i] >> 16, ps->y[i] >> 16)] =
+          ((c >> 8) & 0xE0) | ((c >> 6) & 0x1C) | ((c >> 3) & 0x03);
+    }
+  }
+}
+
+static void core1_plot_task(void *arg) {
+  particle_job_t *job = (particle_job_t *)arg;
+  plot_range(job->ps, job->surf, job->start, job->end);
+}
+
+void particles_draw(particle_system_t *ps, surface_t *surf) {
+  uint32_t count = ps->count;
+  int w = surf->width, h = surf->height;
+
+  if (surf->pixels == NULL) {
+    // Direct Mode (batched until present)
+    for (uint32_t i = 0; i < count; i++)
+      draw_pixel(surf, ps->x[i] >> 16, ps->y[i] >> 16, ps->color[i]);
+    return;
+  }
+
+  occlusion_resolve(); // Plotted pixels go over earlier recorded primitives
+
+  // Bands run along the stored lines: rows, or columns when column-major
+  bool columns = surf->layout == SURFACE_LAYOUT_COLUMN_MAJOR;
+  int lines = columns ? w : h;
+  int shift = 0;
+  while ((lines >> shift) >= PARTICLE_MAX_BANDS)
+    shift++;
+  int bands = (lines >> shift) + 1;
+
+  // Counting sort of the visible particles by band
+  uint16_t *start = ps->band_start;
+  memset(start, 0, sizeof(ps->band_start));
+  for (uint32_t i = 0; i < count; i++) {
+    int px = ps->x[i] >> 16, py = ps->y[i] >> 16;
+    if ((unsigned)px < (unsigned)w && (unsigned)py < (unsigned)h)
+      start[((columns ? px : py) >> shift) + 1]++;
+  }
+  for (int b = 1; b <= bands; b++)
+    start[b] += start[b - 1];
+  uint32_t visible = start[bands];
+
+  // Scatter (start[b] becomes the end of band b)
+  for (uint32_t i = 0; i < count; i++) {
+    int px = ps->x[i] >> 16, py = ps->y[i] >> 16;
+    if ((unsigned)px < (unsigned)w && (unsigned)py < (unsigned)h)
+      ps->order[start[(columns ? px : py) >> shift]++] = (uint16_t)i;
+  }
+  ps->drawn = (uint16_t)visible;
+
+  // RGB444 pairs straddle lines when a line has an odd pixel count
+  bool odd_pairs =
+      surf->format == PIXEL_FORMAT_RGB444 && ((columns ? h : w) & 1);
+  bool split = visible >= PARTICLE_PARALLEL_MIN && get_core_num() == 0 &&
+               !odd_pairs && render_service_core1_free();
+  if (!split) {
+    plot_range(ps, surf, 0, visible);
+    return;
+  }
+
+  // Core 1 takes whole bands up to about half the particles
+  int b = 0;
+  while (b < bands - 1 && start[b] < visible / 2)
+    b++;
+  uint32_t mid = start[b];
+  uint32_t ticket = submit_core1(core1_plot_task, ps, surf, 0, mid);
+  plot_range(ps, surf, mid, visible);
+  render_service_wait_job(ticket);
+}
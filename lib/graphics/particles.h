@@ -0,0 +1,79 @@
+#ifndef PARTICLES_H
+#define PARTICLES_H
+
+#include "fixed.h"
+#include "surface.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Particle System
+ * Structure-of-arrays storage: each field is its own 16.16 (or 16-bit)
+ * array, so the update is a few tight loops over one or two arrays instead
+ * of a walk over structs (the M0+ has eight low registers). Large systems
+ * split the update between the cores through the render service.
+ *
+ * Drawing bins the visible particles by band of lines (a counting sort into
+ * `order`), then plots them straight into the packed surface: one halfword,
+ * byte or nibble-pair store each. The bands are split between the cores so
+ * the two never touch the same line. Direct Mode surfaces go through
+ * draw_pixel batching instead.
+ *
+ * Velocities and gravity are per frame; a particle dies when its life
+ * (frames) runs out, and dead particles are swap-removed.
+ */
+
+// Lines per band is the smallest power of two giving at most this many
+#define PARTICLE_MAX_BANDS 40
+// Below this many particles, one core does the update (job overhead)
+#define PARTICLE_PARALLEL_MIN 256
+
+typedef struct {
+  uint16_t capacity;
+  uint16_t count; // Live particles, indices 0..count-1
+  fx16_t *x;
+  fx16_t *y;
+  fx16_t *vx;
+  fx16_t *vy;
+  uint16_t *life;  // Frames left
+  uint16_t *color; // RGB565
+  uint16_t *order; // Draw: visible indices sorted by band
+  uint16_t band_start[PARTICLE_MAX_BANDS + 1];
+  fx16_t gravity_x; // Added to every velocity each frame
+  fx16_t gravity_y;
+  uint8_t drag_shift; // v -= v >> drag_shift each frame (0 = no drag)
+  uint32_t rng;
+  uint16_t drawn; // Visible particles in the last draw
+} particle_system_t;
+
+// Spawn description for particles_emit
+typedef struct {
+  fx16_t x, y;           // Spawn point
+  fx16_t jitter;         // Spawn position varies by +-jitter on each axis
+  fx_angle_t angle;      // Launch direction
+  fx_angle_t spread;     // Launch cone width (0xFFFF = every direction)
+  fx16_t speed_min;      // Pixels per frame
+  fx16_t speed_max;
+  uint16_t life_min;     // Frames
+  uint16_t life_max;
+  uint16_t color;        // RGB565
+} particle_emitter_t;
+
+// Arena bytes (ARENA_TAG_APP) particles_init() takes
+uint32_t particles_get_arena_size(uint16_t capacity);
+
+bool particles_init(particle_system_t *ps, uint16_t capacity);
+void particles_clear(particle_system_t *ps);
+
+// Spawn up to `count` particles; returns how many fit
+uint32_t particles_emit(particle_system_t *ps, const particle_emitter_t *em,
+                        uint32_t count);
+
+// Advance one frame and drop dead particles. Call from Core 0 to use both
+// cores (Core 1 callers run it alone).
+void particles_update(particle_system_t *ps);
+
+// Plot every live particle as one pixel
+void particles_draw(particle_system_t *ps, surface_t *surf);
+
+#endif
@@ -0,0 +1,430 @@
+#include "render3d.h"
+#include "arena.h"
+#include "occlusion.h"
+#include "pico/stdlib.h"
+#include "render_service.h"
+#include "span.h"
+#include <string.h>
+
+// Screen coordinates are clamped to this many pixels around the surface so
+// edge and area maths stay within 32/64 bits (no x/y clipping)
+#define R3D_GUARD_PX 2048
+
+struct r3d_tri {
+  fx16_t x[3], y[3];  // Screen position (pixel centres at +0.5)
+  uint8_t rgb[3][3];  // Lit colour per vertex, 8 bits per channel
+  uint8_t gouraud;    // 0: flat, rgb[0] only
+  uint16_t key;       // Depth, larger is farther
+};
+
+struct r3d_vertex {
+  vec3_t view;
+  fx16_t sx, sy;
+  fx16_t light; // 0..FX16_ONE
+};
+
+uint32_t r3d_get_arena_size(uint16_t max_tris, uint16_t max_vertices) {
+  return arena_reserve_size(max_tris * sizeof(r3d_tri_t), 4) +
+         2 * arena_reserve_size(max_tris * 2, 4) +
+         arena_reserve_size(max_vertices * sizeof(r3d_vertex_t), 4);
+}
+
+bool r3d_init(r3d_t *r, uint16_t max_tris, uint16_t max_vertices) {
+  memset(r, 0, sizeof(*r));
+  r->tris = (r3d_tri_t *)arena_alloc(ARENA_TAG_APP,
+                                     max_tris * sizeof(r3d_tri_t), 4);
+  r->order = (uint16_t *)arena_alloc(ARENA_TAG_APP, max_tris * 2, 4);
+  r->order_tmp = (uint16_t *)arena_alloc(ARENA_TAG_APP, max_tris * 2, 4);
+  r->verts = (r3d_vertex_t *)arena_alloc(
+      ARENA_TAG_APP, max_vertices * sizeof(r3d_vertex_t), 4);
+  if (!r->tris || !r->order || !r->order_tmp || !r->verts)
+    return false;
+
+  r->max_tris = max_tris;
+  r->max_vertices = max_vertices;
+  r->view = mat4_identity();
+  r->near = FX16_CONST(0.1);
+  r->light_dir =
+      vec3_normalize(vec3(FX16_CONST(-0.4), FX16_CONST(0.6), FX16_CONST(-0.7)));
+  r->ambient = FX16_CONST(0.25);
+  r->cull_backfaces = true;
+  return true;
+}
+
+void r3d_set_fov(r3d_t *r, fx_angle_t fov, uint16_t width) {
+  // focal = (width / 2) / tan(fov / 2)
+  fx_angle_t half = fov >> 1;
+  r->focal = fx16_div(fx16_mul(fx16_from_int(width / 2), fx_cos(half)),
+                      fx_sin(half));
+}
+
+void r3d_begin(r3d_t *r, surface_t *surf) {
+  r->surf = surf;
+  r->tri_count = 0;
+  memset(&r->stats, 0, sizeof(r->stats));
+  if (r->focal == 0)
+    r->focal = fx16_from_int(surf->width / 2);
+}
+
+// --- Vertex Stage ---
+static inline fx16_t clamp_guard(fx16_t v, int size) {
+  return fx16_clamp(v, fx16_from_int(-R3D_GUARD_PX),
+                    fx16_from_int(size + R3D_GUARD_PX));
+}
+
+static void project(const r3d_t *r, r3d_vertex_t *v) {
+  fx16_t inv_z = fx16_recip(v->view.z);
+  fx16_t sx = fx16_mul_sat(fx16_mul(v->view.x, r->focal), inv_z);
+  fx16_t sy = fx16_mul_sat(fx16_mul(v->view.y, r->focal), inv_z);
+  v->sx = clamp_guard(fx16_from_int(r->surf->width / 2) + sx,
+                      r->surf->width);
+  v->sy = clamp_guard(fx16_from_int(r->surf->height / 2) - sy,
+                      r->surf->height);
+}
+
+static inline fx16_t light_for(const r3d_t *r, vec3_t normal) {
+  fx16_t d = vec3_dot(normal, r->light_dir);
+  if (d < 0)
+    d = 0;
+  return r->ambient + fx16_mul(FX16_ONE - r->ambient, d);
+}
+
+static inline void lit_rgb(uint8_t out[3], uint16_t c565, fx16_t light) {
+  uint32_t r5 = c565 >> 11, g6 = (c565 >> 5) & 0x3F, b5 = c565 & 0x1F;
+  out[0] = (uint8_t)((((r5 << 3) | (r5 >> 2)) * (uint32_t)light) >> 16);
+  out[1] = (uint8_t)((((g6 << 2) | (g6 >> 4)) * (uint32_t)light) >> 16);
+  out[2] = (uint8_t)((((b5 << 3) | (b5 >> 2)) * (uint32_t)light) >> 16);
+}
+
+// Cull and queue one projected triangle
+static void emit(r3d_t *r, const r3d_vertex_t *v[3], uint16_t c565,
+                 bool gouraud) {
+  // Signed area in 28.4; front faces are clockwise on screen (y down)
+  int32_t x0 = v[0]->sx >> 12, y0 = v[0]->sy >> 12;
+  int64_t area = (int64_t)((v[1]->sx >> 12) - x0) * ((v[2]->sy >> 12) - y0) -
+                 (int64_t)((v[2]->sx >> 12) - x0) * ((v[1]->sy >> 12) - y0);
+  if (area == 0 || (r->cull_backfaces && area > 0)) {
+    r->stats.tris_culled++;
+    return;
+  }
+
+  fx16_t min_x = fx16_min(v[0]->sx, fx16_min(v[1]->sx, v[2]->sx));
+  fx16_t max_x = fx16_max(v[0]->sx, fx16_max(v[1]->sx, v[2]->sx));
+  fx16_t min_y = fx16_min(v[0]->sy, fx16_min(v[1]->sy, v[2]->sy));
+  fx16_t max_y = fx16_max(v[0]->sy, fx16_max(v[1]->sy, v[2]->sy));
+  if (max_x < 0 || max_y < 0 || min_x >= fx16_from_int(r->surf->width) ||
+      min_y >= fx16_from_int(r->surf->height)) {
+    r->stats.tris_culled++;
+    return;
+  }
+
+  if (r->tri_count == r->max_tris)
+    return;
+  r3d_tri_t *t = &r->tris[r->tri_count++];
+  r->stats.tris_drawn++;
+
+  fx16_t flat_light = 0;
+  if (!gouraud) {
+    // Geometric normal towards the camera (left-handed view space)
+    vec3_t e1 = vec3_sub(v[1]->view, v[0]->view);
+    vec3_t e2 = vec3_sub(v[2]->view, v[0]->view);
+    flat_light = light_for(r, vec3_normalize(vec3_cross(e2, e1)));
+  }
+  for (int i = 0; i < 3; i++) {
+    t->x[i] = v[i]->sx;
+    t->y[i] = v[i]->sy;
+    lit_rgb(t->rgb[i], c565, gouraud ? v[i]->light : flat_light);
+  }
+  t->gouraud = gouraud;
+
+  uint32_t z = (uint32_t)(v[0]->view.z + v[1]->view.z + v[2]->view.z) >> 9;
+  t->key = z > 0xFFFF ? 0xFFFF : (uint16_t)z;
+}
+
+// Point on a -> b where z reaches the near plane
+static r3d_vertex_t near_point(const r3d_t *r, const r3d_vertex_t *a,
+                               const r3d_vertex_t *b) {
+  fx16_t t = fx16_div(r->near - a->view.z, b->view.z - a->view.z);
+  r3d_vertex_t v;
+  v.view = vec3_add(a->view, vec3_scale(vec3_sub(b->view, a->view), t));
+  v.view.z = r->near;
+  v.light = fx16_lerp(a->light, b->light, t);
+  project(r, &v);
+  return v;
+}
+
+void r3d_draw_mesh(r3d_t *r, const mesh_t *mesh, const mat4_t *model,
+                   r3d_shade_t shade) {
+  if (mesh->vertex_count > r->max_vertices)
+    return;
+  uint32_t t0 = time_us_32();
+
+  mat4_t mv = mat4_mul(&r->view, model);
+  bool gouraud = shade == R3D_SHADE_GOURAUD && mesh->normals;
+
+  for (uint32_t i = 0; i < mesh->vertex_count; i++) {
+    r3d_vertex_t *v = &r->verts[i];
+    v->view = mat4_transform(&mv, mesh->vertices[i]);
+    if (v->view.z >= r->near)
+      project(r, v);
+    if (gouraud)
+      v->light = light_for(r, mat4_rotate(&mv, mesh->normals[i]));
+  }
+
+  const uint16_t *idx = mesh->indices;
+  for (uint32_t t = 0; t < mesh->tri_count; t++, idx += 3) {
+    r->stats.tris_in++;
+    uint16_t c565 = mesh->colors ? mesh->colors[t] : mesh->color;
+    const r3d_vertex_t *v[3] = {&r->verts[idx[0]], &r->verts[idx[1]],
+                                &r->verts[idx[2]]};
+    int inside = 0;
+    for (int i = 0; i < 3; i++)
+      inside += v[i]->view.z >= r->near;
+
+    if (inside == 3) {
+      emit(r, v, c565, gouraud);
+      continue;
+    }
+    if (inside == 0) {
+      r->stats.tris_culled++;
+      continue;
+    }
+
+    // Near-plane clip (Sutherland-Hodgman): 3 or 4 vertices, fanned
+    r->stats.tris_clipped++;
+    r3d_vertex_t poly[4];
+    int n = 0;
+    for (int i = 0; i < 3; i++) {
+      const r3d_vertex_t *a = v[i], *b = v[(i + 1) % 3];
+      bool a_in = a->view.z >= r->near, b_in = b->view.z >= r->near;
+      if (a_in)
+        poly[n++] = *a;
+      if (a_in != b_in)
+        poly[n++] = near_point(r, a, b);
+    }
+    for (int i = 1; i + 1 < n; i++) {
+      const r3d_vertex_t *fan[3] = {&poly[0], &poly[i], &poly[i + 1]};
+      emit(r, fan, c565, gouraud);
+    }
+  }
+
+  r->stats.vertex_us += time_us_32() - t0;
+}
+
+// --- Raster Stage ---
+// First pixel whose centre is at or right of v: ceil(v - 0.5)
+static inline int first_center(fx16_t v) { return fx16_ceil(v - FX16_HALF); }
+
+// x of edge a -> b at y, kept within the edge's x range
+static inline fx16_t edge_x(fx16_t xa, fx16_t ya, fx16_t xb, fx16_t slope,
+                            fx16_t y) {
+  fx16_t x = xa + fx16_mul(y - ya, slope);
+  return fx16_clamp(x, fx16_min(xa, xb), fx16_max(xa, xb));
+}
+
+static inline uint16_t pack565(fx16_t r, fx16_t g, fx16_t b) {
+  return ((r >> 8) & 0xF800) | ((g >> 13) & 0x07E0) | ((b >> 19) & 0x001F);
+}
+
+static void gouraud_span(surface_t *surf, int x, int y, int w,
+                         const fx16_t c[3], const fx16_t dcdx[3]) {
+  uint32_t idx = surface_index(surf, x, y);
+  uint32_t step = surf->layout == SURFACE_LAYOUT_COLUMN_MAJOR ? surf->height
+                                                              : 1;
+  fx16_t r = c[0], g = c[1], b = c[2];
+
+  if (surf->format == PIXEL_FORMAT_RGB565) {
+    uint16_t *p = (uint16_t *)surf->pixels + idx;
+    for (int i = 0; i < w; i++, p += step) {
+      *p = pack565(r, g, b);
+      r += dcdx[0];
+      g += dcdx[1];
+      b += dcdx[2];
+    }
+  } else if (surf->format == PIXEL_FORMAT_RGB444) {
+    for (int i = 0; i < w; i++, idx += step) {
+      uint8_t r4 = (r >> 20) & 0x0F, g4 = (g >> 20) & 0x0F;
+      uint8_t b4 = (b >> 20) & 0x0F;
+      uint8_t *p = surf->pixels + (idx >> 1) * 3;
+      if ((idx & 1) == 0) {
+        p[0] = (r4 << 4) | g4;
+        p[1] = (b4 << 4) | (p[1] & 0x0F);
+      } else {
+        p[1] = (p[1] & 0xF0) | r4;
+        p[2] = (g4 << 4) | b4;
+      }
+      r += dcdx[0];
+      g += dcdx[1];
+      b += dcdx[2];
+    }
+  } else { // RGB332
+    uint8_t *p = surf->pixels + idx;
+    for (int i = 0; i < w; i++, p += step) {
+      *p = ((r >> 16) & 0xE0) | ((g >> 19) & 0x1C) | ((b >> 22) & 0x03);
+      r += dcdx[0];
+      g += dcdx[1];
+      b += dcdx[2];
+    }
+  }
+}
+
+static void raster_tri(surface_t *surf, const r3d_tri_t *t, int band0,
+                       int band1) {
+  // Vertices top to bottom
+  int a = 0, b = 1, c = 2, s;
+  if (t->y[b] < t->y[a]) {
+    s = a;
+    a = b;
+    b = s;
+  }
+  if (t->y[c] < t->y[a]) {
+    s = a;
+    a = c;
+    c = s;
+  }
+  if (t->y[c] < t->y[b]) {
+    s = b;
+    b = c;
+    c = s;
+  }
+  fx16_t xa = t->x[a], ya = t->y[a], xb = t->x[b], yb = t->y[b];
+  fx16_t xc = t->x[c], yc = t->y[c];
+
+  int row0 = first_center(ya), row1 = first_center(yc);
+  if (row0 < band0)
+    row0 = band0;
+  if (row1 > band1)
+    row1 = band1;
+  if (row0 >= row1)
+    return;
+
+  fx16_t slope_ac = fx16_div(xc - xa, yc - ya);
+  fx16_t slope_ab = yb > ya ? fx16_div(xb - xa, yb - ya) : 0;
+  fx16_t slope_bc = yc > yb ? fx16_div(xc - xb, yc - yb) : 0;
+
+  // Gouraud: colour is a plane over the triangle, d/dx and d/dy constant
+  fx16_t dcdx[3] = {0}, dcdy[3] = {0};
+  uint16_t color = 0;
+  if (t->gouraud) {
+    int32_t dx1 = (t->x[1] - t->x[0]) >> 12, dy1 = (t->y[1] - t->y[0]) >> 12;
+    int32_t dx2 = (t->x[2] - t->x[0]) >> 12, dy2 = (t->y[2] - t->y[0]) >> 12;
+    int64_t area = (int64_t)dx1 * dy2 - (int64_t)dx2 * dy1; // 28.4 squared
+    if (area == 0)
+      return;
+    for (int i = 0; i < 3; i++) {
+      int32_t dc1 = t->rgb[1][i] - t->rgb[0][i];
+      int32_t dc2 = t->rgb[2][i] - t->rgb[0][i];
+      // Channel per pixel in 16.16: (channel * 28.4) / 28.4^2 * 2^20
+      dcdx[i] = (fx16_t)(((int64_t)(dc1 * dy2 - dc2 * dy1) << 20) / area);
+      dcdy[i] = (fx16_t)(((int64_t)(dc2 * dx1 - dc1 * dx2) << 20) / area);
+    }
+  } else {
+    color = (uint16_t)(((t->rgb[0][0] & 0xF8) << 8) |
+                       ((t->rgb[0][1] & 0xFC) << 3) | (t->rgb[0][2] >> 3));
+  }
+
+  int width = surf->width;
+  for (int y = row0; y < row1; y++) {
+    fx16_t fy = fx16_from_int(y) + FX16_HALF;
+    fx16_t x_long = edge_x(xa, ya, xc, slope_ac, fy);
+    fx16_t x_short = fy < yb ? edge_x(xa, ya, xb, slope_ab, fy)
+                             : edge_x(xb, yb, xc, slope_bc, fy);
+    int x0 = first_center(fx16_min(x_long, x_short));
+    int x1 = first_center(fx16_max(x_long, x_short));
+    if (x0 < 0)
+      x0 = 0;
+    if (x1 > width)
+      x1 = width;
+    if (x1 <= x0)
+      continue;
+
+    if (!t->gouraud) {
+      span_fill(surf, x0, y, x1 - x0, color);
+      continue;
+    }
+
+    // Colour at the first pixel centre (+0.5 so the packers round)
+    fx16_t px = fx16_from_int(x0) + FX16_HALF - t->x[0];
+    fx16_t py = fy - t->y[0];
+    fx16_t c[3];
+    for (int i = 0; i < 3; i++)
+      c[i] = fx16_from_int(t->rgb[0][i]) + FX16_HALF +
+             fx16_mul(dcdx[i], px) + fx16_mul(dcdy[i], py);
+    gouraud_span(surf, x0, y, x1 - x0, c, dcdx);
+  }
+}
+
+static void raster_band(const r3d_t *r, int y0, int y1) {
+  for (uint32_t k = 0; k < r->tri_count; k++)
+    raster_tri(r->surf, &r->tris[r->order[k]], y0, y1);
+}
+
+typedef struct {
+  const r3d_t *r;
+  int y0, y1;
+} r3d_band_job_t;
+
+static r3d_band_job_t core1_band;
+
+static void core1_band_task(void *arg) {
+  r3d_band_job_t *job = (r3d_band_job_t *)arg;
+  raster_band(job->r, job->y0, job->y1);
+}
+
+// Far to near: LSD radix sort on the inverted key, two 8-bit passes
+static void sort_far_to_near(r3d_t *r) {
+  uint16_t count[256];
+  uint16_t *src = r->order, *dst = r->order_tmp;
+  for (uint32_t i = 0; i < r->tri_count; i++)
+    src[i] = (uint16_t)i;
+
+  for (int shift = 0; shift < 16; shift += 8) {
+    memset(count, 0, sizeof(count));
+    for (uint32_t i = 0; i < r->tri_count; i++)
+      count[((0xFFFF - r->tris[src[i]].key) >> shift) & 0xFF]++;
+    uint16_t sum = 0;
+    for (int d = 0; d < 256; d++) {
+      uint16_t n = count[d];
+      count[d] = sum;
+      sum += n;
+    }
+    for (uint32_t i = 0; i < r->tri_count; i++)
+      dst[count[((0xFFFF - r->tris[src[i]].key) >> shift) & 0xFF]++] = src[i];
+    uint16_t *tmp = src;
+    src = dst;
+    dst = tmp;
+  }
+  // Even number of passes: the result is back in r->order
+}
+
+void r3d_end(r3d_t *r) {
+  surface_t *surf = r->surf;
+  if (surf->pixels == NULL || r->tri_count == 0)
+    return;
+  uint32_t t0 = time_us_32();
+
+  occlusion_resolve(); // Triangles go over earlier recorded primitives
+  sort_far_to_near(r);
+
+  // Bands split at an even row, so the cores never share an RGB444 pair
+  // (3 bytes): with even line lengths a pair is two pixels of one row, or
+  // rows 2k and 2k + 1 of one column
+  bool columns = surf->layout == SURFACE_LAYOUT_COLUMN_MAJOR;
+  bool odd_pairs = surf->format == PIXEL_FORMAT_RGB444 &&
+                   ((columns ? surf->height : surf->width) & 1);
+  int split = (surf->height / 2) & ~1;
+  if (r->tri_count >= R3D_PARALLEL_MIN && get_core_num() == 0 && !odd_pairs &&
+      render_service_core1_free()) {
+    core1_band = (r3d_band_job_t){r, 0, split};
+    render_job_t job = {.type = RENDER_CMD_CALLBACK,
+                        .callback = core1_band_task,
+                        .callback_arg = &core1_band};
+    uint32_t ticket = render_service_submit(&job);
+    raster_band(r, split, surf->height);
+    render_service_wait_job(ticket);
+  } else {
+    raster_band(r, 0, surf->height);
+  }
+
+  r->stats.raster_us = time_us_32() - t0;
+}
@@ -0,0 +1,97 @@
+#ifndef RENDER3D_H
+#define RENDER3D_H
+
+#include "mat4.h"
+#include "surface.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Fixed-Point 3D Pipeline
+ * Flat and Gouraud-shaded triangle meshes, all in 16.16. Per frame:
+ * r3d_begin, any number of r3d_draw_mesh, r3d_end.
+ *  - r3d_draw_mesh (vertex work, calling core): model-view transform,
+ *    near-plane clip, perspective divide (one hardware divide per vertex),
+ *    back-face and off-screen culling, directional lighting. Triangles that
+ *    survive are queued with their average depth.
+ *  - r3d_end: painter's order (two-pass radix sort, far to near), then
+ *    the rows are split in two bands: Core 1 rasterizes the top one while
+ *    Core 0 does the bottom, each walking the whole sorted list clipped to
+ *    its band. Pixels are written straight into the RGB565/RGB444/RGB332
+ *    surface; flat spans go through span_fill.
+ * There is no depth buffer, so intersecting triangles resolve by average
+ * depth. Direct Mode surfaces are not supported.
+ *
+ * View space: x right, y up, camera looking down +z. Front faces are
+ * counter-clockwise as seen by the camera.
+ */
+
+// Below this many triangles r3d_end rasterizes on one core
+#define R3D_PARALLEL_MIN 8
+
+typedef enum {
+  R3D_SHADE_FLAT = 0, // One light value per face (geometric normal)
+  R3D_SHADE_GOURAUD   // Per-vertex light, interpolated (needs normals)
+} r3d_shade_t;
+
+typedef struct {
+  const vec3_t *vertices;
+  const vec3_t *normals;   // Unit normal per vertex; NULL: flat only
+  const uint16_t *indices; // 3 per triangle
+  const uint16_t *colors;  // RGB565 per triangle; NULL: `color`
+  uint16_t vertex_count;
+  uint16_t tri_count;
+  uint16_t color;
+} mesh_t;
+
+typedef struct {
+  uint32_t tris_in;      // Submitted since r3d_begin
+  uint32_t tris_drawn;   // Queued for rasterization
+  uint32_t tris_culled;  // Back-facing, off-screen or behind the camera
+  uint32_t tris_clipped; // Cut by the near plane
+  uint32_t vertex_us;    // Time in r3d_draw_mesh
+  uint32_t raster_us;    // Time in r3d_end (sort + rasterize)
+} r3d_stats_t;
+
+typedef struct r3d_tri r3d_tri_t;
+typedef struct r3d_vertex r3d_vertex_t;
+
+typedef struct {
+  uint16_t max_tris;
+  uint16_t max_vertices; // Per mesh
+  r3d_tri_t *tris;
+  uint16_t *order;
+  uint16_t *order_tmp;
+  r3d_vertex_t *verts;
+  uint16_t tri_count;
+  surface_t *surf;
+  mat4_t view;      // World to camera
+  fx16_t focal;     // Pixels per unit at z = 1 (0: 90 degree horizontal FOV)
+  fx16_t near;      // Near plane distance
+  vec3_t light_dir; // Unit vector towards the light, view space
+  fx16_t ambient;   // Light floor, 0..FX16_ONE
+  bool cull_backfaces;
+  r3d_stats_t stats;
+} r3d_t;
+
+// Arena bytes (ARENA_TAG_APP) r3d_init() takes
+uint32_t r3d_get_arena_size(uint16_t max_tris, uint16_t max_vertices);
+
+// Identity view, 0.1 near plane, light from the upper left behind the
+// camera, 0.25 ambient, back-face culling on
+bool r3d_init(r3d_t *r, uint16_t max_tris, uint16_t max_vertices);
+
+// Horizontal field of view for a surface `width` pixels wide
+void r3d_set_fov(r3d_t *r, fx_angle_t fov, uint16_t width);
+
+void r3d_begin(r3d_t *r, surface_t *surf);
+
+// Queue a mesh. Triangles past max_tris are dropped; meshes with more than
+// max_vertices vertices are skipped.
+void r3d_draw_mesh(r3d_t *r, const mesh_t *mesh, const mat4_t *model,
+                   r3d_shade_t shade);
+
+// Sort and rasterize everything queued since r3d_begin
+void r3d_end(r3d_t *r);
+
+#endif
@@ -1,23 +1,30 @@
 #include "render_service.h"
+#include "hardware/sync.h"
 #include "pico/multicore.h"
 #include "pico/time.h"
+#include "system_config.h"
 
-static volatile render_job_t current_job;
+// Job ring: Core 0 fills a slot and pushes its sequence number through the
+// FIFO; Core 1 runs jobs in order and publishes how many have finished
+static render_job_t jobs[RENDER_QUEUE_LEN];
+static uint32_t submitted = 0;          // Core 0 only
+static volatile uint32_t completed = 0; // Written by Core 1
 static volatile uint32_t core1_busy_us = 0;
+static uint32_t long_ticket = 0;        // Core 0 only
+static bool long_pending = false;
 
 static void core1_render_entry() {
   while (1) {
-    uint32_t cmd = multicore_fifo_pop_blocking();
+    uint32_t seq = multicore_fifo_pop_blocking();
     uint32_t start_time = time_us_32();
+    const render_job_t current_job = jobs[seq % RENDER_QUEUE_LEN];
+    render_command_t cmd = current_job.type;
 
     if (cmd == RENDER_CMD_EXIT)
       break;
 
     surface_t *surf = current_job.surface;
-    if (!surf)
-      goto done;
-
-    if (cmd == RENDER_CMD_CLEAR) {
+    if (cmd == RENDER_CMD_CLEAR && surf) {
       uint8_t *fb_ptr = surf->pixels;
       if (surf->format == PIXEL_FORMAT_RGB444) {
         uint32_t w0, w1, w2;
@@ -52,20 +59,54 @@ static void core1_render_entry() {
       }
     }
 
-  done:
     core1_busy_us += (time_us_32() - start_time);
-    multicore_fifo_push_blocking(1);
+    completed = seq + 1;
+    __sev(); // Wake a Core 0 waiter
   }
 }
 
 void render_service_init(void) { multicore_launch_core1(core1_render_entry); }
 
-void render_service_submit(const render_job_t *job) {
-  current_job = *job;
-  multicore_fifo_push_blocking(job->type);
+uint32_t render_service_submit(const render_job_t *job) {
+  // The slot RENDER_QUEUE_LEN jobs back must have been consumed
+  if (submitted >= RENDER_QUEUE_LEN)
+    render_service_wait_job(submitted - RENDER_QUEUE_LEN);
+
+  jobs[submitted % RENDER_QUEUE_LEN] = *job;
+  __dmb(); // Slot visible before Core 1 sees its number
+  multicore_fifo_push_blocking(submitted);
+  return submitted++;
+}
+
+bool render_service_job_done(uint32_t ticket) {
+  return (int32_t)(completed - ticket) > 0;
+}
+
+void render_service_wait_job(uint32_t ticket) {
+  if (render_service_job_done(ticket))
+    return;
+  uint32_t start = system_idle_begin();
+  while (!render_service_job_done(ticket))
+    __wfe(); // Core 1 signals each finished job
+  system_idle_end(start);
 }
 
-void render_service_wait(void) { multicore_fifo_pop_blocking(); }
+void render_service_wait(void) {
+  if (submitted > 0)
+    render_service_wait_job(submitted - 1);
+}
+
+void render_service_set_long_job(uint32_t ticket) {
+  long_ticket = ticket;
+  long_pending = true;
+}
+
+bool render_service_core1_free(void) {
+  if (long_pending && !render_service_job_done(long_ticket))
+    return false;
+  long_pending = false;
+  return true;
+}
 
 uint32_t render_service_get_busy_us(void) { return core1_busy_us; }
 
@@ -2,6 +2,7 @@
 #define RENDER_SERVICE_H
 
 #include "surface.h"
+#include <stdbool.h>
 #include <stdint.h>
 
 typedef enum {
@@ -27,13 +28,29 @@ typedef struct {
 // Initialize the second core for rendering jobs
 void render_service_init(void);
 
-// Submit a job to the render service
-void render_service_submit(const render_job_t *job);
+// Jobs run on Core 1 in submission order; up to RENDER_QUEUE_LEN may be
+// outstanding (submit waits for a free slot beyond that)
+#define RENDER_QUEUE_LEN 4
 
-// Wait for a job to complete
+// Submit a job to the render service; returns its ticket
+uint32_t render_service_submit(const render_job_t *job);
+
+// Job completion by ticket (sleeps in WFE)
+bool render_service_job_done(uint32_t ticket);
+void render_service_wait_job(uint32_t ticket);
+
+// Wait for every submitted job to complete
 void render_service_wait(void);
 
-// Get busy time from core 1
+// A job that holds Core 1 for most of a frame (the engine's pipelined
+// update). Work split across the cores would queue behind it and stall
+// Core 0 until it ends, so split paths ask render_service_core1_free()
+// first and do the whole job on Core 0 while it runs.
+void render_service_set_long_job(uint32_t ticket);
+bool render_service_core1_free(void);
+
+// Get busy time from core 1 (job time, including any time the job slept:
+// subtract system_get_idle_us(1) for real work)
 uint32_t render_service_get_busy_us(void);
 void render_service_reset_stats(void);
 
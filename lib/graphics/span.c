@@ -0,0 +1,123 @@
+#include "span.h"
+#include <string.h>
+
+static void rgb444_put(uint8_t *pixels, uint32_t pixel_idx, uint8_t r4,
+                       uint8_t g4, uint8_t b4) {
+  uint8_t *p = pixels + (pixel_idx / 2) * 3;
+  if (pixel_idx % 2 == 0) {
+    p[0] = (r4 << 4) | g4;
+    p[1] = (b4 << 4) | (p[1] & 0x0F);
+  } else {
+    p[1] = (p[1] & 0xF0) | r4;
+    p[2] = (g4 << 4) | b4;
+  }
+}
+
+// Kernels fill `w` consecutive pixels of the linear pixel array from idx
+static void run_fill_rgb444(surface_t *surf, uint32_t idx, int w,
+                            uint16_t color) {
+  uint8_t r4 = ((color >> 11) & 0x1F) >> 1;
+  uint8_t g4 = ((color >> 5) & 0x3F) >> 2;
+  uint8_t b4 = (color & 0x1F) >> 1;
+  uint8_t b0 = (r4 << 4) | g4;
+  uint8_t b1 = (b4 << 4) | r4;
+  uint8_t b2 = (g4 << 4) | b4;
+
+  // Leading odd pixel shares its byte with the neighbour
+  if (idx % 2) {
+    rgb444_put(surf->pixels, idx, r4, g4, b4);
+    idx++;
+    w--;
+  }
+
+  // Pairs until the next 8-pixel (12-byte, word-aligned) boundary
+  uint8_t *p = surf->pixels + (idx / 2) * 3;
+  while (w >= 2 && (idx % 8) != 0) {
+    p[0] = b0;
+    p[1] = b1;
+    p[2] = b2;
+    p += 3;
+    idx += 2;
+    w -= 2;
+  }
+
+  // Word-aligned blocks: 8 pixels = 3 words
+  if (w >= 8) {
+    uint32_t w0 = b0 | (b1 << 8) | (b2 << 16) | (b0 << 24);
+    uint32_t w1 = b1 | (b2 << 8) | (b0 << 16) | (b1 << 24);
+    uint32_t w2 = b2 | (b0 << 8) | (b1 << 16) | (b2 << 24);
+    uint32_t *ptr32 = (uint32_t *)p;
+    while (w >= 8) {
+      *ptr32++ = w0;
+      *ptr32++ = w1;
+      *ptr32++ = w2;
+      idx += 8;
+      w -= 8;
+    }
+    p = (uint8_t *)ptr32;
+  }
+
+  while (w >= 2) {
+    p[0] = b0;
+    p[1] = b1;
+    p[2] = b2;
+    p += 3;
+    idx += 2;
+    w -= 2;
+  }
+
+  if (w)
+    rgb444_put(surf->pixels, idx, r4, g4, b4);
+}
+
+static void run_fill_rgb565(surface_t *surf, uint32_t idx, int w,
+                            uint16_t color) {
+  uint16_t *p16 = (uint16_t *)(surf->pixels + idx * 2);
+
+  if (((uintptr_t)p16 & 2) && w) {
+    *p16++ = color;
+    w--;
+  }
+
+  uint32_t v32 = color | ((uint32_t)color << 16);
+  uint32_t *p32 = (uint32_t *)p16;
+  while (w >= 2) {
+    *p32++ = v32;
+    w -= 2;
+  }
+
+  if (w)
+    *(uint16_t *)p32 = color;
+}
+
+static void run_fill(surface_t *surf, uint32_t idx, int w, uint16_t color) {
+  if (surf->format == PIXEL_FORMAT_RGB565) {
+    run_fill_rgb565(surf, idx, w, color);
+  } else if (surf->format == PIXEL_FORMAT_RGB444) {
+    run_fill_rgb444(surf, idx, w, color);
+  } else { // RGB332
+    uint8_t r3 = (color >> 13) & 0x07;
+    uint8_t g3 = (color >> 8) & 0x07;
+    uint8_t b2 = (color >> 3) & 0x03;
+    memset(surf->pixels + idx, (r3 << 5) | (g3 << 2) | b2, w);
+  }
+}
+
+void span_fill(surface_t *surf, int x, int y, int w, uint16_t color) {
+  if (surf->layout == SURFACE_LAYOUT_ROW_MAJOR) {
+    run_fill(surf, surface_index(surf, x, y), w, color);
+    return;
+  }
+  // Column-major: one pixel per column
+  for (int i = 0; i < w; i++)
+    run_fill(surf, surface_index(surf, x + i, y), 1, color);
+}
+
+void span_fill_v(surface_t *surf, int x, int y, int h, uint16_t color) {
+  if (surf->layout == SURFACE_LAYOUT_COLUMN_MAJOR) {
+    run_fill(surf, surface_index(surf, x, y), h, color);
+    return;
+  }
+  for (int i = 0; i < h; i++)
+    run_fill(surf, surface_index(surf, x, y + i), 1, color);
+}
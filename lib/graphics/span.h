@@ -0,0 +1,19 @@
+#ifndef SPAN_H
+#define SPAN_H
+
+#include "surface.h"
+
+/**
+ * Span Kernels
+ * Raw horizontal fills into a packed surface. Callers clip; these never go
+ * through Direct Mode or any recording pass.
+ */
+
+// Fill w pixels of row y starting at x (x, y, w already clipped, w > 0)
+void span_fill(surface_t *surf, int x, int y, int w, uint16_t color);
+
+// Fill h pixels of column x starting at y. Contiguous (word stores) on
+// column-major surfaces; the horizontal span is the fast one otherwise.
+void span_fill_v(surface_t *surf, int x, int y, int h, uint16_t color);
+
+#endif
@@ -0,0 +1,88 @@
+#include "subpixel.h"
+#include "framebuffer.h"
+
+// First pixel whose centre is at or right of v: ceil(v - 0.5)
+static inline int first_center(fx16_t v) { return fx16_ceil(v - FX16_HALF); }
+
+void draw_pixel_fx(surface_t *surf, fx16_t x, fx16_t y, uint16_t color) {
+  draw_pixel(surf, fx16_floor(x), fx16_floor(y), color);
+}
+
+void draw_rect_fx(surface_t *surf, fx16_t x, fx16_t y, fx16_t w, fx16_t h,
+                  uint16_t color) {
+  int x0 = first_center(x), x1 = first_center(x + w);
+  int y0 = first_center(y), y1 = first_center(y + h);
+  draw_rect(surf, x0, y0, x1 - x0, y1 - y0, color);
+}
+
+void draw_circle_fx(surface_t *surf, fx16_t cx, fx16_t cy, fx16_t radius,
+                    uint16_t color) {
+  if (radius <= 0)
+    return;
+  if (radius > fx16_from_int(255)) {
+    draw_circle(surf, fx16_round(cx), fx16_round(cy), fx16_round(radius),
+                color);
+    return;
+  }
+
+  int y0 = first_center(cy - radius), y1 = first_center(cy + radius);
+  if (y0 < 0)
+    y0 = 0;
+  if (y1 > surf->height)
+    y1 = surf->height;
+
+  // Half-width per row in 24.8: r^2 - dy^2 stays within 32 bits up to 255 px
+  int32_t r8 = radius >> 8;
+  uint32_t r_sq = (uint32_t)r8 * (uint32_t)r8;
+  for (int y = y0; y < y1; y++) {
+    int32_t dy8 = (fx16_from_int(y) + FX16_HALF - cy) >> 8;
+    if (dy8 < 0)
+      dy8 = -dy8;
+    if (dy8 >= r8)
+      continue;
+    uint32_t d = r_sq - (uint32_t)dy8 * (uint32_t)dy8;
+    fx16_t half_w = (fx16_t)fx_isqrt(d) << 8;
+    int x0 = first_center(cx - half_w), x1 = first_center(cx + half_w);
+    if (x1 > x0)
+      draw_rect(surf, x0, y, x1 - x0, 1, color);
+  }
+}
+
+void draw_line_fx(surface_t *surf, fx16_t x0, fx16_t y0, fx16_t x1, fx16_t y1,
+                  uint16_t color) {
+  // Walk the major axis as "u", the minor one as "v"
+  bool steep = fx16_abs(y1 - y0) > fx16_abs(x1 - x0);
+  fx16_t u0 = steep ? y0 : x0, v0 = steep ? x0 : y0;
+  fx16_t u1 = steep ? y1 : x1, v1 = steep ? x1 : y1;
+  if (u0 > u1) {
+    fx16_t t = u0;
+    u0 = u1;
+    u1 = t;
+    t = v0;
+    v0 = v1;
+    v1 = t;
+  }
+
+  int limit = steep ? surf->height : surf->width;
+  int p0 = fx16_floor(u0), p1 = fx16_floor(u1);
+  if (p0 < 0)
+    p0 = 0;
+  if (p1 >= limit)
+    p1 = limit - 1;
+  if (p0 > p1)
+    return;
+
+  // |slope| <= 1; one divide per line, then one add per pixel
+  fx16_t slope = (u1 > u0) ? fx16_div(v1 - v0, u1 - u0) : 0;
+  fx16_t v_lo = fx16_min(v0, v1), v_hi = fx16_max(v0, v1);
+  fx16_t v = v0 + fx16_mul(fx16_from_int(p0) + FX16_HALF - u0, slope);
+
+  for (int p = p0; p <= p1; p++, v += slope) {
+    // The end pixels sample inside the segment, not past its endpoints
+    int q = fx16_floor(fx16_clamp(v, v_lo, v_hi));
+    if (steep)
+      draw_pixel(surf, q, p, color);
+    else
+      draw_pixel(surf, p, q, color);
+  }
+}
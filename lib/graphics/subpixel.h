@@ -0,0 +1,33 @@
+#ifndef SUBPIXEL_H
+#define SUBPIXEL_H
+
+#include "fixed.h"
+#include "surface.h"
+
+/**
+ * Subpixel Primitives
+ * Draw calls that take 16.16 coordinates, so objects simulated in fixed
+ * point move smoothly instead of snapping to whole pixels. A pixel is
+ * filled when its centre (x + 0.5, y + 0.5) falls inside the shape; edges
+ * are hard (no coverage blending), so these go through the same opaque
+ * paths as the integer primitives (occlusion, Direct Mode batching).
+ */
+
+// Pixel containing the point
+void draw_pixel_fx(surface_t *surf, fx16_t x, fx16_t y, uint16_t color);
+
+// Rectangle [x, x + w) x [y, y + h)
+void draw_rect_fx(surface_t *surf, fx16_t x, fx16_t y, fx16_t w, fx16_t h,
+                  uint16_t color);
+
+// Filled circle; the outline follows the exact centre and radius. Radii
+// above 255 pixels fall back to the integer circle.
+void draw_circle_fx(surface_t *surf, fx16_t cx, fx16_t cy, fx16_t radius,
+                    uint16_t color);
+
+// One-pixel line, one pixel per column (or row) along the major axis,
+// sampled at the pixel centre
+void draw_line_fx(surface_t *surf, fx16_t x0, fx16_t y0, fx16_t x1, fx16_t y1,
+                  uint16_t color);
+
+#endif
@@ -5,9 +5,19 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+// Pixel order in memory. Column-major stores each screen column
+// contiguously (for vertical-span renderers); the panel is switched to the
+// matching MADCTL orientation so the buffer is sent without a transpose.
+typedef enum {
+  SURFACE_LAYOUT_ROW_MAJOR = 0,
+  SURFACE_LAYOUT_COLUMN_MAJOR
+} surface_layout_t;
+
 /**
  * Surface structure
- * Defines a memory region where pixels can be drawn.
+ * Defines a memory region where pixels can be drawn. RGB565 pixels are
+ * native uint16_t (the transport puts them on the wire high byte first),
+ * RGB444 packs two pixels in 3 bytes, RGB332 is one byte per pixel.
  */
 typedef struct {
   uint8_t *pixels;
@@ -15,6 +25,21 @@ typedef struct {
   uint16_t height;
   display_pixel_format_t format;
   uint32_t size;
+  uint16_t row_offset; // Ring origin: row y is stored at (y + row_offset) % height
+  surface_layout_t layout;
 } surface_t;
 
+// Stored row of logical row y (0 <= y < height)
+static inline int surface_row(const surface_t *surf, int y) {
+  int row = y + surf->row_offset;
+  return (row >= surf->height) ? row - surf->height : row;
+}
+
+// Index of pixel (x, y) in the surface's linear pixel array
+static inline uint32_t surface_index(const surface_t *surf, int x, int y) {
+  if (surf->layout == SURFACE_LAYOUT_COLUMN_MAJOR)
+    return (uint32_t)x * surf->height + y;
+  return (uint32_t)surface_row(surf, y) * surf->width + x;
+}
+
 #endif
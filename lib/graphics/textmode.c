@@ -0,0 +1,263 @@
+#include "textmode.h"
+#include "arena.h"
+#include "direct_batch.h"
+#include "display_driver.h"
+#include "framebuffer.h"
+#include <string.h>
+
+static const uint16_t cga_palette[TEXTMODE_PALETTE_SIZE] = {
+    0x0000, 0x0015, 0x0540, 0x0555, 0xA800, 0xA815, 0xAAA0, 0xAD55,
+    0x52AA, 0x52BF, 0x57EA, 0x57FF, 0xFAAA, 0xFABF, 0xFFEA, 0xFFFF};
+
+static uint32_t stage_bytes(const font_t *font, uint16_t cols) {
+  uint32_t cell_w = (font->width + 1) * font->scale;
+  uint32_t cell_h = font->height * font->scale;
+  return cols * cell_w * cell_h * 2; // Worst case: 16-bit wire
+}
+
+uint32_t textmode_get_arena_size(const font_t *font, uint16_t cols,
+                                 uint16_t rows) {
+  uint32_t cells = cols * rows;
+  return arena_reserve_size(cells * sizeof(text_cell_t), 4) +
+         arena_reserve_size(((cells + 31) / 32) * 4, 4) +
+         2 * arena_reserve_size(stage_bytes(font, cols), ARENA_ALIGN_DMA);
+}
+
+bool textmode_init(textmode_t *tm, const font_t *font, uint16_t x, uint16_t y,
+                   uint16_t cols, uint16_t rows) {
+  memset(tm, 0, sizeof(*tm));
+  uint32_t cells = cols * rows;
+
+  tm->cells = (text_cell_t *)arena_alloc(ARENA_TAG_APP,
+                                         cells * sizeof(text_cell_t), 4);
+  tm->dirty = (uint32_t *)arena_alloc(ARENA_TAG_APP, ((cells + 31) / 32) * 4, 4);
+  for (int i = 0; i < 2; i++)
+    tm->stage[i] = (uint8_t *)arena_alloc(
+        ARENA_TAG_APP, stage_bytes(font, cols), ARENA_ALIGN_DMA);
+  if (!tm->cells || !tm->dirty || !tm->stage[0] || !tm->stage[1])
+    return false;
+
+  tm->font = font;
+  tm->cols = cols;
+  tm->rows = rows;
+  tm->origin_x = x;
+  tm->origin_y = y;
+  tm->cell_w = (font->width + 1) * font->scale; // 1 column of spacing
+  tm->cell_h = font->height * font->scale;
+  tm->attr = TEXT_ATTR(7, 0);
+  memcpy(tm->palette, cga_palette, sizeof(cga_palette));
+
+  for (uint32_t i = 0; i < cells; i++) {
+    tm->cells[i].ch = ' ';
+    tm->cells[i].attr = tm->attr;
+  }
+  textmode_invalidate(tm);
+  return true;
+}
+
+// --- Cells ---
+static inline bool cell_dirty(const textmode_t *tm, uint32_t idx) {
+  return (tm->dirty[idx >> 5] >> (idx & 31)) & 1;
+}
+
+void textmode_put(textmode_t *tm, uint16_t col, uint16_t row, char c,
+                  uint8_t attr) {
+  if (col >= tm->cols || row >= tm->rows)
+    return;
+  uint32_t idx = row * tm->cols + col;
+  text_cell_t *cell = &tm->cells[idx];
+  if (cell->ch == c && cell->attr == attr)
+    return; // Unchanged cells are never resent
+  cell->ch = c;
+  cell->attr = attr;
+  tm->dirty[idx >> 5] |= 1u << (idx & 31);
+}
+
+void textmode_clear(textmode_t *tm) {
+  for (uint16_t row = 0; row < tm->rows; row++)
+    for (uint16_t col = 0; col < tm->cols; col++)
+      textmode_put(tm, col, row, ' ', tm->attr);
+  tm->cursor_col = 0;
+  tm->cursor_row = 0;
+}
+
+void textmode_set_cursor(textmode_t *tm, uint16_t col, uint16_t row) {
+  tm->cursor_col = (col < tm->cols) ? col : tm->cols - 1;
+  tm->cursor_row = (row < tm->rows) ? row : tm->rows - 1;
+}
+
+void textmode_set_attr(textmode_t *tm, uint8_t attr) { tm->attr = attr; }
+
+void textmode_invalidate(textmode_t *tm) {
+  memset(tm->dirty, 0xFF, ((tm->cols * tm->rows + 31) / 32) * 4);
+}
+
+// Move every row up by one; only cells that differ from the row below get
+// flagged, so mostly-blank terminals stay cheap
+static void scroll_up(textmode_t *tm) {
+  for (uint16_t row = 0; row + 1 < tm->rows; row++) {
+    const text_cell_t *below = &tm->cells[(row + 1) * tm->cols];
+    for (uint16_t col = 0; col < tm->cols; col++)
+      textmode_put(tm, col, row, below[col].ch, below[col].attr);
+  }
+  for (uint16_t col = 0; col < tm->cols; col++)
+    textmode_put(tm, col, tm->rows - 1, ' ', tm->attr);
+}
+
+void textmode_write(textmode_t *tm, const char *str) {
+  for (; *str; str++) {
+    char c = *str;
+    if (c == '\n') {
+      tm->cursor_col = 0;
+      tm->cursor_row++;
+    } else if (c == '\r') {
+      tm->cursor_col = 0;
+    } else if (c == '\b') {
+      if (tm->cursor_col > 0)
+        tm->cursor_col--;
+    } else if (c == '\t') {
+      tm->cursor_col = (tm->cursor_col + 8) & ~7;
+    } else {
+      textmode_put(tm, tm->cursor_col, tm->cursor_row, c, tm->attr);
+      tm->cursor_col++;
+    }
+
+    if (tm->cursor_col >= tm->cols) {
+      tm->cursor_col = 0;
+      tm->cursor_row++;
+    }
+    if (tm->cursor_row >= tm->rows) {
+      scroll_up(tm);
+      tm->cursor_row = tm->rows - 1;
+    }
+  }
+}
+
+// --- Present ---
+// Render cells [c0, c1) of a text row into `out` in the wire format.
+// Cell widths are even, so RGB444 pairs never straddle a send.
+static uint32_t render_run(const textmode_t *tm, uint16_t row, uint16_t c0,
+                           uint16_t c1, uint8_t *out, bool rgb444) {
+  const font_t *font = tm->font;
+  const text_cell_t *cells = &tm->cells[row * tm->cols];
+  uint8_t *p = out;
+  uint16_t pending = 0;
+  bool odd = false;
+
+  for (uint8_t py = 0; py < tm->cell_h; py++) {
+    uint8_t gy = py / font->scale;
+    for (uint16_t c = c0; c < c1; c++) {
+      const uint8_t *glyph = font_glyph(font, cells[c].ch);
+      uint16_t fg = tm->palette[cells[c].attr & 0x0F];
+      uint16_t bg = tm->palette[cells[c].attr >> 4];
+
+      for (uint8_t px = 0; px < tm->cell_w; px++) {
+        uint8_t gx = px / font->scale;
+        bool on = glyph && gx < font->width && ((glyph[gx] >> gy) & 1);
+        uint16_t color = on ? fg : bg;
+
+        if (!rgb444) {
+          *(uint16_t *)p = color; // Native; the transport orders the wire
+          p += 2;
+        } else if (!odd) {
+          pending = color;
+          odd = true;
+        } else {
+          // R0G0 B0R1 G1B1
+          p[0] = ((pending >> 12) << 4) | ((pending >> 7) & 0x0F);
+          p[1] = (((pending >> 1) & 0x0F) << 4) | (color >> 12);
+          p[2] = (((color >> 7) & 0x0F) << 4) | ((color >> 1) & 0x0F);
+          p += 3;
+          odd = false;
+        }
+      }
+    }
+  }
+  return p - out;
+}
+
+static bool row_all_dirty(const textmode_t *tm, uint16_t row) {
+  uint32_t idx = row * tm->cols;
+  for (uint16_t col = 0; col < tm->cols; col++)
+    if (!cell_dirty(tm, idx + col))
+      return false;
+  return true;
+}
+
+// One window covering cells [c0, c1) of rows [row, row + rows). Each text
+// row is rendered while the previous one is on the wire.
+static void send_block(textmode_t *tm, uint16_t row, uint16_t rows,
+                       uint16_t c0, uint16_t c1, int *stage_idx, bool rgb444) {
+  for (uint16_t r = row; r < row + rows; r++) {
+    uint8_t *buf = tm->stage[*stage_idx];
+    uint32_t len = render_run(tm, r, c0, c1, buf, rgb444);
+
+    if (r == row) {
+      display_end_bulk(); // Previous window must drain before re-windowing
+      display_set_window(tm->origin_x + c0 * tm->cell_w,
+                         tm->origin_y + row * tm->cell_h,
+                         tm->origin_x + c1 * tm->cell_w - 1,
+                         tm->origin_y + (row + rows) * tm->cell_h - 1);
+      display_start_bulk();
+      tm->windows_sent++;
+    } else {
+      display_wait_ready();
+    }
+    display_send_buffer(buf, len);
+    *stage_idx ^= 1;
+
+    for (uint16_t c = c0; c < c1; c++) {
+      uint32_t idx = r * tm->cols + c;
+      tm->dirty[idx >> 5] &= ~(1u << (idx & 31));
+    }
+    tm->cells_sent += c1 - c0;
+  }
+}
+
+void textmode_present(textmode_t *tm) {
+  bool rgb444 = display_get_wire_format() == PIXEL_FORMAT_RGB444;
+  int stage_idx = 0;
+  tm->cells_sent = 0;
+  tm->windows_sent = 0;
+
+  // An async present (Core 1 task, queued frame) may still own the wire:
+  // its windows and commands must not interleave with the cells'
+  framebuffer_wait_last_swap();
+  direct_batch_flush(); // Keep painter's order with batched fills
+
+  uint16_t row = 0;
+  while (row < tm->rows) {
+    // Consecutive fully changed rows share one window
+    if (row_all_dirty(tm, row)) {
+      uint16_t n = 1;
+      while (row + n < tm->rows && row_all_dirty(tm, row + n))
+        n++;
+      send_block(tm, row, n, 0, tm->cols, &stage_idx, rgb444);
+      row += n;
+      continue;
+    }
+
+    // Runs of changed cells; a single clean cell between two runs is
+    // cheaper to resend than a second window
+    uint32_t base = row * tm->cols;
+    uint16_t col = 0;
+    while (col < tm->cols) {
+      if (!cell_dirty(tm, base + col)) {
+        col++;
+        continue;
+      }
+      uint16_t end = col + 1;
+      while (end < tm->cols &&
+             (cell_dirty(tm, base + end) ||
+              (end + 1 < tm->cols && cell_dirty(tm, base + end + 1))))
+        end++;
+      send_block(tm, row, 1, col, end, &stage_idx, rgb444);
+      col = end;
+    }
+    row++;
+  }
+
+  display_end_bulk();
+  if (tm->windows_sent)
+    framebuffer_invalidate(); // The panel no longer matches any present
+}
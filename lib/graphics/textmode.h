@@ -0,0 +1,73 @@
+#ifndef TEXTMODE_H
+#define TEXTMODE_H
+
+#include "font.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Character-Cell Text Mode
+ * A grid of characters + attributes drawn with a font_t (6x7 cells for the
+ * 5x7 font: 53x34 on a 320x240 panel). Writes only flag cells whose content
+ * changed; textmode_present sends the flagged cells straight to the panel,
+ * one window per run of cells on a text row and one window for consecutive
+ * fully changed rows. Works in Direct Mode or on top of a framebuffer that
+ * is not being presented at the same time, and only while the panel scans
+ * row-major (see framebuffer_set_layout).
+ */
+
+#define TEXTMODE_PALETTE_SIZE 16
+
+// Attribute byte: foreground palette index (low nibble), background (high)
+#define TEXT_ATTR(fg, bg) ((uint8_t)(((bg) << 4) | ((fg) & 0x0F)))
+
+typedef struct {
+  char ch;
+  uint8_t attr;
+} text_cell_t;
+
+typedef struct {
+  const font_t *font;
+  uint16_t cols;
+  uint16_t rows;
+  uint16_t origin_x; // Panel position of cell (0, 0)
+  uint16_t origin_y;
+  uint8_t cell_w;
+  uint8_t cell_h;
+  text_cell_t *cells;
+  uint32_t *dirty; // 1 bit per cell, row-major
+  uint8_t *stage[2]; // Ping-pong pixel buffers, one text row each
+  uint16_t cursor_col;
+  uint16_t cursor_row;
+  uint8_t attr; // Attribute for textmode_write
+  uint16_t palette[TEXTMODE_PALETTE_SIZE]; // RGB565
+  uint32_t cells_sent; // Last present
+  uint16_t windows_sent;
+} textmode_t;
+
+// Arena bytes (ARENA_TAG_APP) textmode_init() takes
+uint32_t textmode_get_arena_size(const font_t *font, uint16_t cols,
+                                 uint16_t rows);
+
+// Grid of cols x rows cells with its top-left at (x, y); starts blank and
+// fully dirty, with the 16-colour CGA palette
+bool textmode_init(textmode_t *tm, const font_t *font, uint16_t x, uint16_t y,
+                   uint16_t cols, uint16_t rows);
+
+void textmode_clear(textmode_t *tm);
+void textmode_put(textmode_t *tm, uint16_t col, uint16_t row, char c,
+                  uint8_t attr);
+void textmode_set_cursor(textmode_t *tm, uint16_t col, uint16_t row);
+void textmode_set_attr(textmode_t *tm, uint8_t attr);
+
+// Terminal-style output at the cursor: wraps, handles \n \r \b \t and
+// scrolls the grid up at the bottom
+void textmode_write(textmode_t *tm, const char *str);
+
+// Mark every cell dirty (e.g. after something else drew over the area)
+void textmode_invalidate(textmode_t *tm);
+
+// Send changed cells to the panel and clear their dirty bits (blocking)
+void textmode_present(textmode_t *tm);
+
+#endif
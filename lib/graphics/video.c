@@ -0,0 +1,188 @@
+#include "video.h"
+#include "arena.h"
+#include "display_driver.h"
+#include "pico/stdlib.h"
+#include "render_service.h"
+#include "system_config.h"
+
+static inline uint32_t packed_bytes(uint8_t format, uint32_t pixels) {
+  return format == PIXEL_FORMAT_RGB444 ? (pixels * 3 + 1) / 2 : pixels * 2;
+}
+
+static inline const video_frame_t *first_frame(const video_t *v) {
+  return (const video_frame_t *)(v + 1);
+}
+
+static inline const video_frame_t *next_frame(const video_frame_t *f) {
+  const uint8_t *ops = (const uint8_t *)(f + 1) +
+                       f->run_count * sizeof(video_run_t);
+  return (const video_frame_t *)(ops + ((f->data_bytes + 3) & ~3u));
+}
+
+const video_t *video_map(const void *data) {
+  const video_t *v = (const video_t *)data;
+  if (v == NULL || ((uintptr_t)v & 3) || v->magic != VIDEO_MAGIC)
+    return NULL;
+  if (v->format != PIXEL_FORMAT_RGB565 && v->format != PIXEL_FORMAT_RGB444)
+    return NULL;
+  // Even widths keep every RGB444 window row on a pixel pair
+  if (v->format == PIXEL_FORMAT_RGB444 && (v->width & 1))
+    return NULL;
+  if (v->block < 2 || (v->block & 1) || v->width == 0 || v->height == 0 ||
+      v->frame_count == 0 || v->frame_us == 0)
+    return NULL;
+  return v;
+}
+
+uint32_t video_player_get_arena_size(void) {
+  return 2 * arena_reserve_size(VIDEO_BAND_BYTES, 4);
+}
+
+bool video_player_init(video_player_t *p, const void *data, int x, int y,
+                       bool loop) {
+  const video_t *v = video_map(data);
+  if (v == NULL || v->format != display_get_wire_format() || x < 0 ||
+      y < 0 || x + v->width > display_get_width() ||
+      y + v->height > display_get_height() ||
+      packed_bytes(v->format, v->width) > VIDEO_BAND_BYTES)
+    return false;
+
+  for (int i = 0; i < 2; i++) {
+    p->band[i] = (uint8_t *)arena_alloc(ARENA_TAG_APP, VIDEO_BAND_BYTES, 4);
+    if (!p->band[i])
+      return false;
+  }
+  p->video = v;
+  p->frame = first_frame(v);
+  p->index = 0;
+  p->x = (uint16_t)x;
+  p->y = (uint16_t)y;
+  p->loop = loop;
+  p->started = false;
+  p->due_us = 0;
+  p->ticket = 0;
+  p->stats = (video_stats_t){0};
+  return true;
+}
+
+// --- Core 1: Decode + Send ---
+static void video_frame_task(void *arg) {
+  video_player_t *p = (video_player_t *)arg;
+  const video_t *v = p->video;
+  const video_frame_t *f = p->frame;
+  const video_run_t *runs = (const video_run_t *)(f + 1);
+  cimage_decoder_t *d = &p->decoder;
+  uint32_t t0 = time_us_32();
+  uint32_t sent = 0;
+
+  cimage_decoder_start(d, v->format, runs + f->run_count, f->data_bytes);
+  uint32_t b = 0;
+  for (uint32_t i = 0; i < f->run_count; i++) {
+    const video_run_t *r = &runs[i];
+    uint32_t x0 = r->bx * v->block, y0 = r->by * v->block;
+    if (x0 >= v->width || y0 >= v->height)
+      break; // Malformed: the op stream no longer lines up
+    uint32_t w = r->blocks * v->block, h = v->block;
+    if (w > v->width - x0)
+      w = v->width - x0;
+    if (h > v->height - y0)
+      h = v->height - y0;
+    uint32_t rows = VIDEO_BAND_BYTES / packed_bytes(v->format, w);
+
+    for (uint32_t row = 0; row < h; row += rows, b ^= 1) {
+      uint32_t n = (h - row < rows ? h - row : rows) * w;
+      // Decode while the other band is on its way out
+      cimage_decode(d, p->band[b], 0, n);
+      if (row == 0) {
+        // The previous window must drain before re-windowing
+        display_end_bulk();
+        display_set_window(p->x + x0, p->y + y0, p->x + x0 + w - 1,
+                           p->y + y0 + h - 1);
+        display_start_bulk();
+      } else {
+        display_wait_ready();
+      }
+      display_send_buffer(p->band[b], packed_bytes(v->format, n));
+      sent += packed_bytes(v->format, n);
+    }
+  }
+  display_end_bulk();
+
+  p->stats.windows += f->run_count;
+  p->stats.pixel_bytes += sent;
+  p->stats.busy_us += time_us_32() - t0;
+}
+
+// --- Pacing (Core 0) ---
+static bool collect(video_player_t *p) {
+  if (p->ticket == 0)
+    return true;
+  if (!render_service_job_done(p->ticket))
+    return false;
+  p->ticket = 0;
+  p->frame = next_frame(p->frame);
+  p->index++;
+  p->stats.frames++;
+  return true;
+}
+
+bool video_player_update(video_player_t *p) {
+  if (!collect(p))
+    return true;
+
+  if (p->index == p->video->frame_count) {
+    if (!p->loop)
+      return false;
+    p->frame = first_frame(p->video);
+    p->index = 0;
+  }
+
+  uint32_t now = time_us_32();
+  if (!p->started) {
+    p->due_us = now;
+    p->started = true;
+  }
+  int32_t behind = (int32_t)(now - p->due_us);
+  if (behind < 0)
+    return true;
+  if (behind > (int32_t)p->video->frame_us) {
+    // Nothing can be dropped: restart the schedule from this frame
+    p->stats.late++;
+    p->due_us = now;
+  }
+  p->due_us += p->video->frame_us;
+
+  render_job_t job = {.type = RENDER_CMD_CALLBACK,
+                      .callback = video_frame_task,
+                      .callback_arg = p};
+  p->ticket = render_service_submit(&job);
+  return true;
+}
+
+void video_player_wait(video_player_t *p) {
+  if (p->ticket)
+    render_service_wait_job(p->ticket);
+  collect(p);
+}
+
+void video_player_rewind(video_player_t *p) {
+  video_player_wait(p);
+  p->frame = first_frame(p->video);
+  p->index = 0;
+  p->started = false;
+}
+
+void video_play(video_player_t *p) {
+  while (video_player_update(p)) {
+    if (p->ticket) {
+      render_service_wait_job(p->ticket);
+      continue;
+    }
+    int32_t wait = (int32_t)(p->due_us - time_us_32());
+    if (wait > 0) {
+      uint32_t start = system_idle_begin();
+      sleep_us(wait);
+      system_idle_end(start);
+    }
+  }
+}
@@ -0,0 +1,106 @@
+#ifndef VIDEO_H
+#define VIDEO_H
+
+#include "cimage.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Video Playback
+ * Block-delta clips from tools/video_pack.py: the picture is split into
+ * square blocks and each frame only carries the blocks that changed since
+ * the one before, grouped into runs of adjacent blocks along a block row.
+ * Frame 0 carries every block. A run is one panel window; its pixels are
+ * cimage ops (cimage.h) in row-major order inside the window, one op
+ * stream per frame.
+ *
+ * The player decodes and sends a frame as a single Core 1 job: each run is
+ * decoded into two line bands that alternate with the panel DMA, and the
+ * panel itself holds the previous frame, so no framebuffer is involved.
+ * Frames start on the clip's own period. A late frame is still sent (each
+ * one builds on the last) and the schedule restarts from it.
+ *
+ * The player owns the panel while it plays: run it before engine_run (boot
+ * animations) or between presents, then framebuffer_invalidate().
+ */
+
+#define VIDEO_MAGIC 0x3156424Du // "MBV1"
+
+// Bytes per line band (two are reserved); a band holds at least one row
+#ifndef VIDEO_BAND_BYTES
+#define VIDEO_BAND_BYTES 4096
+#endif
+
+typedef struct {
+  uint32_t magic;
+  uint8_t format; // Wire format: PIXEL_FORMAT_RGB565 or _RGB444
+  uint8_t block;  // Block edge in pixels (even)
+  uint16_t width;
+  uint16_t height;
+  uint16_t frame_count;
+  uint32_t frame_us;   // Source frame period
+  uint32_t data_bytes; // Frames following the header
+} video_t;
+
+// Frame header, followed by its runs, then its op stream padded to 4 bytes
+typedef struct {
+  uint16_t run_count;
+  uint16_t reserved;
+  uint32_t data_bytes; // Op stream
+} video_frame_t;
+
+typedef struct {
+  uint8_t bx, by;  // First block
+  uint8_t blocks;  // Blocks to the right (the run's window width)
+  uint8_t reserved;
+} video_run_t;
+
+typedef struct {
+  uint32_t frames;      // Frames sent
+  uint32_t late;        // Frames started more than a period behind schedule
+  uint32_t windows;     // Runs sent
+  uint32_t pixel_bytes; // Pixel data sent (wire bytes)
+  uint32_t busy_us;     // Core 1 decode + send time
+} video_stats_t;
+
+typedef struct {
+  const video_t *video;
+  const video_frame_t *frame; // Next frame to send
+  uint16_t index;             // Its number
+  uint16_t x, y;              // Panel position of the clip
+  bool loop;
+  bool started;
+  uint32_t due_us;  // Start time of the next frame
+  uint32_t ticket;  // Core 1 job of the frame in flight (0: none)
+  uint8_t *band[2];
+  cimage_decoder_t decoder; // Core 1's, kept here to stay off its stack
+  video_stats_t stats;
+} video_player_t;
+
+// Validate a clip (4-byte aligned) and return it; NULL if malformed
+const video_t *video_map(const void *data);
+
+// Reserve this in engine_config_t.app_bytes per player
+uint32_t video_player_get_arena_size(void);
+
+// Prepare `data` for playback at (x, y) on the panel. false if the clip is
+// malformed, not in the wire format, off screen, wider than a band, or the
+// arena is short.
+bool video_player_init(video_player_t *p, const void *data, int x, int y,
+                       bool loop);
+
+// Pacing step for a custom loop (call often): collects the frame in flight
+// and starts the next one on Core 1 once it is due. false when a clip that
+// does not loop has been sent.
+bool video_player_update(video_player_t *p);
+
+// Wait for the frame in flight
+void video_player_wait(video_player_t *p);
+
+// Back to frame 0 (waits for the frame in flight)
+void video_player_rewind(video_player_t *p);
+
+// Play to the end, sleeping between frames (never returns when looping)
+void video_play(video_player_t *p);
+
+#endif
@@ -0,0 +1,127 @@
+#include "arena.h"
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Heap bounds from the Pico SDK linker script (sbrk grows end -> StackLimit)
+extern char end;
+extern char __StackLimit;
+
+static const char *tag_names[ARENA_TAG_COUNT] = {
+    "display", "framebuffer", "present", "scratch", "app"};
+
+static uint8_t *arena_base = NULL;
+static uint32_t arena_size = 0;
+static uint32_t arena_offset = 0;
+static uint32_t tag_bytes[ARENA_TAG_COUNT];
+
+static uint8_t *frame_base = NULL;
+static uint32_t frame_size = 0;
+static uint32_t frame_offset = 0;
+static uint32_t frame_peak = 0;
+
+static uint32_t align_up(uint32_t value, uint32_t align) {
+  return (value + align - 1) & ~(align - 1);
+}
+
+uint32_t arena_get_heap_free_bytes(void) {
+  struct mallinfo m = mallinfo();
+  uint32_t heap_total = (uint32_t)(&__StackLimit - &end);
+  // Never-claimed sbrk space plus free blocks inside the claimed region
+  return heap_total - m.arena + m.fordblks;
+}
+
+bool arena_init(uint32_t size_bytes) {
+  if (arena_base)
+    return true;
+
+  size_bytes = align_up(size_bytes, 4);
+  arena_base = (uint8_t *)malloc(size_bytes);
+  if (arena_base == NULL) {
+    printf("ARENA: Cannot reserve %lu bytes (%lu bytes of heap free)\n",
+           (unsigned long)size_bytes,
+           (unsigned long)arena_get_heap_free_bytes());
+    return false;
+  }
+
+  arena_size = size_bytes;
+  arena_offset = 0;
+  for (int i = 0; i < ARENA_TAG_COUNT; i++)
+    tag_bytes[i] = 0;
+  return true;
+}
+
+bool arena_is_initialized(void) { return arena_base != NULL; }
+
+void *arena_alloc(arena_tag_t tag, uint32_t size, uint32_t align) {
+  if (align < 4)
+    align = 4;
+
+  if (arena_base == NULL) {
+    printf("ARENA: %s alloc of %lu bytes before arena_init\n",
+           arena_get_tag_name(tag), (unsigned long)size);
+    return NULL;
+  }
+
+  // Align the absolute address, not just the offset (malloc gives 8 bytes)
+  uint32_t base_addr = (uint32_t)(uintptr_t)arena_base;
+  uint32_t start = align_up(base_addr + arena_offset, align) - base_addr;
+  uint32_t end_offset = start + align_up(size, 4);
+
+  if (end_offset > arena_size) {
+    printf("ARENA: %s alloc of %lu bytes failed (%lu of %lu bytes free)\n",
+           arena_get_tag_name(tag), (unsigned long)size,
+           (unsigned long)(arena_size - arena_offset),
+           (unsigned long)arena_size);
+    return NULL;
+  }
+
+  tag_bytes[tag] += end_offset - arena_offset;
+  arena_offset = end_offset;
+  return arena_base + start;
+}
+
+bool arena_frame_init(uint32_t size_bytes) {
+  if (size_bytes == 0)
+    return true;
+  frame_base = (uint8_t *)arena_alloc(ARENA_TAG_SCRATCH, size_bytes, 8);
+  if (frame_base == NULL)
+    return false;
+  frame_size = align_up(size_bytes, 4);
+  frame_offset = 0;
+  frame_peak = 0;
+  return true;
+}
+
+void *arena_frame_alloc(uint32_t size, uint32_t align) {
+  if (align < 4)
+    align = 4;
+  if (frame_base == NULL)
+    return NULL;
+
+  uint32_t base_addr = (uint32_t)(uintptr_t)frame_base;
+  uint32_t start = align_up(base_addr + frame_offset, align) - base_addr;
+  uint32_t end_offset = start + align_up(size, 4);
+  if (end_offset > frame_size)
+    return NULL;
+
+  frame_offset = end_offset;
+  if (frame_offset > frame_peak)
+    frame_peak = frame_offset;
+  return frame_base + start;
+}
+
+void arena_frame_reset(void) { frame_offset = 0; }
+
+uint32_t arena_get_total_bytes(void) { return arena_size; }
+uint32_t arena_get_used_bytes(void) { return arena_offset; }
+
+uint32_t arena_get_tag_bytes(arena_tag_t tag) {
+  return (tag < ARENA_TAG_COUNT) ? tag_bytes[tag] : 0;
+}
+
+uint32_t arena_get_frame_peak_bytes(void) { return frame_peak; }
+
+const char *arena_get_tag_name(arena_tag_t tag) {
+  return (tag < ARENA_TAG_COUNT) ? tag_names[tag] : "unknown";
+}
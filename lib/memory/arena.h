@@ -0,0 +1,55 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Engine Arena
+ * One heap block reserved at engine init. Subsystems carve aligned regions
+ * out of it instead of calling malloc, so an oversized configuration fails
+ * once, at init, with exact byte counts.
+ */
+
+// Owners of arena regions (used for the per-subsystem usage report)
+typedef enum {
+  ARENA_TAG_DISPLAY = 0, // Transport objects and state
+  ARENA_TAG_FRAMEBUFFER, // Surface pixel storage
+  ARENA_TAG_PRESENT,     // Line buffers and present-path state
+  ARENA_TAG_SCRATCH,     // Per-frame bump allocator for apps
+  ARENA_TAG_APP,         // Engine objects owned by the app (text mode, ...)
+  ARENA_TAG_COUNT
+} arena_tag_t;
+
+// Alignment suitable for 32-bit DMA transfers
+#define ARENA_ALIGN_DMA 4
+
+// Bytes an allocation of `size` at `align` may consume (incl. padding)
+static inline uint32_t arena_reserve_size(uint32_t size, uint32_t align) {
+  if (align < 4)
+    align = 4;
+  return ((size + 3u) & ~3u) + (align - 4u);
+}
+
+// Reserve the arena. Prints the shortfall and returns false if the heap
+// cannot hold `size_bytes`.
+bool arena_init(uint32_t size_bytes);
+bool arena_is_initialized(void);
+
+// Aligned sub-allocation. Returns NULL (and prints the numbers) when full.
+void *arena_alloc(arena_tag_t tag, uint32_t size, uint32_t align);
+
+// Per-frame scratch: a bump allocator reset once per frame by the engine
+bool arena_frame_init(uint32_t size_bytes);
+void *arena_frame_alloc(uint32_t size, uint32_t align);
+void arena_frame_reset(void);
+
+// Usage report
+uint32_t arena_get_total_bytes(void);
+uint32_t arena_get_used_bytes(void);
+uint32_t arena_get_tag_bytes(arena_tag_t tag);
+uint32_t arena_get_frame_peak_bytes(void);
+uint32_t arena_get_heap_free_bytes(void);
+const char *arena_get_tag_name(arena_tag_t tag);
+
+#endif
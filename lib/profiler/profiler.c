@@ -1,6 +1,8 @@
 #include "profiler.h"
+#include "compositor.h"
 #include "font.h"
 #include "framebuffer.h"
+#include "occlusion.h"
 #include "render_service.h"
 #include <malloc.h>
 #include <string.h>
@@ -17,6 +19,7 @@ extern char __flash_binary_end;
 static system_stats_t current_stats;
 static uint32_t frame_accumulator = 0;
 static uint32_t time_accumulator = 0;
+static bool hud_stale = true; // Retained HUD strip needs a redraw
 
 #include "system_config.h"
 
@@ -30,12 +33,13 @@ void profiler_init(void) {
   if (surf) {
     current_stats.width = surf->width;
     current_stats.height = surf->height;
+    bool packed = display_get_rgb444_packing(); // 12-bit wire
     if (surf->format == PIXEL_FORMAT_RGB565)
-      current_stats.pixel_format = "RGB565";
+      current_stats.pixel_format = packed ? "RGB565>444" : "RGB565";
     else if (surf->format == PIXEL_FORMAT_RGB444)
       current_stats.pixel_format = "RGB444";
     else
-      current_stats.pixel_format = "RGB332";
+      current_stats.pixel_format = packed ? "RGB332>444" : "RGB332";
   }
 
   // Calculate static flash usage
@@ -52,6 +56,7 @@ void profiler_update(uint32_t frame_time_us) {
   if (time_accumulator >= 500000) {
     // --- FPS ---
     current_stats.fps = (frame_accumulator * 1000000) / time_accumulator;
+    hud_stale = true;
 
     // --- System Info ---
     current_stats.cpu_hz = system_get_cpu_hz();
@@ -62,26 +67,35 @@ void profiler_update(uint32_t frame_time_us) {
     if (surf) {
       current_stats.width = surf->width;
       current_stats.height = surf->height;
+      bool packed = display_get_rgb444_packing(); // 12-bit wire
       if (surf->format == PIXEL_FORMAT_RGB565)
-        current_stats.pixel_format = "RGB565";
+        current_stats.pixel_format = packed ? "RGB565>444" : "RGB565";
       else if (surf->format == PIXEL_FORMAT_RGB444)
         current_stats.pixel_format = "RGB444";
       else
-        current_stats.pixel_format = "RGB332";
+        current_stats.pixel_format = packed ? "RGB332>444" : "RGB332";
     }
 
     // --- CPU 0 Usage ---
-    uint32_t wait_us = framebuffer_get_last_wait_time();
-    float active_ratio = 1.0f;
-    if (frame_time_us > 0 && wait_us < frame_time_us) {
-      active_ratio = (float)(frame_time_us - wait_us) / (float)frame_time_us;
-    } else if (wait_us >= frame_time_us) {
-      active_ratio = 0.0f; // All wait
-    }
+    // Waits sleep in WFE and report their time, so whatever is left of the
+    // window is real work
+    uint32_t idle0 = system_get_idle_us(0);
+    float active_ratio = 0.0f;
+    if (idle0 < time_accumulator)
+      active_ratio = (float)(time_accumulator - idle0) / (float)time_accumulator;
     current_stats.cpu0_usage_percent = active_ratio * 100.0f;
 
+    // --- Present Queue ---
+    present_queue_stats_t q;
+    framebuffer_get_queue_stats(&q);
+    current_stats.present_queue_depth = q.max_depth;
+    current_stats.present_drops = q.drops;
+    current_stats.present_latency_us = q.avg_latency_us;
+
     // --- CPU 1 Usage ---
     uint32_t c1_busy = render_service_get_busy_us();
+    uint32_t idle1 = system_get_idle_us(1); // Slept inside present jobs
+    c1_busy = (idle1 < c1_busy) ? c1_busy - idle1 : 0;
     float c1_ratio = (float)c1_busy / (float)time_accumulator;
     if (c1_ratio > 1.0f)
       c1_ratio = 1.0f;
@@ -89,6 +103,7 @@ void profiler_update(uint32_t frame_time_us) {
 
     // Reset Logic
     framebuffer_reset_profile_stats();
+    system_reset_idle_stats();
     frame_accumulator = 0;
     time_accumulator = 0;
 
@@ -97,15 +112,40 @@ void profiler_update(uint32_t frame_time_us) {
     current_stats.ram_used_bytes = m.uordblks; // Used heap
 
     current_stats.buffer_count = framebuffer_get_buffer_count();
+
+    // --- Arena Usage ---
+    current_stats.arena_total_bytes = arena_get_total_bytes();
+    current_stats.arena_used_bytes = arena_get_used_bytes();
+    for (int i = 0; i < ARENA_TAG_COUNT; i++)
+      current_stats.arena_tag_bytes[i] = arena_get_tag_bytes((arena_tag_t)i);
+    current_stats.scratch_peak_bytes = arena_get_frame_peak_bytes();
+
+    // --- Present Bandwidth ---
+    current_stats.present_bands_sent = framebuffer_get_bands_sent();
+    current_stats.present_bands_total = framebuffer_get_band_count();
+    occlusion_get_stats(&current_stats.fill_submitted_px,
+                        &current_stats.fill_written_px);
   }
 }
 
 system_stats_t profiler_get_stats(void) { return current_stats; }
 
 void profiler_draw(void) {
-  surface_t *surf = framebuffer_get_surface();
+  surface_t *surf = compositor_get_layer(COMPOSITOR_LAYER_HUD);
+  if (surf) {
+    // Retained HUD: redraw only when the stats changed. Core 1 may be
+    // streaming the strip, so let the present finish first.
+    if (!hud_stale)
+      return;
+    framebuffer_wait_last_swap();
+    compositor_mark_hud_dirty();
+  } else {
+    surf = framebuffer_get_surface();
+  }
+  hud_stale = false;
+
   // Draw Background Bar (Top of screen, 24px height)
-  draw_rect(surf, 0, 0, 320, 24, 0x0000);
+  draw_rect(surf, 0, 0, surf->width, PROFILER_HUD_ROWS, 0x0000);
 
   int y1 = 2;
   int y2 = 13;
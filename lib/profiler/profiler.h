@@ -1,6 +1,7 @@
 #ifndef PROFILER_H
 #define PROFILER_H
 
+#include "arena.h"
 #include <stdbool.h>
 #include <stdint.h>
 
@@ -18,6 +19,17 @@ typedef struct {
   uint8_t buffer_count;
   uint16_t width;
   uint16_t height;
+  uint32_t arena_total_bytes;
+  uint32_t arena_used_bytes;
+  uint32_t arena_tag_bytes[ARENA_TAG_COUNT]; // Per-subsystem breakdown
+  uint32_t scratch_peak_bytes;
+  uint16_t present_bands_sent;  // Row-hash: bands on the wire last present
+  uint16_t present_bands_total;
+  uint8_t present_queue_depth;  // Triple-buffer queue (max over window)
+  uint32_t present_drops;       // Mailbox drops over the window
+  uint32_t present_latency_us;  // Avg submit -> scanout complete
+  uint32_t fill_submitted_px;   // Overdraw cull: pixels drawn by the app
+  uint32_t fill_written_px;     // ... and pixels actually written
 } system_stats_t;
 
 // Initialize the profiler
@@ -29,7 +41,11 @@ void profiler_update(uint32_t frame_time_us);
 // Get the latest snapshot
 system_stats_t profiler_get_stats(void);
 
-// Draw the stats overlay
+// Rows covered by the stats overlay (size of the compositor HUD strip)
+#define PROFILER_HUD_ROWS 24
+
+// Draw the stats overlay: into the compositor's HUD layer when one exists
+// (only after the stats change), otherwise into the back buffer
 void profiler_draw(void);
 
 #endif
@@ -3,6 +3,7 @@
 #include "hardware/vreg.h"
 
 static uint32_t actual_spi_hz = 0;
+static volatile uint32_t idle_us[2] = {0, 0};
 
 const system_config_t system_profiles[] = {
     PERFORMANCE_STABLE, PERFORMANCE_BALANCED, PERFORMANCE_TURBO,
@@ -33,3 +34,16 @@ uint32_t system_get_cpu_hz(void) { return clock_get_hz(clk_sys); }
 uint32_t system_get_spi_hz(void) { return actual_spi_hz; }
 
 void system_set_actual_spi_hz(uint32_t hz) { actual_spi_hz = hz; }
+
+uint32_t system_idle_begin(void) { return time_us_32(); }
+
+void system_idle_end(uint32_t start_us) {
+  idle_us[get_core_num()] += time_us_32() - start_us;
+}
+
+uint32_t system_get_idle_us(uint core) { return idle_us[core & 1]; }
+
+void system_reset_idle_stats(void) {
+  idle_us[0] = 0;
+  idle_us[1] = 0;
+}
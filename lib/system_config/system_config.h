@@ -41,4 +41,13 @@ uint32_t system_get_spi_hz(void);
 // Set actual SPI speed (called by display driver)
 void system_set_actual_spi_hz(uint32_t hz);
 
+// Idle accounting: waits that park a core (WFE on a DMA or the other core)
+// bracket the sleep so the profiler can report the rest as real work.
+// Returns the start timestamp to pass to system_idle_end.
+uint32_t system_idle_begin(void);
+void system_idle_end(uint32_t start_us);
+// Microseconds core 0 / 1 has been idle since the last reset
+uint32_t system_get_idle_us(uint core);
+void system_reset_idle_stats(void);
+
 #endif
@@ -0,0 +1,296 @@
+#!/usr/bin/env python3
+"""Pack PNG images into MiniBoy assets (lib/graphics/asset.h).
+
+The output is the exact byte layout the surfaces use, so drawing on the
+device is a copy with no per-pixel conversion:
+
+  asset_pack.py logo.png -f rgb444 -o logo.c
+  asset_pack.py ships.png -f rgb565 --frame 16x16 -o ships.c
+  asset_pack.py font.png -f rgb332 --frame 8x8 --font 32 -o font8.c
+  asset_pack.py tiles.png -f indexed8 --layout column -o tiles.bin
+
+A .c output defines `const uint8_t <name>[]` (4-byte aligned, linked into
+flash); pass it to asset_map(). Any other extension writes the raw blob,
+e.g. to be flashed at an offset and opened with asset_map_flash().
+
+Pixels with alpha below 128 become the colour key (ASSET_FLAG_COLOR_KEY):
+--key picks it, otherwise an unused colour is chosen. Only the standard
+library is needed (PNG decoding is built in; no interlaced PNGs).
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+import zlib
+
+ASSET_MAGIC = 0x3141424D
+ASSET_LINE_ALIGN = 4
+HEADER = struct.Struct("<IBBBBHHHHHHIIII")
+
+FORMATS = {"rgb565": 0x55, "rgb444": 0x53, "rgb332": 0x52, "indexed8": 0x08}
+LAYOUTS = {"row": 0, "column": 1}
+TYPE_IMAGE, TYPE_SPRITES, TYPE_FONT = 0, 1, 2
+FLAG_COLOR_KEY = 0x01
+
+
+# --- PNG ---
+def read_png(path):
+    """Return (width, height, rows of (r, g, b, a) tuples)."""
+    with open(path, "rb") as f:
+        data = f.read()
+    if data[:8] != b"\x89PNG\r\n\x1a\n":
+        raise ValueError(f"{path}: not a PNG")
+
+    pos, idat, plte, trns = 8, [], None, None
+    while pos < len(data):
+        (n,) = struct.unpack(">I", data[pos:pos + 4])
+        tag, body = data[pos + 4:pos + 8], data[pos + 8:pos + 8 + n]
+        pos += 12 + n
+        if tag == b"IHDR":
+            w, h, depth, ctype, _, _, interlace = struct.unpack(">IIBBBBB",
+                                                                body)
+        elif tag == b"PLTE":
+            plte = [tuple(body[i:i + 3]) for i in range(0, len(body), 3)]
+        elif tag == b"tRNS":
+            trns = body
+        elif tag == b"IDAT":
+            idat.append(body)
+        elif tag == b"IEND":
+            break
+    if interlace:
+        raise ValueError(f"{path}: interlaced PNGs are not supported")
+
+    channels = {0: 1, 2: 3, 3: 1, 4: 2, 6: 4}[ctype]
+    bits = channels * depth
+    stride = (w * bits + 7) // 8
+    bpp = max(1, bits // 8)
+    raw = zlib.decompress(b"".join(idat))
+
+    rows, prev = [], bytearray(stride)
+    for y in range(h):
+        ftype = raw[y * (stride + 1)]
+        line = bytearray(raw[y * (stride + 1) + 1:(y + 1) * (stride + 1)])
+        for i in range(stride):
+            a = line[i - bpp] if i >= bpp else 0
+            b = prev[i]
+            c = prev[i - bpp] if i >= bpp else 0
+            if ftype == 1:
+                line[i] = (line[i] + a) & 0xFF
+            elif ftype == 2:
+                line[i] = (line[i] + b) & 0xFF
+            elif ftype == 3:
+                line[i] = (line[i] + ((a + b) >> 1)) & 0xFF
+            elif ftype == 4:
+                p = a + b - c
+                pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+                pred = a if pa <= pb and pa <= pc else (b if pb <= pc else c)
+                line[i] = (line[i] + pred) & 0xFF
+        prev = line
+        rows.append(decode_row(line, w, depth, ctype, plte, trns))
+    return w, h, rows
+
+
+def decode_row(line, w, depth, ctype, plte, trns):
+    if depth < 8:  # Grey or palette, packed MSB first
+        per = 8 // depth
+        samples = [(line[i // per] >> (8 - depth * (i % per + 1))) &
+                   ((1 << depth) - 1) for i in range(w)]
+    elif depth == 16:  # Keep the high byte
+        samples = list(line[0::2])
+    else:
+        samples = list(line)
+
+    if ctype == 3:
+        alpha = list(trns or b"")
+        return [plte[s] + (alpha[s] if s < len(alpha) else 255,)
+                for s in samples]
+    if ctype == 0:
+        scale = 255 // ((1 << depth) - 1) if depth < 8 else 1
+        return [(s * scale,) * 3 + (255,) for s in samples]
+    if ctype == 4:
+        return [(samples[2 * i],) * 3 + (samples[2 * i + 1],)
+                for i in range(w)]
+    if ctype == 2:
+        return [tuple(samples[3 * i:3 * i + 3]) + (255,) for i in range(w)]
+    return [tuple(samples[4 * i:4 * i + 4]) for i in range(w)]
+
+
+# --- Pixel encodings (matching surface_t) ---
+def q(v, bits):
+    return (v * ((1 << bits) - 1) + 127) // 255
+
+
+def to565(r, g, b):
+    return (q(r, 5) << 11) | (q(g, 6) << 5) | q(b, 5)
+
+
+def to444(r, g, b):
+    return (q(r, 4) << 8) | (q(g, 4) << 4) | q(b, 4)
+
+
+def to332(r, g, b):
+    return (q(r, 3) << 5) | (q(g, 3) << 2) | q(b, 2)
+
+
+def encode_line(values, fmt):
+    """Packed bytes of one line of already-encoded pixel values."""
+    if fmt == "rgb565":
+        return b"".join(struct.pack("<H", v) for v in values)
+    if fmt == "rgb444":  # 2 pixels in 3 bytes: RG BR GB
+        out = bytearray()
+        for i in range(0, len(values), 2):
+            v0 = values[i]
+            v1 = values[i + 1] if i + 1 < len(values) else 0
+            out += bytes([v0 >> 4, ((v0 & 0xF) << 4) | (v1 >> 8), v1 & 0xFF])
+        return bytes(out[:(len(values) * 3 + 1) // 2])
+    return bytes(values)
+
+
+def pick_key(used, fmt):
+    encode = {"rgb565": to565, "rgb444": to444, "rgb332": to332}[fmt]
+    for rgb in ((255, 0, 255), (0, 255, 255), (255, 255, 0)):
+        if encode(*rgb) not in used:
+            return encode(*rgb)
+    limit = {"rgb565": 1 << 16, "rgb444": 1 << 12, "rgb332": 1 << 8}[fmt]
+    for v in range(limit):
+        if v not in used:
+            return v
+    raise ValueError("every colour is used; no colour key is left")
+
+
+# --- Asset ---
+def pack(rows, width, height, fmt, layout, frame_w, frame_h, asset_type,
+         first_char, key_rgb):
+    if width % frame_w or height % frame_h:
+        raise ValueError(f"{width}x{height} is not a whole number of "
+                         f"{frame_w}x{frame_h} frames")
+
+    # Frames left to right, top to bottom
+    frames = []
+    for fy in range(0, height, frame_h):
+        for fx in range(0, width, frame_w):
+            frames.append([row[fx:fx + frame_w]
+                           for row in rows[fy:fy + frame_h]])
+
+    transparent = any(p[3] < 128 for f in frames for row in f for p in row)
+    use_key = transparent or key_rgb is not None
+    palette = []
+
+    if fmt == "indexed8":
+        colors = sorted({to565(*p[:3]) for f in frames for row in f
+                         for p in row if p[3] >= 128})
+        palette = colors + ([0] if use_key else [])
+        if len(palette) > 256:
+            raise ValueError(f"{len(colors)} colours; indexed8 takes at "
+                             "most 256 (reduce the palette first)")
+        index = {c: i for i, c in enumerate(colors)}
+        key = len(colors) if use_key else 0
+
+        def encode(p):
+            return key if p[3] < 128 else index[to565(*p[:3])]
+    else:
+        enc = {"rgb565": to565, "rgb444": to444, "rgb332": to332}[fmt]
+        if key_rgb is not None:
+            key = enc(*key_rgb)
+        elif use_key:
+            key = pick_key({enc(*p[:3]) for f in frames for row in f
+                            for p in row if p[3] >= 128}, fmt)
+        else:
+            key = 0
+
+        def encode(p):
+            return key if p[3] < 128 else enc(*p[:3])
+
+    # Stored lines: rows, or columns when column-major
+    line_px = frame_h if layout == "column" else frame_w
+    lines = frame_w if layout == "column" else frame_h
+    line_len = len(encode_line([0] * line_px, fmt))
+    stride = -(-line_len // ASSET_LINE_ALIGN) * ASSET_LINE_ALIGN
+
+    pixels = bytearray()
+    for f in frames:
+        for l in range(lines):
+            px = [f[i][l] for i in range(frame_h)] if layout == "column" \
+                else f[l]
+            line = encode_line([encode(p) for p in px], fmt)
+            pixels += line + bytes(stride - len(line))
+
+    pal = b"".join(struct.pack("<H", c) for c in palette)
+    pal += bytes(-len(pal) % 4)
+    palette_offset = HEADER.size if palette else 0
+    pixels_offset = HEADER.size + len(pal)
+    header = HEADER.pack(ASSET_MAGIC, asset_type, FORMATS[fmt],
+                         LAYOUTS[layout], FLAG_COLOR_KEY if use_key else 0,
+                         frame_w, frame_h, len(frames), first_char, stride,
+                         len(palette), key, stride * lines, palette_offset,
+                         pixels_offset)
+    return header + pal + bytes(pixels)
+
+
+def write_c(path, name, blob, source):
+    with open(path, "w") as f:
+        f.write(f"// Generated by tools/{os.path.basename(sys.argv[0])} from "
+                f"{os.path.basename(source)}; do not edit\n")
+        f.write("#include <stdint.h>\n\n")
+        f.write(f"const uint8_t {name}[{len(blob)}] "
+                "__attribute__((aligned(4))) = {\n")
+        for i in range(0, len(blob), 16):
+            f.write("    " + ", ".join(f"0x{b:02X}" for b in
+                                       blob[i:i + 16]) + ",\n")
+        f.write("};\n")
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("input", help="PNG file")
+    ap.add_argument("-o", "--output", required=True,
+                    help=".c for a C array, anything else for a raw blob")
+    ap.add_argument("-f", "--format", choices=FORMATS, default="rgb565")
+    ap.add_argument("--layout", choices=LAYOUTS, default="row",
+                    help="match the target surface layout")
+    ap.add_argument("--frame", metavar="WxH",
+                    help="split into equal frames (sprite sheet or font)")
+    ap.add_argument("--font", metavar="FIRST", type=int,
+                    help="font: frame 0 is character FIRST (needs --frame)")
+    ap.add_argument("--key", metavar="RRGGBB",
+                    help="colour key for transparent pixels")
+    ap.add_argument("--name", help="C symbol (default: file name)")
+    args = ap.parse_args()
+
+    width, height, rows = read_png(args.input)
+    frame_w, frame_h = width, height
+    asset_type = TYPE_IMAGE
+    if args.frame:
+        frame_w, frame_h = (int(v) for v in args.frame.lower().split("x"))
+        asset_type = TYPE_SPRITES
+    if args.font is not None:
+        if not args.frame:
+            ap.error("--font needs --frame")
+        asset_type = TYPE_FONT
+    key = None
+    if args.key:
+        k = int(args.key, 16)
+        key = (k >> 16, (k >> 8) & 0xFF, k & 0xFF)
+
+    try:
+        blob = pack(rows, width, height, args.format, args.layout, frame_w,
+                    frame_h, asset_type, args.font or 0, key)
+    except ValueError as e:
+        sys.exit(f"{args.input}: {e}")
+
+    if args.output.endswith(".c"):
+        name = args.name or re.sub(r"\W", "_", os.path.splitext(
+            os.path.basename(args.output))[0])
+        write_c(args.output, name, blob, args.input)
+    else:
+        with open(args.output, "wb") as f:
+            f.write(blob)
+    frames = (width // frame_w) * (height // frame_h)
+    print(f"{args.output}: {len(blob)} bytes, {frames} frame(s) of "
+          f"{frame_w}x{frame_h} {args.format}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,199 @@
+#!/usr/bin/env python3
+"""Compress PNG images into MiniBoy cimages (lib/graphics/cimage.h).
+
+  cimage_pack.py title.png -f rgb565 -o title.c
+  cimage_pack.py level1.png -f rgb444 --layout column -o level1.bin
+
+Output is a 4-byte-aligned C array (.c) or a raw blob, like asset_pack.py.
+Transparent pixels are composited onto black. The op stream is the one
+cimage_encode() produces on the device for the same pixels.
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+from asset_pack import FORMATS, LAYOUTS, read_png, to332, to444, to565, \
+    write_c
+
+CIMAGE_MAGIC = 0x3151424D
+HEADER = struct.Struct("<IBBHHHI")
+
+OP_INDEX, OP_RUN, OP_RUN16 = 0x00, 0x40, 0x7F
+OP_DIFF, OP_LUMA, OP_RAW = 0x80, 0xC0, 0xE0
+RUN_MAX, RUN16_MAX = 63, 0xFFFF
+
+# (r_shift, g_shift, r_mask, g_mask, b_mask, r_scale, b_scale)
+CHANNELS = {
+    "rgb565": (11, 5, 0x1F, 0x3F, 0x1F, 1, 1),
+    "rgb444": (8, 4, 0x0F, 0x0F, 0x0F, 0, 0),
+    "rgb332": (5, 2, 0x07, 0x07, 0x03, 0, 1),
+}
+
+
+def hash6(v):
+    return ((v * 0x9E37) >> 10) & 63
+
+
+def wrap(delta, mask):
+    half = (mask + 1) >> 1
+    return ((delta + half) & mask) - half
+
+
+def encode(values, fmt):
+    """Op stream for pixel values in stored-line order."""
+    r_shift, g_shift, r_mask, g_mask, b_mask, r_scale, b_scale = \
+        CHANNELS[fmt]
+    out = bytearray()
+    table = [0] * 64
+    prev, run = 0, 0
+
+    def flush(run):
+        while run:
+            if run <= RUN_MAX:
+                out.append(OP_RUN | (run - 1))
+                return
+            k = min(run, RUN16_MAX)
+            out.extend((OP_RUN16, k & 0xFF, k >> 8))
+            run -= k
+
+    for v in values:
+        if v == prev:
+            run += 1
+            continue
+        flush(run)
+        run = 0
+
+        h = hash6(v)
+        if table[h] == v:
+            out.append(OP_INDEX | h)
+            prev = v
+            continue
+        table[h] = v
+
+        dr = wrap(((v >> r_shift) & r_mask) - ((prev >> r_shift) & r_mask),
+                  r_mask)
+        dg = wrap(((v >> g_shift) & g_mask) - ((prev >> g_shift) & g_mask),
+                  g_mask)
+        db = wrap((v & b_mask) - (prev & b_mask), b_mask)
+        lr, lb = dr - (dg >> r_scale), db - (dg >> b_scale)
+
+        if -2 <= dr <= 1 and -2 <= dg <= 1 and -2 <= db <= 1:
+            out.append(OP_DIFF | ((dr + 2) << 4) | ((dg + 2) << 2) |
+                       (db + 2))
+        elif -16 <= dg <= 15 and -8 <= lr <= 7 and -8 <= lb <= 7:
+            out.extend((OP_LUMA | (dg + 16), ((lr + 8) << 4) | (lb + 8)))
+        else:
+            out.append(OP_RAW)
+            out.append(v & 0xFF)
+            if fmt != "rgb332":
+                out.append(v >> 8)
+        prev = v
+    flush(run)
+    return bytes(out)
+
+
+def decode(data, count, fmt):
+    """First `count` values of an op stream, as cimage_decode() sees them."""
+    r_shift, g_shift, r_mask, g_mask, b_mask, r_scale, b_scale = \
+        CHANNELS[fmt]
+    out = []
+    table = [0] * 64
+    prev, i = 0, 0
+
+    def add(v, dr, dg, db):
+        r = ((v >> r_shift) + dr) & r_mask
+        g = ((v >> g_shift) + dg) & g_mask
+        return (r << r_shift) | (g << g_shift) | ((v + db) & b_mask)
+
+    while len(out) < count:
+        if i >= len(data):
+            raise ValueError(f"op stream ends after {len(out)} values")
+        op = data[i]
+        i += 1
+        if op < OP_RUN:
+            prev = table[op]
+            out.append(prev)
+            continue
+        if op < OP_DIFF:
+            if op == OP_RUN16:
+                n = data[i] | (data[i + 1] << 8)
+                i += 2
+            else:
+                n = (op & 0x3F) + 1
+            out.extend([prev] * n)
+            continue
+        if op < OP_LUMA:
+            v = add(prev, ((op >> 4) & 3) - 2, ((op >> 2) & 3) - 2,
+                    (op & 3) - 2)
+        elif op < OP_RAW:
+            dg = (op & 0x1F) - 16
+            rb = data[i]
+            i += 1
+            v = add(prev, (rb >> 4) - 8 + (dg >> r_scale), dg,
+                    (rb & 0x0F) - 8 + (dg >> b_scale))
+        elif op == OP_RAW:
+            v = data[i]
+            i += 1
+            if fmt != "rgb332":
+                v |= data[i] << 8
+                i += 1
+        else:
+            raise ValueError(f"reserved op {op:#04x}")
+        table[hash6(v)] = v
+        out.append(v)
+        prev = v
+    return out[:count]
+
+
+def pack(rows, width, height, fmt, layout):
+    enc = {"rgb565": to565, "rgb444": to444, "rgb332": to332}[fmt]
+
+    def value(p):
+        r, g, b, a = p
+        return enc(r * a // 255, g * a // 255, b * a // 255)
+
+    if layout == "column":
+        values = [value(rows[y][x]) for x in range(width)
+                  for y in range(height)]
+    else:
+        values = [value(p) for row in rows for p in row]
+    data = encode(values, fmt)
+    header = HEADER.pack(CIMAGE_MAGIC, FORMATS[fmt], LAYOUTS[layout], width,
+                         height, 0, len(data))
+    return header + data, len(values)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("input", help="PNG file")
+    ap.add_argument("-o", "--output", required=True,
+                    help=".c for a C array, anything else for a raw blob")
+    ap.add_argument("-f", "--format", choices=CHANNELS, default="rgb565")
+    ap.add_argument("--layout", choices=LAYOUTS, default="row",
+                    help="match the target surface layout")
+    ap.add_argument("--name", help="C symbol (default: file name)")
+    args = ap.parse_args()
+
+    width, height, rows = read_png(args.input)
+    if width > 0xFFFF or height > 0xFFFF:
+        sys.exit(f"{args.input}: too large")
+    blob, pixels = pack(rows, width, height, args.format, args.layout)
+
+    if args.output.endswith(".c"):
+        name = args.name or re.sub(r"\W", "_", os.path.splitext(
+            os.path.basename(args.output))[0])
+        write_c(args.output, name, blob, args.input)
+    else:
+        with open(args.output, "wb") as f:
+            f.write(blob)
+    raw = {"rgb565": pixels * 2, "rgb444": (pixels * 3 + 1) // 2,
+           "rgb332": pixels}[args.format]
+    print(f"{args.output}: {len(blob)} bytes ({raw} raw, "
+          f"{100 * len(blob) / raw:.1f}%)")
+
+
+if __name__ == "__main__":
+    main()
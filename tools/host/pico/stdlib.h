@@ -0,0 +1,15 @@
+#ifndef HOST_PICO_STDLIB_H
+#define HOST_PICO_STDLIB_H
+
+// The few Pico SDK names the video player and cimage decoder use, for the
+// host build in video_check.c (implemented there)
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef unsigned int uint;
+
+uint32_t time_us_32(void);
+void sleep_us(uint64_t us);
+
+#endif
@@ -0,0 +1,192 @@
+// Host build of the video player: plays a clip through the real
+// lib/graphics/video.c and cimage.c into an emulated panel and writes the
+// clip's area after every frame. video_pack.py --selftest builds it with
+// the host compiler and compares the pictures with the encoder's.
+//
+//   video_check clip.bin pictures.raw
+//
+// pictures.raw holds width * height little-endian uint16_t values per
+// frame. The panel side checks the wire protocol as it goes: windows only
+// change outside bulk transfers and stay inside the clip's rectangle,
+// pixels stay inside their window, every window is filled exactly, and
+// RGB444 sends are whole pixel pairs.
+#include "arena.h"
+#include "display_driver.h"
+#include "render_service.h"
+#include "system_config.h"
+#include "video.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define PANEL_WIDTH 320
+#define PANEL_HEIGHT 240
+// Clip position on the panel: off the origin to exercise the offsets,
+// unless the clip is full screen
+#define CLIP_X 3
+#define CLIP_Y 2
+
+static uint16_t panel[PANEL_HEIGHT][PANEL_WIDTH];
+static display_pixel_format_t wire_format;
+static uint16_t win_x0, win_y0, win_x1, win_y1;
+static uint32_t cur_x, cur_y;
+static bool window_open, bulk;
+static uint32_t clock_us;
+static int clip_x, clip_y, clip_w, clip_h;
+
+static void fail(const char *fmt, ...) {
+  va_list ap;
+  va_start(ap, fmt);
+  fprintf(stderr, "video_check: ");
+  vfprintf(stderr, fmt, ap);
+  fprintf(stderr, "\n");
+  va_end(ap);
+  exit(1);
+}
+
+// --- SDK / Engine Stand-Ins ---
+uint32_t time_us_32(void) { return ++clock_us; }
+void sleep_us(uint64_t us) { clock_us += (uint32_t)us; }
+uint32_t system_idle_begin(void) { return clock_us; }
+void system_idle_end(uint32_t start_us) { (void)start_us; }
+void occlusion_resolve(void) {}
+
+void *arena_alloc(arena_tag_t tag, uint32_t size, uint32_t align) {
+  (void)tag;
+  return aligned_alloc(align, (size + align - 1) / align * align);
+}
+
+// Jobs run inline, so every ticket is done when submit returns
+static uint32_t submitted;
+
+uint32_t render_service_submit(const render_job_t *job) {
+  job->callback(job->callback_arg);
+  return submitted++;
+}
+
+bool render_service_job_done(uint32_t ticket) { return ticket < submitted; }
+void render_service_wait_job(uint32_t ticket) { (void)ticket; }
+
+// --- Emulated Panel ---
+display_pixel_format_t display_get_wire_format(void) { return wire_format; }
+uint16_t display_get_width(void) { return PANEL_WIDTH; }
+uint16_t display_get_height(void) { return PANEL_HEIGHT; }
+
+static void check_window_filled(void) {
+  if (window_open && (cur_y != win_y1 + 1u || cur_x != win_x0))
+    fail("window (%u,%u)-(%u,%u) left short at (%u,%u)", win_x0, win_y0,
+         win_x1, win_y1, cur_x, cur_y);
+}
+
+void display_set_window(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1) {
+  if (bulk)
+    fail("window changed during a bulk transfer");
+  if (x1 < x0 || y1 < y0 || x0 < clip_x || y0 < clip_y ||
+      x1 >= clip_x + clip_w || y1 >= clip_y + clip_h)
+    fail("window (%u,%u)-(%u,%u) outside the clip", x0, y0, x1, y1);
+  check_window_filled();
+  win_x0 = x0, win_y0 = y0, win_x1 = x1, win_y1 = y1;
+  cur_x = x0, cur_y = y0;
+  window_open = true;
+}
+
+void display_start_bulk(void) { bulk = true; }
+void display_end_bulk(void) { bulk = false; }
+void display_wait_ready(void) {}
+
+static void put(uint16_t v) {
+  if (!window_open || cur_y > win_y1)
+    fail("pixel outside the window");
+  panel[cur_y][cur_x] = v;
+  if (++cur_x > win_x1) {
+    cur_x = win_x0;
+    cur_y++;
+  }
+}
+
+void display_send_buffer(const uint8_t *data, uint32_t len) {
+  if (!bulk)
+    fail("pixels sent outside a bulk transfer");
+  if (wire_format == PIXEL_FORMAT_RGB565) {
+    if (len & 1)
+      fail("odd RGB565 send of %u bytes", len);
+    for (uint32_t i = 0; i < len / 2; i++)
+      put(((const uint16_t *)data)[i]);
+    return;
+  }
+  if (len % 3)
+    fail("RGB444 send of %u bytes splits a pixel pair", len);
+  for (uint32_t i = 0; i < len; i += 3) {
+    put((uint16_t)((data[i] << 4) | (data[i + 1] >> 4)));
+    put((uint16_t)(((data[i + 1] & 0x0F) << 8) | data[i + 2]));
+  }
+}
+
+// --- Playback ---
+static void write_picture(FILE *out, const video_t *v) {
+  for (int y = 0; y < v->height; y++)
+    for (int x = 0; x < v->width; x++) {
+      uint16_t p = panel[clip_y + y][clip_x + x];
+      uint8_t le[2] = {(uint8_t)p, (uint8_t)(p >> 8)};
+      fwrite(le, 1, 2, out);
+    }
+}
+
+int main(int argc, char **argv) {
+  if (argc != 3)
+    fail("usage: video_check clip.bin pictures.raw");
+
+  FILE *in = fopen(argv[1], "rb");
+  if (!in)
+    fail("cannot open %s", argv[1]);
+  fseek(in, 0, SEEK_END);
+  long size = ftell(in);
+  fseek(in, 0, SEEK_SET);
+  uint8_t *clip = aligned_alloc(4, (size + 3) & ~3L);
+  if (!clip || fread(clip, 1, size, in) != (size_t)size)
+    fail("cannot read %s", argv[1]);
+  fclose(in);
+
+  const video_t *v = video_map(clip);
+  if (!v)
+    fail("%s: not a valid clip", argv[1]);
+  wire_format = (display_pixel_format_t)v->format;
+
+  clip_x = v->width + CLIP_X <= PANEL_WIDTH ? CLIP_X : 0;
+  clip_y = v->height + CLIP_Y <= PANEL_HEIGHT ? CLIP_Y : 0;
+  clip_w = v->width;
+  clip_h = v->height;
+  video_player_t player;
+  if (!video_player_init(&player, clip, clip_x, clip_y, false))
+    fail("video_player_init refused the clip");
+
+  FILE *out = fopen(argv[2], "wb");
+  if (!out)
+    fail("cannot create %s", argv[2]);
+  uint32_t start = clock_us;
+  while (video_player_update(&player)) {
+    if (player.ticket) {
+      video_player_wait(&player);
+      check_window_filled();
+      write_picture(out, v);
+    } else {
+      int32_t wait = (int32_t)(player.due_us - clock_us);
+      if (wait > 0)
+        sleep_us((uint32_t)wait);
+    }
+  }
+  fclose(out);
+
+  if (bulk)
+    fail("bulk transfer left open");
+  if (player.stats.frames != v->frame_count)
+    fail("%u of %u frames sent", player.stats.frames, v->frame_count);
+  // Inline jobs never run late, so the frames must keep the clip's period
+  uint32_t elapsed = clock_us - start;
+  if (player.stats.late || elapsed < (v->frame_count - 1) * v->frame_us)
+    fail("paced %u frames in %u us (%u late)", v->frame_count, elapsed,
+         player.stats.late);
+  printf("%u frames, %u windows, %u pixel bytes\n", player.stats.frames,
+         player.stats.windows, player.stats.pixel_bytes);
+  return 0;
+}
@@ -0,0 +1,376 @@
+#!/usr/bin/env python3
+"""Encode PNG frame sequences into MiniBoy video clips (lib/graphics/video.h).
+
+  video_pack.py intro/*.png --fps 30 -f rgb565 -o intro.c
+  video_pack.py cut_*.png --fps 15 -f rgb444 --block 8 --threshold 1 -o cut.bin
+  video_pack.py --generate 120 --size 320x240 -o clip.c
+  video_pack.py --selftest
+
+Frames are taken in the order given. Each one keeps only the blocks that
+differ from the picture the panel holds after the previous frame (frame 0
+keeps them all). With --threshold N a block whose channels all stay within
+N steps of that picture counts as unchanged: lossy, but the error does not
+build up, since blocks are always compared with what the panel shows.
+
+Every clip is decoded again after encoding and checked against the panel
+pictures the encoder tracked. --selftest runs that check over generated
+clips in both wire formats, several block sizes and thresholds, with a
+static frame, a scene cut and sizes that are not block multiples. It also
+builds the device player (lib/graphics/video.c, cimage.c) for the host
+with tools/host/video_check.c ($CC, default cc) and plays every clip
+through it, with full and one-row line bands, into an emulated panel that
+must end up with the same pictures. --generate writes one of those clips
+(for demos/video_player).
+"""
+
+import argparse
+import os
+import re
+import struct
+import subprocess
+import sys
+import tempfile
+
+from asset_pack import FORMATS, read_png, to444, to565, write_c
+from cimage_pack import CHANNELS, decode, encode
+
+VIDEO_MAGIC = 0x3156424D
+HEADER = struct.Struct("<IBBHHHII")
+FRAME = struct.Struct("<HHI")
+RUN = struct.Struct("<BBBB")
+WIRE_FORMATS = ("rgb565", "rgb444")
+RUN_BLOCKS_MAX = 255
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+
+def fields(v, fmt):
+    r_shift, g_shift, r_mask, g_mask, b_mask = CHANNELS[fmt][:5]
+    return (v >> r_shift) & r_mask, (v >> g_shift) & g_mask, v & b_mask
+
+
+def frame_values(rows, fmt):
+    """Flat row-major values; transparent pixels composited onto black."""
+    enc = {"rgb565": to565, "rgb444": to444}[fmt]
+    return [enc(r * a // 255, g * a // 255, b * a // 255)
+            for row in rows for (r, g, b, a) in row]
+
+
+def block_rect(bx, by, blocks, block, width, height):
+    x0, y0 = bx * block, by * block
+    return x0, y0, min(blocks * block, width - x0), min(block, height - y0)
+
+
+def block_changed(src, ref, x0, y0, w, h, width, fmt, threshold):
+    for y in range(y0, y0 + h):
+        a = src[y * width + x0:y * width + x0 + w]
+        b = ref[y * width + x0:y * width + x0 + w]
+        if a == b:
+            continue
+        if threshold == 0:
+            return True
+        for u, v in zip(a, b):
+            if any(abs(p - q) > threshold
+                   for p, q in zip(fields(u, fmt), fields(v, fmt))):
+                return True
+    return False
+
+
+def encode_frame(src, ref, width, height, fmt, block, threshold):
+    """Frame blob; updates `ref` (the panel picture, None: unknown)."""
+    cols, lines = -(-width // block), -(-height // block)
+    runs = []
+    for by in range(lines):
+        bx = 0
+        while bx < cols:
+            x0, y0, w, h = block_rect(bx, by, 1, block, width, height)
+            if ref[0] is not None and not block_changed(
+                    src, ref, x0, y0, w, h, width, fmt, threshold):
+                bx += 1
+                continue
+            if runs and runs[-1][1] == by and \
+                    runs[-1][0] + runs[-1][2] == bx and \
+                    runs[-1][2] < RUN_BLOCKS_MAX:
+                runs[-1][2] += 1
+            else:
+                runs.append([bx, by, 1])
+            bx += 1
+
+    values = []
+    for bx, by, blocks in runs:
+        x0, y0, w, h = block_rect(bx, by, blocks, block, width, height)
+        for y in range(y0, y0 + h):
+            line = src[y * width + x0:y * width + x0 + w]
+            ref[y * width + x0:y * width + x0 + w] = line
+            values += line
+    ops = encode(values, fmt)
+    blob = FRAME.pack(len(runs), 0, len(ops))
+    blob += b"".join(RUN.pack(bx, by, n, 0) for bx, by, n in runs) + ops
+    return blob + bytes(-len(ops) % 4), len(runs)
+
+
+def pack(frames, width, height, fmt, block, frame_us, threshold):
+    """Return (clip blob, panel picture after each frame, runs per frame)."""
+    if block < 2 or block & 1:
+        raise ValueError("the block size must be even")
+    if -(-width // block) > 256 or -(-height // block) > 256:
+        raise ValueError("more than 256 blocks across; use larger blocks")
+    if fmt == "rgb444" and width & 1:
+        raise ValueError("RGB444 clips need an even width")
+    if not 0 < len(frames) <= 0xFFFF:
+        raise ValueError("1 to 65535 frames")
+
+    ref = [None] * (width * height)
+    data, shown, runs = bytearray(), [], []
+    for src in frames:
+        blob, n = encode_frame(src, ref, width, height, fmt, block,
+                               threshold)
+        data += blob
+        shown.append(list(ref))
+        runs.append(n)
+    header = HEADER.pack(VIDEO_MAGIC, FORMATS[fmt], block, width, height,
+                         len(frames), frame_us, len(data))
+    return header + bytes(data), shown, runs
+
+
+def unpack(blob):
+    """Panel picture after each frame, decoded the way video.c does."""
+    magic, fmt_id, block, width, height, count, _, size = \
+        HEADER.unpack_from(blob)
+    if magic != VIDEO_MAGIC:
+        raise ValueError("not a video clip")
+    fmt = {FORMATS[f]: f for f in WIRE_FORMATS}[fmt_id]
+    if HEADER.size + size != len(blob):
+        raise ValueError("data size does not match the header")
+
+    panel = [None] * (width * height)
+    pos, shown = HEADER.size, []
+    for _ in range(count):
+        run_count, _, ops_len = FRAME.unpack_from(blob, pos)
+        pos += FRAME.size
+        runs = [RUN.unpack_from(blob, pos + i * RUN.size)
+                for i in range(run_count)]
+        pos += run_count * RUN.size
+        rects = [block_rect(bx, by, n, block, width, height)
+                 for bx, by, n, _ in runs]
+        values = decode(blob[pos:pos + ops_len],
+                        sum(w * h for _, _, w, h in rects), fmt)
+        pos += ops_len + (-ops_len % 4)
+        k = 0
+        for x0, y0, w, h in rects:
+            if x0 >= width or y0 >= height:
+                raise ValueError("run outside the picture")
+            for y in range(y0, y0 + h):
+                panel[y * width + x0:y * width + x0 + w] = values[k:k + w]
+                k += w
+        if None in panel:
+            raise ValueError("frame 0 does not cover the picture")
+        shown.append(list(panel))
+    return shown
+
+
+def verify(blob, shown):
+    decoded = unpack(blob)
+    for i, (a, b) in enumerate(zip(decoded, shown)):
+        if a != b:
+            raise ValueError(f"frame {i} decodes differently")
+    if len(decoded) != len(shown):
+        raise ValueError("frame count differs")
+
+
+# --- Generated clips ---
+def generate(count, width, height, fmt, seed=1):
+    """Gradient, moving box, flickering noise patch, a still and a cut."""
+    enc = {"rgb565": to565, "rgb444": to444}[fmt]
+    state = seed
+
+    def rand():
+        nonlocal state
+        state = (state * 1103515245 + 12345) & 0x7FFFFFFF
+        return state >> 8
+
+    frames = []
+    for i in range(count):
+        cut = i >= count // 2
+        f = [enc((x * 255 // width) ^ (255 if cut else 0),
+                 y * 255 // height, 128) for y in range(height)
+             for x in range(width)]
+        size = max(4, min(width, height) // 4)
+        bx = (i * 3) % max(1, width - size)
+        by = (i * 2) % max(1, height - size)
+        for y in range(by, by + size):
+            f[y * width + bx:y * width + bx + size] = \
+                [enc(255, 220, 40)] * size
+        if i % 4 == 0:
+            noise = [rand() & 0xFFFF for _ in range(width * height // 64)]
+        pw = max(1, width // 8)
+        for k, v in enumerate(noise):
+            y, x = divmod(k, pw)
+            if y < height:
+                f[y * width + x] = enc(v & 0xFF, v >> 8, 0)
+        if i == 1 and count > 2:
+            f = frames[0]  # A still: no runs
+        frames.append(f)
+    return frames
+
+
+# --- Host build of the device player ---
+def build_player(tmp, band_bytes=None):
+    """Compile tools/host/video_check.c with the library's player."""
+    exe = os.path.join(tmp, f"video_check{band_bytes or ''}")
+    cmd = [os.environ.get("CC", "cc"), "-std=c11", "-O1", "-Wall",
+           "-I", os.path.join(ROOT, "tools", "host")]
+    for lib in ("graphics", "display", "memory", "system_config"):
+        cmd += ["-I", os.path.join(ROOT, "lib", lib)]
+    if band_bytes:
+        cmd.append(f"-DVIDEO_BAND_BYTES={band_bytes}")
+    cmd += [os.path.join(ROOT, "tools", "host", "video_check.c"),
+            os.path.join(ROOT, "lib", "graphics", "video.c"),
+            os.path.join(ROOT, "lib", "graphics", "cimage.c"), "-o", exe]
+    try:
+        subprocess.run(cmd, check=True)
+    except (OSError, subprocess.CalledProcessError) as e:
+        raise ValueError(f"host build of the player failed: {e}")
+    return exe
+
+
+def play(exe, blob, width, height, tmp):
+    """Panel picture after each frame, as the C player leaves it."""
+    clip, raw = os.path.join(tmp, "clip.bin"), os.path.join(tmp, "clip.raw")
+    with open(clip, "wb") as f:
+        f.write(blob)
+    run = subprocess.run([exe, clip, raw], capture_output=True, text=True)
+    if run.returncode:
+        raise ValueError(run.stderr.strip() or "video_check failed")
+    with open(raw, "rb") as f:
+        data = f.read()
+    n = width * height
+    values = struct.unpack(f"<{len(data) // 2}H", data)
+    return [list(values[i:i + n]) for i in range(0, len(values), n)]
+
+
+def selftest():
+    with tempfile.TemporaryDirectory() as tmp:
+        # Default bands, and bands of one 70-pixel RGB565 row
+        players = [build_player(tmp), build_player(tmp, 160)]
+        clips = selftest_clips(players, tmp)
+    print(f"selftest: {clips} clips decode correctly in Python and through "
+          f"the C player")
+
+
+def check_player(players, blob, shown, width, height, tmp, what):
+    for exe in players:
+        pictures = play(exe, blob, width, height, tmp)
+        if len(pictures) != len(shown):
+            raise ValueError(f"{what}: C player sent {len(pictures)} of "
+                             f"{len(shown)} frames")
+        for i, (a, b) in enumerate(zip(pictures, shown)):
+            if a != b:
+                raise ValueError(f"{what}: frame {i} differs in the C player "
+                                 f"({os.path.basename(exe)})")
+
+
+def selftest_clips(players, tmp):
+    clips = 0
+    for fmt in WIRE_FORMATS:
+        for width, height in ((64, 48), (70, 38)):
+            for block in (4, 8, 16):
+                for threshold in (0, 2):
+                    what = f"{fmt} {width}x{height} block {block} " \
+                           f"threshold {threshold}"
+                    frames = generate(8, width, height, fmt, seed=block)
+                    blob, shown, runs = pack(frames, width, height, fmt,
+                                             block, 33333, threshold)
+                    verify(blob, shown)
+                    check_player(players, blob, shown, width, height, tmp,
+                                 what)
+                    if threshold == 0 and shown != frames:
+                        raise ValueError(f"{fmt} {width}x{height} block "
+                                         f"{block}: lossless clip differs")
+                    for src, out in zip(frames, shown):
+                        for u, v in zip(src, out):
+                            if any(abs(p - q) > threshold for p, q in
+                                   zip(fields(u, fmt), fields(v, fmt))):
+                                raise ValueError("error above threshold")
+                    if runs[1] != 0:
+                        raise ValueError("a still frame sent blocks")
+                    clips += 1
+
+    # Full screen, like demos/video_player
+    frames = generate(24, 320, 240, "rgb565")
+    blob, shown, _ = pack(frames, 320, 240, "rgb565", 16, 33333, 0)
+    verify(blob, shown)
+    check_player(players[:1], blob, shown, 320, 240, tmp, "rgb565 320x240")
+    return clips + 1
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("inputs", nargs="*", help="PNG frames, in order")
+    ap.add_argument("-o", "--output",
+                    help=".c for a C array, anything else for a raw blob")
+    ap.add_argument("-f", "--format", choices=WIRE_FORMATS, default="rgb565",
+                    help="the panel's wire format")
+    ap.add_argument("--fps", type=float, default=30.0,
+                    help="source frame rate")
+    ap.add_argument("--block", type=int, default=16,
+                    help="block edge in pixels (even)")
+    ap.add_argument("--threshold", type=int, default=0,
+                    help="largest channel change treated as no change")
+    ap.add_argument("--generate", metavar="FRAMES", type=int,
+                    help="encode a generated clip instead of PNGs")
+    ap.add_argument("--size", metavar="WxH", default="320x240",
+                    help="size of the generated clip")
+    ap.add_argument("--selftest", action="store_true",
+                    help="check encode/decode round trips and exit")
+    ap.add_argument("--name", help="C symbol (default: file name)")
+    args = ap.parse_args()
+
+    if args.selftest:
+        try:
+            selftest()
+        except ValueError as e:
+            sys.exit(f"selftest: {e}")
+        return
+    if not args.output:
+        ap.error("-o is required")
+
+    if args.generate:
+        width, height = (int(v) for v in args.size.lower().split("x"))
+        frames = generate(args.generate, width, height, args.format)
+        source = f"{args.generate} generated frames"
+    else:
+        if not args.inputs:
+            ap.error("no input frames")
+        frames = []
+        for path in args.inputs:
+            w, h, rows = read_png(path)
+            if frames and (w, h) != (width, height):
+                sys.exit(f"{path}: {w}x{h}, expected {width}x{height}")
+            width, height = w, h
+            frames.append(frame_values(rows, args.format))
+        source = args.inputs[0]
+
+    try:
+        blob, shown, runs = pack(frames, width, height, args.format,
+                                 args.block, round(1e6 / args.fps),
+                                 args.threshold)
+        verify(blob, shown)
+    except ValueError as e:
+        sys.exit(f"{args.output}: {e}")
+
+    if args.output.endswith(".c"):
+        name = args.name or re.sub(r"\W", "_", os.path.splitext(
+            os.path.basename(args.output))[0])
+        write_c(args.output, name, blob, source)
+    else:
+        with open(args.output, "wb") as f:
+            f.write(blob)
+    raw = width * height * (2 if args.format == "rgb565" else 1.5)
+    print(f"{args.output}: {len(frames)} frames of {width}x{height}, "
+          f"{len(blob)} bytes ({len(blob) / len(frames) / 1024:.1f} KB/frame,"
+          f" {100 * len(blob) / (raw * len(frames)):.1f}% of raw), "
+          f"{sum(runs) / len(frames):.1f} windows/frame, verified")
+
+
+if __name__ == "__main__":
+    main()